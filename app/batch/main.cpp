@@ -0,0 +1,538 @@
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cerrno>
+#include <cstdlib>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <opencv2/opencv.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <io/image_reader.hpp>
+#include <io/work_queue.hpp>
+#include <io/result_writer.hpp>
+#include <io/detection_log.hpp>
+#include <utils/bounded_queue.hpp>
+#include <models/detection/factory.hpp>
+#include <models/segmentation/factory.hpp>
+#include <models/classification/classifier.hpp>
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> running{true};
+
+void signalHandler([[maybe_unused]] int signum)
+{
+    running = false;
+}
+
+namespace
+{
+    const std::vector<std::string> TASKS = {"detect", "segment", "classify"};
+
+    struct Model
+    {
+        std::function<std::vector<std::vector<Detection>>(const std::vector<cv::Mat> &)> process;
+        cv::Size inputSize{}; // empty when images are decoded at full resolution
+    };
+
+    struct WorkerOptions
+    {
+        std::string task{};
+        std::string configPath{};
+        io::ResultFormat format = io::ResultFormat::JSONL;
+        size_t batchSize = 1;
+        size_t decodeThreads = 0;
+        size_t prefetch = 4;
+    };
+
+    // Decoded images of a chunk, at most one engine batch
+    struct Batch
+    {
+        size_t chunk = 0;
+        bool last = false; // last batch of its chunk
+        std::vector<int64_t> indices{};
+        std::vector<cv::Mat> images{};
+        Clock::time_point start{};
+        double decodeMs = 0.0;
+    };
+
+    std::string getConfigSection(const std::string &task)
+    {
+        return task == "detect" ? "detector" : task == "segment" ? "segmenter"
+                                                                 : "classifier";
+    }
+
+    std::string getExtension(io::ResultFormat format)
+    {
+        switch (format)
+        {
+        case io::ResultFormat::BINARY:
+            return "bin";
+        case io::ResultFormat::COLUMNAR:
+            return "trvl";
+        default:
+            return "jsonl";
+        }
+    }
+
+    // File header written once per result file, skipped when chunk results are merged
+    size_t getHeaderSize(io::ResultFormat format)
+    {
+        switch (format)
+        {
+        case io::ResultFormat::BINARY:
+            return sizeof(io::BinaryResultWriter::MAGIC) + sizeof(io::BinaryResultWriter::VERSION);
+        case io::ResultFormat::COLUMNAR:
+            return sizeof(io::log::FileHeader);
+        default:
+            return 0;
+        }
+    }
+
+    Model createModel(const std::string &task, const std::string &configPath)
+    {
+        if (task == "classify")
+        {
+            std::ifstream file(configPath);
+            auto data = nlohmann::json::parse(file);
+            auto config = cls::ClassifierConfig::load(configPath, data.contains("classifier") ? "classifier" : "");
+            auto classifier = std::make_shared<cls::SingleLabelClassifier>(config);
+            return {[classifier](const std::vector<cv::Mat> &images)
+                    {
+                        std::vector<std::vector<Detection>> results;
+                        for (auto &det : classifier->process(images))
+                            results.push_back({std::move(det)});
+                        return results;
+                    },
+                    classifier->getInputSize()};
+        }
+
+        std::shared_ptr<trt::DetectionProcessor> detector = task == "segment" ? seg::SegmenterFactory::create(configPath)
+                                                                              : det::DetectorFactory::create(configPath);
+
+        // Remote models have no local input and cascades classify crops of the full image, both get full resolution images
+        cv::Size inputSize;
+        if (auto *yolo = dynamic_cast<det::Yolo *>(detector.get()))
+            inputSize = yolo->getInputSize();
+        else if (auto *yolo = dynamic_cast<seg::Yolo *>(detector.get()))
+            inputSize = yolo->getInputSize();
+
+        return {[detector](const std::vector<cv::Mat> &images)
+                { return detector->process(images); },
+                inputSize};
+    }
+
+    nlohmann::json getPercentiles(std::vector<double> values)
+    {
+        if (values.empty())
+            return nullptr;
+
+        std::sort(values.begin(), values.end());
+        auto percentile = [&values](double p)
+        { return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))]; };
+        return {{"p50", percentile(0.5)}, {"p90", percentile(0.9)}, {"p99", percentile(0.99)}, {"max", values.back()}};
+    }
+
+    double getElapsedMs(Clock::time_point start, Clock::time_point end = Clock::now())
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Claim chunks until the queue is exhausted: images are decoded on a thread pool while
+    // the previous batches run through the engine, results of a chunk are checkpointed together
+    nlohmann::json runWorker(io::FileWorkQueue &queue, const std::vector<std::string> &paths, const WorkerOptions &options)
+    {
+        const auto startTime = Clock::now();
+        Model model = createModel(options.task, options.configPath);
+        const std::string extension = getExtension(options.format);
+
+        trt::BoundedQueue<Batch> batches(options.prefetch);
+        std::atomic<uint64_t> failed{0};
+
+        // Decode: unreadable images are skipped and replaced by the next ones, so that batches stay full
+        auto decode = [&]()
+        {
+            while (running)
+            {
+                auto chunk = queue.claim();
+                if (!chunk)
+                    break;
+
+                auto [next, end] = queue.getRange(*chunk);
+                bool pushed = true;
+                while (running && pushed && next < end)
+                {
+                    Batch batch;
+                    batch.chunk = *chunk;
+                    batch.start = Clock::now();
+                    while (batch.images.size() < options.batchSize && next < end)
+                    {
+                        const size_t count = std::min(options.batchSize - batch.images.size(), end - next);
+                        std::vector<std::string> batchPaths(paths.begin() + next, paths.begin() + next + count);
+                        auto images = io::decodeImages(io::readFiles(batchPaths, options.decodeThreads), options.decodeThreads, model.inputSize);
+                        for (size_t i = 0; i < count; ++i)
+                        {
+                            if (images[i].empty())
+                            {
+                                ++failed;
+                                std::cerr << "Warning: Could not load image " << batchPaths[i] << std::endl;
+                                continue;
+                            }
+                            batch.indices.push_back(static_cast<int64_t>(next + i));
+                            batch.images.push_back(std::move(images[i]));
+                        }
+                        next += count;
+                    }
+                    batch.last = next == end;
+                    batch.decodeMs = getElapsedMs(batch.start);
+                    pushed = batches.push(std::move(batch));
+                }
+
+                // Interrupted, the chunk is left to another worker or to the next run
+                if (next < end || !pushed)
+                {
+                    queue.release(*chunk);
+                    break;
+                }
+            }
+        };
+
+        std::exception_ptr decodeError = nullptr;
+        std::thread decoder([&]()
+                            {
+                                try
+                                {
+                                    decode();
+                                }
+                                catch (...)
+                                {
+                                    decodeError = std::current_exception();
+                                }
+                                batches.close(); });
+
+        std::vector<double> decodeMs, inferenceMs, latencyMs;
+        uint64_t numImages = 0;
+        uint64_t numChunks = 0;
+        std::unique_ptr<io::AsyncResultWriter> writer = nullptr;
+        std::string tmpPath;
+        try
+        {
+            while (auto batch = batches.pop())
+            {
+                if (!writer)
+                {
+                    tmpPath = queue.getPath(batch->chunk, extension) + "." + std::to_string(::getpid()) + ".tmp";
+                    writer = std::make_unique<io::AsyncResultWriter>(tmpPath, options.format);
+                }
+
+                if (!batch->images.empty())
+                {
+                    const auto inferenceStart = Clock::now();
+                    auto results = model.process(batch->images);
+                    inferenceMs.push_back(getElapsedMs(inferenceStart));
+                    decodeMs.push_back(batch->decodeMs);
+                    latencyMs.push_back(getElapsedMs(batch->start));
+
+                    for (size_t i = 0; i < results.size(); ++i)
+                        writer->write({batch->indices[i], 0.0, std::move(results[i])});
+                    numImages += batch->images.size();
+                }
+
+                // Checkpoint: results are renamed into place before the chunk is marked done
+                if (batch->last)
+                {
+                    writer->close();
+                    writer.reset();
+                    fs::rename(tmpPath, queue.getPath(batch->chunk, extension));
+                    queue.complete(batch->chunk);
+                    ++numChunks;
+                }
+            }
+        }
+        catch (...)
+        {
+            running = false;
+            batches.close();
+            decoder.join();
+            throw;
+        }
+        decoder.join();
+        if (decodeError)
+            std::rethrow_exception(decodeError);
+
+        // Results of an interrupted chunk are dropped, the chunk is processed again on resume
+        if (writer)
+        {
+            writer->close();
+            fs::remove(tmpPath);
+        }
+
+        const double elapsed = getElapsedMs(startTime) / 1000.0;
+        return {
+            {"pid", ::getpid()},
+            {"chunks", numChunks},
+            {"images", numImages},
+            {"failed", failed.load()},
+            {"elapsed_s", elapsed},
+            {"images_per_second", elapsed > 0.0 ? numImages / elapsed : 0.0},
+            {"decode_ms", getPercentiles(decodeMs)},
+            {"inference_ms", getPercentiles(inferenceMs)},
+            {"latency_ms", getPercentiles(latencyMs)},
+        };
+    }
+
+    size_t getCompletedItems(const io::FileWorkQueue &queue)
+    {
+        size_t items = 0;
+        for (size_t chunk = 0; chunk < queue.getNumChunks(); ++chunk)
+        {
+            if (queue.isCompleted(chunk))
+            {
+                auto [begin, end] = queue.getRange(chunk);
+                items += end - begin;
+            }
+        }
+        return items;
+    }
+
+    // Concatenate chunk results in item order, every chunk but the first without its file header
+    void mergeResults(const io::FileWorkQueue &queue, io::ResultFormat format, const std::string &outputPath)
+    {
+        const std::string tmpPath = outputPath + "." + std::to_string(::getpid()) + ".tmp";
+        std::ofstream output(tmpPath, std::ios::binary);
+        if (!output.is_open())
+            throw std::runtime_error("Could not create result file " + outputPath);
+
+        for (size_t chunk = 0; chunk < queue.getNumChunks(); ++chunk)
+        {
+            const std::string chunkPath = queue.getPath(chunk, getExtension(format));
+            std::ifstream input(chunkPath, std::ios::binary);
+            if (!input.is_open())
+                throw std::runtime_error("Missing chunk results " + chunkPath);
+
+            if (chunk > 0)
+                input.seekg(static_cast<std::streamoff>(getHeaderSize(format)));
+            if (input.peek() != std::ifstream::traits_type::eof())
+                output << input.rdbuf();
+        }
+
+        output.close();
+        if (!output)
+            throw std::runtime_error("Could not write result file " + outputPath);
+        fs::rename(tmpPath, outputPath);
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    po::options_description options("Program options");
+    options.add_options()("help,h", "Show help message");
+    options.add_options()("input,i", po::value<std::string>()->required(), "Image directory or list file (.txt, .lst) with one path per line");
+    options.add_options()("config,c", po::value<std::string>()->required(), "Path to model config.json");
+    options.add_options()("task,t", po::value<std::string>(), "Model to run (detect, segment, classify), detected from the config by default");
+    options.add_options()("work-dir,w", po::value<std::string>()->required(), "Work directory holding chunk results and progress, reused to resume");
+    options.add_options()("output,o", po::value<std::string>(), "Merged results file, written once every chunk is done");
+    options.add_options()("format,f", po::value<std::string>()->default_value("json"), "Results format (json, binary, columnar)");
+    options.add_options()("batch,b", po::value<int>()->default_value(0), "Images per engine batch, the engine batch size by default");
+    options.add_options()("chunk", po::value<int>()->default_value(1024), "Images per work chunk, rounded up to a whole number of batches");
+    options.add_options()("workers", po::value<int>()->default_value(1), "Worker processes on this host");
+    options.add_options()("devices", po::value<std::string>(), "Comma-separated GPU indices assigned to workers in turn (e.g. 0,1)");
+    options.add_options()("threads", po::value<int>()->default_value(0), "Decode threads per worker (0: all cores)");
+    options.add_options()("prefetch", po::value<int>()->default_value(4), "Decoded batches buffered ahead of the engine");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << options << "\n";
+        return 1;
+    }
+
+    po::notify(vm);
+
+    WorkerOptions workerOptions;
+    workerOptions.configPath = vm["config"].as<std::string>();
+    workerOptions.decodeThreads = static_cast<size_t>(std::max(0, vm["threads"].as<int>()));
+    workerOptions.prefetch = static_cast<size_t>(std::max(1, vm["prefetch"].as<int>()));
+
+    workerOptions.format = io::getResultFormat(vm["format"].as<std::string>());
+    if (workerOptions.format == io::ResultFormat::UNKNOWN)
+    {
+        std::cerr << "Error: Unknown result format " << vm["format"].as<std::string>() << std::endl;
+        return 1;
+    }
+
+    // Config
+    std::ifstream file(workerOptions.configPath);
+    auto config = nlohmann::json::parse(file);
+    if (vm.count("task"))
+    {
+        workerOptions.task = vm["task"].as<std::string>();
+    }
+    else
+    {
+        workerOptions.task = config.contains("detector") ? "detect" : config.contains("segmenter") ? "segment"
+                                                                                                   : "classify";
+    }
+    if (std::find(TASKS.begin(), TASKS.end(), workerOptions.task) == TASKS.end())
+    {
+        std::cerr << "Error: Unknown task " << workerOptions.task << std::endl;
+        return 1;
+    }
+
+    // Full engine batches, the model itself is only loaded by workers
+    int batchSize = vm["batch"].as<int>();
+    if (batchSize <= 0)
+    {
+        const auto section = getConfigSection(workerOptions.task);
+        const auto &data = config.contains(section) ? config[section] : config;
+        trt::EngineConfig engine;
+        if (data.contains("engine"))
+            engine.loadFromJson(data["engine"]);
+        batchSize = engine.batchSize;
+    }
+    workerOptions.batchSize = static_cast<size_t>(std::max(1, batchSize));
+    const size_t chunkSize = (static_cast<size_t>(std::max(1, vm["chunk"].as<int>())) + workerOptions.batchSize - 1) /
+                             workerOptions.batchSize * workerOptions.batchSize;
+
+    // Input
+    std::vector<std::string> paths;
+    try
+    {
+        paths = io::listImages(vm["input"].as<std::string>());
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (paths.empty())
+    {
+        std::cerr << "Error: No images in " << vm["input"].as<std::string>() << std::endl;
+        return 1;
+    }
+
+    // Work queue, shared with any other worker using the same directory
+    std::unique_ptr<io::FileWorkQueue> queue;
+    try
+    {
+        queue = std::make_unique<io::FileWorkQueue>(vm["work-dir"].as<std::string>(), paths, chunkSize);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> devices;
+    if (vm.count("devices"))
+    {
+        std::stringstream stream(vm["devices"].as<std::string>());
+        for (std::string device; std::getline(stream, device, ',');)
+        {
+            if (!device.empty())
+                devices.push_back(device);
+        }
+    }
+
+    const size_t completedItems = getCompletedItems(*queue);
+    const auto startTime = Clock::now();
+    signal(SIGINT, signalHandler);
+
+    // Workers are forked before any model is loaded, each one gets its own device and engine
+    const int numWorkers = std::max(1, vm["workers"].as<int>());
+    int failedWorkers = 0;
+    auto work = [&](int worker)
+    {
+        if (!devices.empty())
+            setenv("CUDA_VISIBLE_DEVICES", devices[worker % devices.size()].c_str(), 1);
+
+        try
+        {
+            auto report = runWorker(*queue, paths, workerOptions);
+            report["worker"] = worker;
+            std::cout << report.dump() << std::endl;
+            return 0;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: Worker " << worker << ": " << e.what() << std::endl;
+            return 1;
+        }
+    };
+
+    if (numWorkers == 1)
+    {
+        failedWorkers = work(0);
+    }
+    else
+    {
+        std::vector<pid_t> children;
+        for (int worker = 0; worker < numWorkers; ++worker)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                std::_Exit(work(worker));
+            }
+            if (pid < 0)
+            {
+                std::cerr << "Error: Could not start worker " << worker << std::endl;
+                ++failedWorkers;
+                continue;
+            }
+            children.push_back(pid);
+        }
+
+        for (pid_t pid : children)
+        {
+            int status = 0;
+            while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+            {
+            }
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                ++failedWorkers;
+        }
+    }
+
+    // Summary over every worker of this run
+    const size_t completedChunks = queue->getNumCompleted();
+    const size_t items = getCompletedItems(*queue) - completedItems;
+    const double elapsed = getElapsedMs(startTime) / 1000.0;
+    nlohmann::json summary = {
+        {"chunks", queue->getNumChunks()},
+        {"completed", completedChunks},
+        {"images", items},
+        {"elapsed_s", elapsed},
+        {"images_per_second", elapsed > 0.0 ? items / elapsed : 0.0},
+    };
+    std::cout << summary.dump() << std::endl;
+
+    if (completedChunks < queue->getNumChunks())
+    {
+        std::cerr << queue->getNumChunks() - completedChunks << " chunks left, run again with the same work directory to resume" << std::endl;
+    }
+    else if (vm.count("output"))
+    {
+        try
+        {
+            mergeResults(*queue, workerOptions.format, vm["output"].as<std::string>());
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    return failedWorkers > 0 ? 1 : 0;
+}
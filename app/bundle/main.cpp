@@ -0,0 +1,71 @@
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <boost/program_options.hpp>
+#include <engine/bundle.hpp>
+
+namespace po = boost::program_options;
+
+int main(int argc, char *argv[])
+{
+    po::options_description options("Program options");
+    options.add_options()("help,h", "Show help message");
+    options.add_options()("config,c", po::value<std::string>()->required(), "Path to model config.json");
+    options.add_options()("task,t", po::value<std::string>(), "Config section of the model (detector, segmenter, classifier, reid), for configs with several tasks");
+    options.add_options()("output,o", po::value<std::string>()->required(), "Output bundle file");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << options << "\n";
+        return 1;
+    }
+
+    po::notify(vm);
+
+    // Config
+    std::string configPath = vm["config"].as<std::string>();
+    std::ifstream file(configPath);
+    if (!file.is_open())
+    {
+        std::cerr << "Error: Could not open config file " << configPath << std::endl;
+        return 1;
+    }
+    auto config = nlohmann::json::parse(file);
+
+    // The bundle keeps the section under its task name, single task configs under "model"
+    std::string task = vm.count("task") ? vm["task"].as<std::string>() : "";
+    nlohmann::json section = config;
+    if (!task.empty())
+    {
+        if (!config.contains(task))
+        {
+            std::cerr << "Error: Config file does not contain task: " << task << std::endl;
+            return 1;
+        }
+        section = config[task];
+    }
+
+    if (!section.contains("engine") || !section["engine"].contains("model_path"))
+    {
+        std::cerr << "Error: Config has no engine model path" << std::endl;
+        return 1;
+    }
+    const std::string enginePath = section["engine"]["model_path"].get<std::string>();
+    section["engine"].erase("model_path");
+
+    try
+    {
+        trt::ModelBundle::write(vm["output"].as<std::string>(), nlohmann::json{{task.empty() ? "model" : task, section}}, enginePath);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Bundled " << enginePath << " into " << vm["output"].as<std::string>() << std::endl;
+    return 0;
+}
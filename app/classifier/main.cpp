@@ -3,6 +3,7 @@
 #include <opencv2/opencv.hpp>
 #include <boost/program_options.hpp>
 #include <types/detection.hpp>
+#include <io/image_reader.hpp>
 #include <models/classification/classifier.hpp>
 
 namespace po = boost::program_options;
@@ -27,21 +28,21 @@ int main(int argc, char *argv[])
 
     po::notify(vm);
 
-    // Input
+    // Config
+    std::string configPath = vm["config"].as<std::string>();
+    auto config = cls::ClassifierConfig::load(configPath);
+    cls::SingleLabelClassifier classifier(config);
+
+    // Input, decoded at the lowest resolution that still covers the model input
     std::string imagePath = vm["input"].as<std::string>();
-    cv::Mat image = cv::imread(imagePath, cv::IMREAD_COLOR);
+    cv::Mat image = io::readImage(imagePath, classifier.getInputSize());
     if (image.empty())
     {
         std::cerr << "Error: Could not load image " << imagePath << std::endl;
         return 1;
     }
 
-    // Config
-    std::string configPath = vm["config"].as<std::string>();
-    auto config = cls::ClassifierConfig::load(configPath);
-
     // Process image
-    cls::SingleLabelClassifier classifier(config);
     Detection det = classifier.process(image);
 
     // Output
@@ -0,0 +1,139 @@
+#include <chrono>
+#include <string>
+#include <signal.h>
+#include <boost/program_options.hpp>
+
+#include <graph/graph.hpp>
+#include <engine/bundle.hpp>
+#include <engine/engine.hpp>
+#include <metrics/exporter.hpp>
+#include <metrics/trace.hpp>
+#include <tracking/factory.hpp>
+
+namespace po = boost::program_options;
+
+graph::Graph *activeGraph = nullptr;
+
+void signalHandler([[maybe_unused]] int signum)
+{
+    if (activeGraph)
+        activeGraph->stop();
+}
+
+// Tracks from mot.cpp, stateful so it sees frames in order on a single worker
+class TrackerNode : public graph::Node
+{
+public:
+    TrackerNode(const std::string &configPath) : m_tracker(TrackerFactory::create(configPath)) {}
+
+    void process(std::vector<graph::PacketPtr> &packets) override
+    {
+        for (auto &packet : packets)
+            m_tracker->update(packet->detections);
+    }
+
+    bool isOrdered() const override { return true; };
+
+private:
+    decltype(TrackerFactory::create(std::string())) m_tracker;
+};
+
+int main(int argc, char *argv[])
+{
+    po::options_description options("Program options");
+    options.add_options()("help,h", "Show help message");
+    options.add_options()("config,c", po::value<std::string>()->required(), "Path to config.json with a graph section");
+    options.add_options()("input,i", po::value<std::string>(), "Input video file or camera index (0,1,...), overrides the source node input");
+    options.add_options()("stats", po::bool_switch(), "Print per node statistics when done");
+    options.add_options()("trace", po::value<std::string>(), "Output Chrome trace file of the per-frame spans of every node");
+    options.add_options()("trace-seconds", po::value<double>()->default_value(0.0), "Trace for N seconds after each SIGUSR1 instead of the whole run");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << options << "\n";
+        return 1;
+    }
+
+    po::notify(vm);
+
+    // Config
+    graph::GraphContext context;
+    context.configPath = vm["config"].as<std::string>();
+    try
+    {
+        context.config = trt::loadConfig(context.configPath);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    context.preprocessCache = std::make_shared<trt::PreprocessCache>();
+
+    if (vm.count("input") && context.config.contains("graph"))
+    {
+        for (auto &node : context.config["graph"]["nodes"])
+        {
+            if (node.value("type", "") == "source")
+                node["input"] = vm["input"].as<std::string>();
+        }
+    }
+
+    graph::NodeRegistry::instance().add("tracker", [](const graph::NodeConfig &, const graph::GraphContext &context)
+                                        { return std::make_unique<TrackerNode>(context.configPath); });
+
+    try
+    {
+        // Exported from before the models are loaded until the graph is destroyed
+        std::unique_ptr<metrics::Exporter> exporter = nullptr;
+        if (context.config.contains("metrics"))
+        {
+            metrics::ExporterConfig exporterConfig;
+            exporterConfig.loadFromJson(context.config["metrics"]);
+            exporter = std::make_unique<metrics::Exporter>(exporterConfig);
+        }
+
+        // Tracing, of the whole run or of a few seconds on demand
+        std::unique_ptr<metrics::TraceTrigger> traceTrigger = nullptr;
+        const std::string tracePath = vm.count("trace") ? vm["trace"].as<std::string>() : "";
+        const bool traceRun = !tracePath.empty() && vm["trace-seconds"].as<double>() <= 0.0;
+        if (traceRun)
+            metrics::Tracer::instance().start();
+        else if (!tracePath.empty())
+            traceTrigger = std::make_unique<metrics::TraceTrigger>(SIGUSR1, tracePath, vm["trace-seconds"].as<double>());
+
+        const auto loadStart = std::chrono::steady_clock::now();
+        graph::Graph pipeline(context);
+        const double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        activeGraph = &pipeline;
+        signal(SIGINT, signalHandler);
+
+        pipeline.run();
+
+        activeGraph = nullptr;
+        if (traceRun)
+        {
+            metrics::Tracer::instance().stop();
+            if (!metrics::Tracer::instance().dump(tracePath))
+                std::cerr << "Error: Could not write trace " << tracePath << std::endl;
+        }
+        if (vm["stats"].as<bool>())
+        {
+            std::cerr << nlohmann::json{{"startup_ms", startupMs}, {"engines", trt::StartupReport::instance().toJson()}}.dump() << std::endl;
+            std::cerr << pipeline.getStats().dump() << std::endl;
+            std::cerr << "Shared preprocessing: " << context.preprocessCache->getHits() << " hits, "
+                      << context.preprocessCache->getMisses() << " misses" << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        activeGraph = nullptr;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,13 +1,22 @@
 #include <string>
 #include <signal.h>
 #include <atomic>
+#include <chrono>
+#include <future>
 #include <boost/program_options.hpp>
 
 #include <opencv2/opencv.hpp>
 
 #include <types/frame.hpp>
+#include <video/capture.hpp>
+#include <video/segmented.hpp>
+#include <io/result_writer.hpp>
+#include <metrics/allocations.hpp>
+#include <metrics/exporter.hpp>
+#include <metrics/trace.hpp>
 #include <tracking/factory.hpp>
 #include <models/reid/reid.hpp>
+#include <models/reid/track_cache.hpp>
 #include <models/detection/factory.hpp>
 #include <models/segmentation/factory.hpp>
 
@@ -29,6 +38,15 @@ int main(int argc, char *argv[])
     options.add_options()("reid", po::bool_switch(), "Activate ReId");
     options.add_options()("output,o", po::value<std::string>(), "Output video file");
     options.add_options()("display,d", po::bool_switch(), "Display video frames");
+    options.add_options()("live,l", po::bool_switch(), "Live source: only process the latest frame and drop stale ones");
+    options.add_options()("batch,b", po::value<int>()->default_value(1), "Number of frames processed per batch (offline video only)");
+    options.add_options()("segments,s", po::value<int>()->default_value(1), "Number of video segments processed in parallel (offline video only, headless)");
+    options.add_options()("results,r", po::value<std::string>(), "Output file for structured results ('-' for stdout)");
+    options.add_options()("format,f", po::value<std::string>()->default_value("json"), "Structured results format (json, binary, columnar)");
+    options.add_options()("embeddings", po::bool_switch(), "Include ReId embeddings in structured results");
+    options.add_options()("startup-report", po::bool_switch(), "Print the load time of the models to stderr (single stream)");
+    options.add_options()("trace", po::value<std::string>(), "Output Chrome trace file of the per-frame spans of every thread");
+    options.add_options()("trace-seconds", po::value<double>()->default_value(0.0), "Trace for N seconds after each SIGUSR1 instead of the whole run");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, options), vm);
@@ -41,18 +59,18 @@ int main(int argc, char *argv[])
 
     po::notify(vm);
 
+    // Structured results
+    const auto format = io::getResultFormat(vm["format"].as<std::string>());
+    if (format == io::ResultFormat::UNKNOWN)
+    {
+        std::cerr << "Error: Unknown result format " << vm["format"].as<std::string>() << std::endl;
+        return 1;
+    }
+
     // Input
     std::string inputPath = vm["input"].as<std::string>();
     cv::VideoCapture cap;
-    if (inputPath.size() == 1 && std::isdigit(inputPath[0]))
-    {
-        cap.open(std::stoi(inputPath));
-    }
-    else
-    {
-        cap.open(inputPath);
-    }
-    if (!cap.isOpened())
+    if (!video::openSource(cap, inputPath))
     {
         std::cerr << "Error: Could not open video source " << inputPath << std::endl;
         return 1;
@@ -65,26 +83,121 @@ int main(int argc, char *argv[])
     bool reid = vm["reid"].as<bool>() && config.contains("reid");
     bool segment = config.contains("segmenter");
 
-    // Load tracker & model
-    auto tracker = TrackerFactory::create(configPath);
+    // Metrics, exported from before the models are loaded until exit
+    std::unique_ptr<metrics::Exporter> exporter = nullptr;
+    if (config.contains("metrics"))
+    {
+        try
+        {
+            metrics::ExporterConfig exporterConfig;
+            exporterConfig.loadFromJson(config["metrics"]);
+            exporter = std::make_unique<metrics::Exporter>(exporterConfig);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
 
-    std::unique_ptr<reid::ReId> reidModel = nullptr;
-    if (reid)
+    // Tracing, of the whole run or of a few seconds on demand
+    std::unique_ptr<metrics::TraceTrigger> traceTrigger = nullptr;
+    const std::string tracePath = vm.count("trace") ? vm["trace"].as<std::string>() : "";
+    const bool traceRun = !tracePath.empty() && vm["trace-seconds"].as<double>() <= 0.0;
+    if (traceRun)
     {
-        auto reidConfig = reid::ReIdConfig::load(configPath, "reid");
-        reidModel = std::make_unique<reid::ReId>(reidConfig);
+        metrics::Tracer::instance().start();
     }
+    else if (!tracePath.empty())
+    {
+        traceTrigger = std::make_unique<metrics::TraceTrigger>(SIGUSR1, tracePath, vm["trace-seconds"].as<double>());
+    }
+    auto dumpTrace = [&tracePath, traceRun]()
+    {
+        if (!traceRun)
+            return;
+        metrics::Tracer::instance().stop();
+        if (!metrics::Tracer::instance().dump(tracePath))
+            std::cerr << "Error: Could not write trace " << tracePath << std::endl;
+    };
+    metrics::Tracer::setThreadName("main");
+
+    // Load tracker & models concurrently, they are independent
+    const auto loadStart = std::chrono::steady_clock::now();
+    auto trackerLoad = std::async(std::launch::async, [&configPath]()
+                                  { return TrackerFactory::create(configPath); });
+    auto reportStartup = [&vm, &loadStart]()
+    {
+        if (!vm["startup-report"].as<bool>())
+            return;
+        const double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        std::cerr << nlohmann::json{{"startup_ms", startupMs}, {"engines", trt::StartupReport::instance().toJson()}}.dump() << std::endl;
+    };
 
-    std::unique_ptr<trt::DetectionProcessor> detector = nullptr;
-    if (segment)
+    // Parallel segments: detection and ReId run per segment, the tracker consumes the merged
+    // results in frame order so that tracks are stitched across segment boundaries
+    if (vm["segments"].as<int>() > 1)
     {
-        detector = seg::SegmenterFactory::create(configPath);
+        auto tracker = trackerLoad.get();
+        cap.release();
+        video::SegmentedVideoProcessor processor(inputPath, vm["segments"].as<int>(), std::max(1, vm["batch"].as<int>()));
+        io::AsyncResultWriter resultWriter(vm.count("results") ? vm["results"].as<std::string>() : "-", format, vm["embeddings"].as<bool>());
+        signal(SIGINT, signalHandler);
+
+        processor.run(
+            [&configPath, reid, segment](size_t) -> video::BatchProcessor
+            {
+                std::shared_ptr<trt::DetectionProcessor> detector = segment ? seg::SegmenterFactory::create(configPath)
+                                                                            : det::DetectorFactory::create(configPath);
+                std::shared_ptr<reid::ReId> reidModel = reid ? std::make_shared<reid::ReId>(reid::ReIdConfig::load(configPath, "reid"))
+                                                             : nullptr;
+                return [detector, reidModel](const std::vector<cv::Mat> &frames)
+                {
+                    auto batchDetections = detector->process(frames);
+                    if (reidModel)
+                    {
+                        for (size_t i = 0; i < frames.size(); ++i)
+                        {
+                            reidModel->extractFeatures(frames[i], batchDetections[i]);
+                        }
+                    }
+                    return batchDetections;
+                };
+            },
+            [&processor, &resultWriter, &tracker](io::FrameResult &&result)
+            {
+                {
+                    metrics::TraceSpan span("tracker", nullptr, result.frameIndex);
+                    tracker->update(result.detections);
+                }
+                resultWriter.write(std::move(result));
+                if (!running)
+                    processor.stop();
+            });
+        resultWriter.close();
+        dumpTrace();
+        return 0;
     }
-    else
+
+    auto reidLoad = std::async(std::launch::async, [&configPath, reid]() -> std::unique_ptr<reid::ReId>
+                               { return reid ? std::make_unique<reid::ReId>(reid::ReIdConfig::load(configPath, "reid")) : nullptr; });
+    auto detectorLoad = std::async(std::launch::async, [&configPath, segment]()
+                                   { return segment ? seg::SegmenterFactory::create(configPath) : det::DetectorFactory::create(configPath); });
+
+    // Track cache: detections continuing a track reuse its features instead of being re-embedded
+    std::unique_ptr<reid::TrackCache> trackCache = nullptr;
+    if (reid && config["reid"].contains("cache"))
     {
-        detector = det::DetectorFactory::create(configPath);
+        reid::TrackCacheConfig cacheConfig;
+        cacheConfig.loadFromJson(config["reid"]["cache"]);
+        trackCache = std::make_unique<reid::TrackCache>(cacheConfig);
     }
 
+    auto tracker = trackerLoad.get();
+    std::unique_ptr<reid::ReId> reidModel = reidLoad.get();
+    std::unique_ptr<trt::DetectionProcessor> detector = detectorLoad.get();
+    reportStartup();
+
     // Output
     cv::VideoWriter writer;
     if (vm.count("output"))
@@ -102,60 +215,153 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Display
-    bool display = vm["display"].as<bool>() || !vm.count("output");
+    std::unique_ptr<io::AsyncResultWriter> resultWriter = nullptr;
+    if (vm.count("results"))
+    {
+        resultWriter = std::make_unique<io::AsyncResultWriter>(vm["results"].as<std::string>(), format, vm["embeddings"].as<bool>());
+    }
+
+    // Display, frames are only drawn when displayed or recorded
+    bool display = vm["display"].as<bool>() || (!vm.count("output") && !vm.count("results"));
+    bool draw = display || writer.isOpened();
     if (display)
     {
         cv::namedWindow("Multi Object Tracking", cv::WINDOW_AUTOSIZE);
     }
 
-    Frame frame;
+    // Live source
+    std::unique_ptr<video::LatestFrameCapture> liveCapture = nullptr;
+    if (vm["live"].as<bool>())
+    {
+        liveCapture = std::make_unique<video::LatestFrameCapture>(cap);
+    }
+
+    // Live sources are processed frame by frame, offline videos are batched across frames
+    const size_t batchSize = liveCapture ? 1 : static_cast<size_t>(std::max(1, vm["batch"].as<int>()));
+    std::vector<Frame> frames(batchSize);
+    std::vector<double> timestamps(batchSize);
+    int64_t frameIndex = 0;
+    auto readFrame = [&](size_t i)
+    {
+        metrics::TraceSpan span("decode", nullptr, frameIndex + static_cast<int64_t>(i));
+        if (liveCapture)
+        {
+            bool success = liveCapture->read(frames[i].image);
+            timestamps[i] = std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+            return success;
+        }
+        cap >> frames[i];
+        timestamps[i] = cap.get(cv::CAP_PROP_POS_MSEC);
+        return !frames[i].empty();
+    };
+
+    std::vector<cv::Mat> images;
+    images.reserve(batchSize);
     signal(SIGINT, signalHandler);
 
+    auto &batchLatency = metrics::Registry::instance().latency("mot_batch_seconds");
+    auto &framesTotal = metrics::Registry::instance().counter("mot_frames_total");
+    auto &droppedFrames = metrics::Registry::instance().gauge("mot_dropped_frames");
+    const auto batchAllocations = metrics::getAllocationMetrics({{"stage", "mot_batch"}});
+
     while (running)
     {
-        cap >> frame;
-        if (frame.empty())
+        images.clear();
+        while (images.size() < batchSize && readFrame(images.size()))
+        {
+            images.push_back(frames[images.size()].image);
+        }
+        if (images.empty())
             break;
+        if (liveCapture)
+            droppedFrames.set(static_cast<double>(liveCapture->getDroppedFrames()));
 
-        // Detect objects
-        auto detections = detector->process(frame.image);
+        // Detection to tracking and writing of the whole batch
+        metrics::ScopedTimer batchTimer(batchLatency);
+        metrics::AllocationScope allocations(batchAllocations);
 
-        // Extract features for each detection
-        if (reidModel)
+        // Detect objects, spans of the batch are attributed to its first frame
+        metrics::Tracer::setFrame(frameIndex);
+        auto batchDetections = detector->process(images);
+
+        // Consume results in frame order
+        for (size_t i = 0; i < images.size() && running; ++i)
         {
-            for (auto &det : detections)
+            auto &detections = batchDetections[i];
+            metrics::Tracer::setFrame(frameIndex);
+
+            // Extract features for each detection
+            if (trackCache)
             {
-                cv::Mat roi = frame.image(det.bbox);
-                det.features = reidModel->process(roi);
+                reidModel->extractFeatures(frames[i].image, detections, trackCache->lookup(detections));
+            }
+            else if (reidModel)
+            {
+                reidModel->extractFeatures(frames[i].image, detections);
             }
-        }
 
-        // Update tracker
-        tracker->update(detections);
+            // Update tracker
+            {
+                metrics::TraceSpan span("tracker");
+                tracker->update(detections);
+                if (trackCache)
+                    trackCache->update(detections);
+            }
+
+            // Visualize results
+            if (draw)
+            {
+                metrics::TraceSpan span("draw");
+                cv::Mat output = frames[i].draw(detections, true, true);
 
-        // Visualize results
-        cv::Mat output = frame.draw(detections, true, true);
+                if (display)
+                    cv::imshow("Multi Object Tracking", output);
 
-        if (display)
-            cv::imshow("Multi Object Tracking", output);
+                if (writer.isOpened())
+                    writer.write(output);
+            }
+
+            // Structured results
+            if (resultWriter)
+                resultWriter->write({frameIndex, timestamps[i], std::move(detections)});
+            ++frameIndex;
+            framesTotal.add();
 
-        if (writer.isOpened())
-            writer.write(output);
+            if (display && cv::waitKey(1) == 27)
+                running = false;
+        }
 
-        if (cv::waitKey(1) == 27)
-            running = false;
+        // End of stream
+        if (images.size() < batchSize)
+            break;
     }
 
     // Cleanup
+    if (liveCapture)
+    {
+        liveCapture->release();
+        std::cerr << "Live capture: " << liveCapture->getGrabbedFrames() << " frames grabbed, "
+                  << liveCapture->getDroppedFrames() << " stale frames dropped" << std::endl;
+    }
+
+    if (trackCache)
+    {
+        std::cerr << "Track cache: " << trackCache->getHits() << " features reused, "
+                  << trackCache->getMisses() << " extracted" << std::endl;
+    }
+
     if (cap.isOpened())
         cap.release();
 
     if (writer.isOpened())
         writer.release();
 
+    if (resultWriter)
+        resultWriter->close();
+
     if (display)
         cv::destroyAllWindows();
 
+    dumpTrace();
     return 0;
 }
\ No newline at end of file
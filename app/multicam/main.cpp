@@ -0,0 +1,218 @@
+#include <string>
+#include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <opencv2/opencv.hpp>
+
+#include <types/frame.hpp>
+#include <tracking/factory.hpp>
+#include <video/multi_source.hpp>
+#include <models/reid/reid.hpp>
+#include <models/detection/factory.hpp>
+#include <models/segmentation/factory.hpp>
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+std::atomic<bool> running{true};
+
+void signalHandler([[maybe_unused]] int signum)
+{
+    running = false;
+}
+
+void printStats(const video::MultiSourceCapture &sources)
+{
+    const auto stats = sources.getStats();
+    uint64_t total = 0;
+    for (const auto &stat : stats)
+    {
+        total += stat.processed;
+    }
+
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+        double share = total > 0 ? 100.0 * stats[i].processed / total : 0.0;
+        std::cout << "[" << i << "] " << sources.getSource(i)
+                  << std::fixed << std::setprecision(1)
+                  << " fps: " << stats[i].fps
+                  << " processed: " << stats[i].processed
+                  << " dropped: " << stats[i].dropped
+                  << " share: " << share << "%" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    po::options_description options("Program options");
+    options.add_options()("help,h", "Show help message");
+    options.add_options()("input,i", po::value<std::vector<std::string>>()->required()->multitoken(), "Input video files, stream URLs or camera indexes (0,1,...)");
+    options.add_options()("config,c", po::value<std::string>(), "Path to model config.json");
+    options.add_options()("reid", po::bool_switch(), "Activate ReId");
+    options.add_options()("output,o", po::value<std::string>(), "Output directory for per-stream videos");
+    options.add_options()("display,d", po::bool_switch(), "Display video frames");
+    options.add_options()("stats-interval", po::value<int>()->default_value(5), "Seconds between stream statistics reports (0 to disable)");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << options << "\n";
+        return 1;
+    }
+
+    po::notify(vm);
+
+    // Input
+    auto inputPaths = vm["input"].as<std::vector<std::string>>();
+    std::unique_ptr<video::MultiSourceCapture> sources = nullptr;
+    try
+    {
+        sources = std::make_unique<video::MultiSourceCapture>(inputPaths);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Load config
+    std::string configPath = vm["config"].as<std::string>();
+    std::ifstream file(configPath);
+    auto config = nlohmann::json::parse(file);
+    bool reid = vm["reid"].as<bool>() && config.contains("reid");
+    bool segment = config.contains("segmenter");
+    bool track = config.contains("tracker");
+
+    // One tracker per stream, a single model shared by all streams
+    std::vector<decltype(TrackerFactory::create(configPath))> trackers;
+    if (track)
+    {
+        for (size_t i = 0; i < sources->size(); ++i)
+        {
+            trackers.push_back(TrackerFactory::create(configPath));
+        }
+    }
+
+    std::unique_ptr<reid::ReId> reidModel = nullptr;
+    if (reid)
+    {
+        auto reidConfig = reid::ReIdConfig::load(configPath, "reid");
+        reidModel = std::make_unique<reid::ReId>(reidConfig);
+    }
+
+    std::unique_ptr<trt::DetectionProcessor> detector = nullptr;
+    if (segment)
+    {
+        detector = seg::SegmenterFactory::create(configPath);
+    }
+    else
+    {
+        detector = det::DetectorFactory::create(configPath);
+    }
+
+    // Output
+    std::vector<cv::VideoWriter> writers(sources->size());
+    if (vm.count("output"))
+    {
+        fs::path outputDir = vm["output"].as<std::string>();
+        fs::create_directories(outputDir);
+        int fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+        for (size_t i = 0; i < sources->size(); ++i)
+        {
+            std::string outputPath = (outputDir / ("stream_" + std::to_string(i) + ".mp4")).string();
+            writers[i].open(outputPath, fourcc, sources->getFps(i), sources->getFrameSize(i));
+            if (!writers[i].isOpened())
+            {
+                std::cerr << "Error: Could not create output video " << outputPath << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // Display
+    bool display = vm["display"].as<bool>() || !vm.count("output");
+    auto windowName = [](size_t source)
+    { return "Stream " + std::to_string(source); };
+    if (display)
+    {
+        for (size_t i = 0; i < sources->size(); ++i)
+        {
+            cv::namedWindow(windowName(i), cv::WINDOW_AUTOSIZE);
+        }
+    }
+
+    const auto statsInterval = std::chrono::seconds(vm["stats-interval"].as<int>());
+    auto lastStats = std::chrono::steady_clock::now();
+
+    std::vector<video::SourceFrame> batch;
+    std::vector<cv::Mat> images;
+    Frame frame;
+    signal(SIGINT, signalHandler);
+
+    while (running && sources->gather(batch))
+    {
+        // Run the latest frame of every stream through a single engine call
+        images.clear();
+        for (const auto &sourceFrame : batch)
+        {
+            images.push_back(sourceFrame.image);
+        }
+        auto batchDetections = detector->process(images);
+
+        // Route results back to their stream
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            const size_t source = batch[i].source;
+            auto &detections = batchDetections[i];
+            frame.image = batch[i].image;
+
+            if (reidModel)
+            {
+                reidModel->extractFeatures(frame.image, detections);
+            }
+
+            if (track)
+            {
+                trackers[source]->update(detections);
+            }
+
+            cv::Mat output = frame.draw(detections, track, track);
+
+            if (display)
+                cv::imshow(windowName(source), output);
+
+            if (writers[source].isOpened())
+                writers[source].write(output);
+        }
+
+        if (cv::waitKey(1) == 27)
+            running = false;
+
+        if (statsInterval.count() > 0 && std::chrono::steady_clock::now() - lastStats >= statsInterval)
+        {
+            printStats(*sources);
+            lastStats = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Cleanup
+    sources->release();
+    printStats(*sources);
+
+    for (auto &writer : writers)
+    {
+        if (writer.isOpened())
+            writer.release();
+    }
+
+    if (display)
+        cv::destroyAllWindows();
+
+    return 0;
+}
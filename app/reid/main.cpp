@@ -1,18 +1,386 @@
 #include <string>
 #include <fstream>
+#include <chrono>
+#include <numeric>
+#include <signal.h>
+#include <unistd.h>
 #include <opencv2/opencv.hpp>
 #include <boost/program_options.hpp>
-#include <utils/geometry_utils.hpp>
+#include <boost/filesystem.hpp>
+#include <kernels/similarity.hpp>
 #include <models/reid/reid.hpp>
+#include <models/reid/gallery.hpp>
+#include <models/reid/hnsw.hpp>
+#include <models/reid/embedding_cache.hpp>
+#include <models/reid/video_search.hpp>
+#include <models/detection/factory.hpp>
+#include <io/image_reader.hpp>
 
 namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+// Recall and latency of the index against exact search, on random embeddings
+nlohmann::json evaluateIndex(int size, int depth, size_t k, size_t threads)
+{
+    constexpr int DIMS = 512;
+    constexpr int QUERIES = 100;
+    using Clock = std::chrono::steady_clock;
+
+    cv::RNG rng(42);
+    cv::Mat embeddings(size, DIMS, CV_32F);
+    cv::Mat queries(QUERIES, DIMS, CV_32F);
+    rng.fill(embeddings, cv::RNG::NORMAL, 0.f, 1.f);
+    rng.fill(queries, cv::RNG::NORMAL, 0.f, 1.f);
+
+    const auto path = fs::temp_directory_path() / ("reid-evaluate-" + std::to_string(::getpid()) + ".bin");
+    nlohmann::json report;
+    {
+        reid::Gallery gallery(path.string(), DIMS, depth);
+        std::vector<int64_t> ids(size);
+        std::iota(ids.begin(), ids.end(), 0);
+        gallery.add(ids, embeddings);
+
+        reid::HnswIndex index(gallery);
+        auto start = Clock::now();
+        index.update(threads);
+        report["build_seconds"] = std::chrono::duration<double>(Clock::now() - start).count();
+
+        start = Clock::now();
+        auto exact = gallery.search(queries, k, threads);
+        report["exact_ms"] = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / QUERIES;
+
+        report["index"] = nlohmann::json::array();
+        for (size_t ef : {16, 32, 64, 128, 256, 512})
+        {
+            start = Clock::now();
+            auto approx = index.search(queries, k, ef);
+            const double latency = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / QUERIES;
+
+            size_t found = 0;
+            for (int q = 0; q < QUERIES; ++q)
+            {
+                for (const auto &match : approx[q])
+                {
+                    found += std::any_of(exact[q].begin(), exact[q].end(), [&](const reid::GalleryMatch &m)
+                                         { return m.id == match.id; });
+                }
+            }
+            report["index"].push_back({{"ef", ef}, {"recall", static_cast<double>(found) / (k * QUERIES)}, {"ms", latency}});
+        }
+    }
+
+    fs::remove(path);
+    fs::remove(path.string() + ".meta");
+    return report;
+}
+
+// Embeddings of images, one row per image: files are read and decoded in parallel,
+// cache misses are embedded in batches by a model only loaded when needed
+cv::Mat embedImages(const reid::ReIdConfig &config, std::unique_ptr<reid::ReId> &model,
+                    const std::vector<std::string> &paths, reid::EmbeddingCache *cache, size_t threads)
+{
+    constexpr size_t CHUNK_SIZE = 256;
+
+    // Keys depend on the model as well, so that a cache is never reused across models
+    const auto &modelPath = config.engine.modelPath;
+    std::string modelKey = modelPath + ":" + std::to_string(fs::file_size(modelPath)) + ":" +
+                           std::to_string(fs::last_write_time(modelPath));
+    const uint64_t seed = io::hashBytes(modelKey.data(), modelKey.size());
+
+    cv::Mat embeddings;
+    for (size_t begin = 0; begin < paths.size(); begin += CHUNK_SIZE)
+    {
+        const size_t end = std::min(paths.size(), begin + CHUNK_SIZE);
+        auto buffers = io::readFiles(std::vector<std::string>(paths.begin() + begin, paths.begin() + end), threads);
+
+        std::vector<std::vector<float>> features(buffers.size());
+        std::vector<uint64_t> keys(buffers.size());
+        std::vector<std::vector<uint8_t>> missing;
+        std::vector<size_t> missingIndices;
+        for (size_t i = 0; i < buffers.size(); ++i)
+        {
+            if (buffers[i].empty())
+                throw std::runtime_error("Could not load image " + paths[begin + i]);
+
+            keys[i] = io::hashBytes(buffers[i].data(), buffers[i].size(), seed);
+            auto cached = cache ? cache->get(keys[i]) : std::nullopt;
+            if (cached)
+            {
+                features[i] = std::move(*cached);
+            }
+            else
+            {
+                missing.push_back(std::move(buffers[i]));
+                missingIndices.push_back(i);
+            }
+        }
+
+        if (!missing.empty())
+        {
+            if (!model)
+                model = std::make_unique<reid::ReId>(config);
+
+            auto images = io::decodeImages(missing, threads, model->getInputSize());
+            for (size_t i = 0; i < images.size(); ++i)
+            {
+                if (images[i].empty())
+                    throw std::runtime_error("Could not decode image " + paths[begin + missingIndices[i]]);
+            }
+
+            auto extracted = model->process(images);
+            std::vector<uint64_t> missingKeys;
+            cv::Mat missingEmbeddings(static_cast<int>(extracted.size()), static_cast<int>(extracted[0].size()), CV_32F);
+            for (size_t i = 0; i < extracted.size(); ++i)
+            {
+                std::copy(extracted[i].begin(), extracted[i].end(), missingEmbeddings.ptr<float>(static_cast<int>(i)));
+                missingKeys.push_back(keys[missingIndices[i]]);
+                features[missingIndices[i]] = std::move(extracted[i]);
+            }
+            if (cache)
+                cache->put(missingKeys, missingEmbeddings);
+        }
+
+        if (embeddings.empty())
+            embeddings.create(static_cast<int>(paths.size()), static_cast<int>(features[0].size()), CV_32F);
+        for (size_t i = 0; i < features.size(); ++i)
+            std::copy(features[i].begin(), features[i].end(), embeddings.ptr<float>(static_cast<int>(begin + i)));
+    }
+    return embeddings;
+}
+
+// Batch mode: every query against every key, as a similarity matrix or top k matches
+int compareBatch(const po::variables_map &vm)
+{
+    const size_t threads = std::max(0, vm["threads"].as<int>());
+    const bool binary = vm["format"].as<std::string>() == "binary";
+    if (!binary && vm["format"].as<std::string>() != "json")
+    {
+        std::cerr << "Error: Unknown output format " << vm["format"].as<std::string>() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> queryPaths;
+    std::vector<std::string> keyPaths;
+    cv::Mat queries;
+    cv::Mat keys;
+    float threshold = 0.f;
+    try
+    {
+        queryPaths = io::listImages(vm["query"].as<std::string>());
+        keyPaths = io::listImages(vm["key"].as<std::string>());
+        if (queryPaths.empty() || keyPaths.empty())
+        {
+            std::cerr << "Error: No query or key images found" << std::endl;
+            return 1;
+        }
+
+        auto config = reid::ReIdConfig::load(vm["config"].as<std::string>());
+        threshold = config.confidenceThreshold;
+        std::unique_ptr<reid::ReId> model;
+        std::unique_ptr<reid::EmbeddingCache> cache;
+        if (vm.count("cache"))
+            cache = std::make_unique<reid::EmbeddingCache>(vm["cache"].as<std::string>());
+
+        queries = embedImages(config, model, queryPaths, cache.get(), threads);
+        keys = embedImages(config, model, keyPaths, cache.get(), threads);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const bool matrix = vm["matrix"].as<bool>();
+    const size_t top = std::min<size_t>(std::max(1, vm["top"].as<int>()), keyPaths.size());
+    cv::Mat similarities;
+    std::vector<std::vector<kernels::Match>> matches;
+    if (matrix)
+        similarities = kernels::cosine(queries, keys);
+    else
+        matches = kernels::topK(queries, keys, top);
+
+    std::ofstream outFile;
+    if (vm.count("output"))
+    {
+        outFile.open(vm["output"].as<std::string>(), binary ? std::ios::binary : std::ios::out);
+        if (!outFile.is_open())
+        {
+            std::cerr << "Error: Could not create output file " << vm["output"].as<std::string>() << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = outFile.is_open() ? outFile : std::cout;
+
+    if (binary)
+    {
+        // Header: "TRVS", uint32 version, rows, columns, top-k flag, reserved,
+        // then float32 similarities[rows][columns] or {int32 key, float32 similarity}[rows][k]
+        const uint32_t header[5] = {1, static_cast<uint32_t>(queryPaths.size()),
+                                    static_cast<uint32_t>(matrix ? keyPaths.size() : top), matrix ? 0u : 1u, 0};
+        out.write("TRVS", 4);
+        out.write(reinterpret_cast<const char *>(header), sizeof(header));
+        if (matrix)
+        {
+            for (int q = 0; q < similarities.rows; ++q)
+                out.write(reinterpret_cast<const char *>(similarities.ptr<float>(q)), similarities.cols * sizeof(float));
+        }
+        else
+        {
+            for (const auto &queryMatches : matches)
+            {
+                for (size_t i = 0; i < top; ++i)
+                {
+                    const int32_t index = i < queryMatches.size() ? queryMatches[i].index : -1;
+                    const float score = i < queryMatches.size() ? queryMatches[i].score : 0.f;
+                    out.write(reinterpret_cast<const char *>(&index), sizeof(index));
+                    out.write(reinterpret_cast<const char *>(&score), sizeof(score));
+                }
+            }
+        }
+        out.flush();
+        return 0;
+    }
+
+    nlohmann::json data = {{"queries", queryPaths}, {"keys", keyPaths}};
+    if (matrix)
+    {
+        nlohmann::json rows = nlohmann::json::array();
+        for (int q = 0; q < similarities.rows; ++q)
+            rows.push_back(std::vector<float>(similarities.ptr<float>(q), similarities.ptr<float>(q) + similarities.cols));
+        data["similarity"] = rows;
+    }
+    else
+    {
+        nlohmann::json results = nlohmann::json::array();
+        for (const auto &queryMatches : matches)
+        {
+            nlohmann::json queryResults = nlohmann::json::array();
+            for (const auto &match : queryMatches)
+            {
+                queryResults.push_back({
+                    {"key", keyPaths[match.index]},
+                    {"similarity", match.score},
+                    {"match", match.score > threshold},
+                });
+            }
+            results.push_back(queryResults);
+        }
+        data["matches"] = results;
+    }
+
+    nlohmann::json output = {{"status", "success"}, {"data", data}};
+    out << output.dump() << std::endl;
+    return 0;
+}
+
+reid::VideoSearch *activeSearch = nullptr;
+
+void signalHandler([[maybe_unused]] int signum)
+{
+    if (activeSearch)
+        activeSearch->stop();
+}
+
+// Video search mode: stream the detections of a video that match one of the queries
+int searchVideo(const po::variables_map &vm)
+{
+    if (!vm.count("detector"))
+    {
+        std::cerr << "Error: Video search needs a detector config" << std::endl;
+        return 1;
+    }
+
+    std::string videoPath = vm["video"].as<std::string>();
+    cv::VideoCapture capture(videoPath);
+    if (!capture.isOpened())
+    {
+        std::cerr << "Error: Could not open video " << videoPath << std::endl;
+        return 1;
+    }
+
+    std::ofstream outFile;
+    if (vm.count("output"))
+    {
+        outFile.open(vm["output"].as<std::string>());
+        if (!outFile.is_open())
+        {
+            std::cerr << "Error: Could not create output file " << vm["output"].as<std::string>() << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = outFile.is_open() ? outFile : std::cout;
+
+    try
+    {
+        auto config = reid::ReIdConfig::load(vm["config"].as<std::string>());
+        auto queryPaths = io::listImages(vm["query"].as<std::string>());
+        std::unique_ptr<reid::ReId> model;
+        cv::Mat queries = embedImages(config, model, queryPaths, nullptr, std::max(0, vm["threads"].as<int>()));
+        if (!model)
+            model = std::make_unique<reid::ReId>(config);
+        auto detector = det::DetectorFactory::create(vm["detector"].as<std::string>());
+
+        reid::VideoSearchConfig searchConfig;
+        searchConfig.frameStride = std::max(1, vm["stride"].as<int>());
+        searchConfig.frameBatch = std::max(1, vm["batch"].as<int>());
+        searchConfig.className = vm["class"].as<std::string>();
+        searchConfig.minSimilarity = config.confidenceThreshold;
+
+        reid::VideoSearch search(*detector, *model, searchConfig);
+        activeSearch = &search;
+        signal(SIGINT, signalHandler);
+
+        // One JSON line per match, flushed as soon as it is found
+        size_t numMatches = 0;
+        search.run(capture, queries, [&](const reid::VideoMatch &match)
+                   {
+                       nlohmann::json line = {
+                           {"frame", match.frameIndex},
+                           {"timestamp", match.timestamp},
+                           {"query", queryPaths[match.query]},
+                           {"similarity", match.similarity},
+                           {"bbox", {match.bbox.x, match.bbox.y, match.bbox.width, match.bbox.height}},
+                       };
+                       out << line.dump() << std::endl;
+                       ++numMatches; });
+        activeSearch = nullptr;
+
+        std::cerr << "Video search: " << search.getSearchedFrames() << " frames, " << search.getDetections()
+                  << " detections, " << numMatches << " matches" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        activeSearch = nullptr;
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
     po::options_description options("Program options");
     options.add_options()("help,h", "Show help message");
-    options.add_options()("query,q", po::value<std::string>()->required(), "Query image to compare");
-    options.add_options()("key,k", po::value<std::string>()->required(), "Key image to compare against");
+    options.add_options()("query,q", po::value<std::string>(), "Query image, directory or image list to compare");
+    options.add_options()("key,k", po::value<std::string>(), "Key image, directory or image list to compare against");
+    options.add_options()("gallery,g", po::value<std::string>(), "Gallery file to search, created if missing");
+    options.add_options()("add", po::bool_switch(), "Add the query image to the gallery instead of searching it");
+    options.add_options()("id", po::value<int64_t>(), "Gallery id of the added image (default: gallery size)");
+    options.add_options()("metadata", po::value<std::string>(), "Gallery metadata of the added image (default: query path)");
+    options.add_options()("top,t", po::value<int>()->default_value(5), "Number of gallery matches");
+    options.add_options()("quantization", po::value<std::string>()->default_value("fp16"), "Gallery embeddings precision (fp32, fp16, int8)");
+    options.add_options()("threads", po::value<int>()->default_value(0), "Gallery search and index build threads (default: all cores)");
+    options.add_options()("index", po::value<std::string>(), "Approximate nearest neighbour index of the gallery, built or updated if needed");
+    options.add_options()("ef", po::value<int>()->default_value(64), "Index candidates explored per query, trades speed for recall");
+    options.add_options()("evaluate", po::value<int>(), "Compare index and exact search on this many synthetic embeddings");
+    options.add_options()("matrix", po::bool_switch(), "Batch mode: output the full similarity matrix instead of top matches");
+    options.add_options()("format,f", po::value<std::string>()->default_value("json"), "Batch mode output format (json, binary)");
+    options.add_options()("cache", po::value<std::string>(), "Batch mode embedding cache, keyed by file content");
+    options.add_options()("video", po::value<std::string>(), "Video to search for the query images");
+    options.add_options()("detector", po::value<std::string>(), "Video search: path to the detector config.json");
+    options.add_options()("stride", po::value<int>()->default_value(5), "Video search: search one frame out of stride");
+    options.add_options()("batch,b", po::value<int>()->default_value(8), "Video search: frames per detector batch");
+    options.add_options()("class", po::value<std::string>()->default_value("person"), "Video search: detection class to search, all if empty");
     options.add_options()("config,c", po::value<std::string>(), "Path to model config.json");
     options.add_options()("output,o", po::value<std::string>(), "Output file");
     options.add_options()("display,d", po::bool_switch(), "Display images");
@@ -28,21 +396,39 @@ int main(int argc, char *argv[])
 
     po::notify(vm);
 
-    // Input query
-    std::string queryPath = vm["query"].as<std::string>();
-    cv::Mat queryImage = cv::imread(queryPath, cv::IMREAD_COLOR);
-    if (queryImage.empty())
+    if (vm.count("evaluate"))
     {
-        std::cerr << "Error: Could not load query image " << queryPath << std::endl;
+        const std::map<std::string, int> depths = {{"fp32", CV_32F}, {"fp16", CV_16F}, {"int8", CV_8S}};
+        auto depth = depths.find(vm["quantization"].as<std::string>());
+        if (depth == depths.end())
+        {
+            std::cerr << "Error: Unknown quantization " << vm["quantization"].as<std::string>() << std::endl;
+            return 1;
+        }
+        std::cout << evaluateIndex(vm["evaluate"].as<int>(), depth->second, std::max(1, vm["top"].as<int>()), std::max(0, vm["threads"].as<int>())).dump() << std::endl;
+        return 0;
+    }
+
+    if (!vm.count("query"))
+    {
+        std::cerr << "Error: A query image is required" << std::endl;
         return 1;
     }
 
-    // Input key
-    std::string keyPath = vm["key"].as<std::string>();
-    cv::Mat keyImage = cv::imread(keyPath, cv::IMREAD_COLOR);
-    if (keyImage.empty())
+    if (vm.count("video"))
+    {
+        return searchVideo(vm);
+    }
+
+    if (vm.count("key") && !vm.count("gallery") &&
+        (io::isImageList(vm["query"].as<std::string>()) || io::isImageList(vm["key"].as<std::string>())))
     {
-        std::cerr << "Error: Could not load key image " << keyPath << std::endl;
+        return compareBatch(vm);
+    }
+
+    if (!vm.count("key") && !vm.count("gallery"))
+    {
+        std::cerr << "Error: Either a key image or a gallery is required" << std::endl;
         return 1;
     }
 
@@ -50,21 +436,132 @@ int main(int argc, char *argv[])
     reid::ReIdConfig config;
     std::string configPath = vm["config"].as<std::string>();
     config = reid::ReIdConfig::load(configPath);
+    reid::ReId reid(config);
+
+    // Input query, decoded at the lowest resolution that still covers the model input
+    std::string queryPath = vm["query"].as<std::string>();
+    cv::Mat queryImage = io::readImage(queryPath, reid.getInputSize());
+    if (queryImage.empty())
+    {
+        std::cerr << "Error: Could not load query image " << queryPath << std::endl;
+        return 1;
+    }
+
+    // Input key
+    cv::Mat keyImage;
+    if (vm.count("key"))
+    {
+        std::string keyPath = vm["key"].as<std::string>();
+        keyImage = io::readImage(keyPath, reid.getInputSize());
+        if (keyImage.empty())
+        {
+            std::cerr << "Error: Could not load key image " << keyPath << std::endl;
+            return 1;
+        }
+    }
 
     // Process images
-    reid::ReId reid(config);
     auto featureVector1 = reid.process(queryImage);
-    auto featureVector2 = reid.process(keyImage);
-
-    // Output
-    float similarity = cosineSimilarity(featureVector1, featureVector2);
-    bool match = similarity > reid.getConfig().confidenceThreshold;
-    nlohmann::json output = {
-        {"status", "success"},
-        {"data", {
-                     {"match", match},
-                     {"similarity", similarity},
-                 }}};
+
+    nlohmann::json output;
+    if (vm.count("gallery"))
+    {
+        const std::map<std::string, int> depths = {{"fp32", CV_32F}, {"fp16", CV_16F}, {"int8", CV_8S}};
+        auto depth = depths.find(vm["quantization"].as<std::string>());
+        if (depth == depths.end())
+        {
+            std::cerr << "Error: Unknown quantization " << vm["quantization"].as<std::string>() << std::endl;
+            return 1;
+        }
+
+        // Existing galleries keep their own precision
+        std::string galleryPath = vm["gallery"].as<std::string>();
+        std::unique_ptr<reid::Gallery> galleryPtr;
+        try
+        {
+            galleryPtr = fs::exists(galleryPath)
+                             ? std::make_unique<reid::Gallery>(galleryPath)
+                             : std::make_unique<reid::Gallery>(galleryPath, static_cast<int>(featureVector1.size()), depth->second);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+
+        auto &gallery = *galleryPtr;
+        if (gallery.getDims() != static_cast<int>(featureVector1.size()))
+        {
+            std::cerr << "Error: Gallery embeddings do not match the model output" << std::endl;
+            return 1;
+        }
+
+        if (vm["add"].as<bool>())
+        {
+            int64_t id = vm.count("id") ? vm["id"].as<int64_t>() : static_cast<int64_t>(gallery.size());
+            std::string metadata = vm.count("metadata") ? vm["metadata"].as<std::string>() : queryPath;
+            gallery.add(id, featureVector1, metadata);
+            output = {
+                {"status", "success"},
+                {"data", {
+                             {"id", id},
+                             {"size", gallery.size()},
+                         }}};
+        }
+        else
+        {
+            cv::Mat query(1, static_cast<int>(featureVector1.size()), CV_32F, featureVector1.data());
+            const size_t top = std::max(1, vm["top"].as<int>());
+            const size_t threads = std::max(0, vm["threads"].as<int>());
+            std::vector<std::vector<reid::GalleryMatch>> matches;
+            if (vm.count("index"))
+            {
+                // Load the index if any, then index the entries appended since it was saved
+                std::string indexPath = vm["index"].as<std::string>();
+                auto index = fs::exists(indexPath) ? std::make_unique<reid::HnswIndex>(gallery, indexPath)
+                                                                : std::make_unique<reid::HnswIndex>(gallery);
+                if (index->size() < gallery.size())
+                {
+                    index->update(threads);
+                    index->save(indexPath);
+                }
+                matches = index->search(query, top, std::max(1, vm["ef"].as<int>()));
+            }
+            else
+            {
+                matches = gallery.search(query, top, threads);
+            }
+
+            nlohmann::json results = nlohmann::json::array();
+            for (const auto &match : matches[0])
+            {
+                results.push_back({
+                    {"id", match.id},
+                    {"similarity", match.score},
+                    {"match", match.score > reid.getConfig().confidenceThreshold},
+                    {"metadata", match.metadata},
+                });
+            }
+            output = {
+                {"status", "success"},
+                {"data", {
+                             {"matches", results},
+                             {"size", gallery.size()},
+                         }}};
+        }
+    }
+    else
+    {
+        auto featureVector2 = reid.process(keyImage);
+        float similarity = kernels::cosine(featureVector1, featureVector2);
+        bool match = similarity > reid.getConfig().confidenceThreshold;
+        output = {
+            {"status", "success"},
+            {"data", {
+                         {"match", match},
+                         {"similarity", similarity},
+                     }}};
+    }
 
     // Output results
     if (vm.count("output"))
@@ -92,7 +589,7 @@ int main(int argc, char *argv[])
     }
 
     // Display image if requested
-    if (vm["display"].as<bool>())
+    if (vm["display"].as<bool>() && !keyImage.empty())
     {
         int maxHeight = std::max(queryImage.rows, keyImage.rows);
         int totalWidth = queryImage.cols + keyImage.cols;
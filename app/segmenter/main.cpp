@@ -1,8 +1,12 @@
 #include <string>
 #include <signal.h>
 #include <atomic>
+#include <chrono>
 
 #include <types/frame.hpp>
+#include <video/capture.hpp>
+#include <video/segmented.hpp>
+#include <io/result_writer.hpp>
 #include <opencv2/opencv.hpp>
 #include <boost/program_options.hpp>
 #include <models/segmentation/factory.hpp>
@@ -24,6 +28,11 @@ int main(int argc, char *argv[])
     options.add_options()("config,c", po::value<std::string>(), "Path to model config.json");
     options.add_options()("output,o", po::value<std::string>(), "Output video file");
     options.add_options()("display,d", po::bool_switch(), "Display video frames");
+    options.add_options()("live,l", po::bool_switch(), "Live source: only process the latest frame and drop stale ones");
+    options.add_options()("batch,b", po::value<int>()->default_value(1), "Number of frames processed per batch (offline video only)");
+    options.add_options()("segments,s", po::value<int>()->default_value(1), "Number of video segments processed in parallel (offline video only, headless)");
+    options.add_options()("results,r", po::value<std::string>(), "Output file for structured results ('-' for stdout)");
+    options.add_options()("format,f", po::value<std::string>()->default_value("json"), "Structured results format (json, binary, columnar)");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, options), vm);
@@ -36,18 +45,44 @@ int main(int argc, char *argv[])
 
     po::notify(vm);
 
-    // Input
-    std::string inputPath = vm["input"].as<std::string>();
-    cv::VideoCapture cap;
-    if (inputPath.size() == 1 && std::isdigit(inputPath[0]))
+    // Structured results
+    const auto format = io::getResultFormat(vm["format"].as<std::string>());
+    if (format == io::ResultFormat::UNKNOWN)
     {
-        cap.open(std::stoi(inputPath));
+        std::cerr << "Error: Unknown result format " << vm["format"].as<std::string>() << std::endl;
+        return 1;
     }
-    else
+
+    // Input
+    std::string inputPath = vm["input"].as<std::string>();
+
+    // Parallel segments: each segment runs its own model, results are written in frame order
+    if (vm["segments"].as<int>() > 1)
     {
-        cap.open(inputPath);
+        std::string configPath = vm["config"].as<std::string>();
+        video::SegmentedVideoProcessor processor(inputPath, vm["segments"].as<int>(), std::max(1, vm["batch"].as<int>()));
+        io::AsyncResultWriter resultWriter(vm.count("results") ? vm["results"].as<std::string>() : "-", format, false);
+        signal(SIGINT, signalHandler);
+
+        processor.run(
+            [&configPath](size_t) -> video::BatchProcessor
+            {
+                std::shared_ptr<trt::DetectionProcessor> model = seg::SegmenterFactory::create(configPath);
+                return [model](const std::vector<cv::Mat> &frames)
+                { return model->process(frames); };
+            },
+            [&processor, &resultWriter](io::FrameResult &&result)
+            {
+                resultWriter.write(std::move(result));
+                if (!running)
+                    processor.stop();
+            });
+        resultWriter.close();
+        return 0;
     }
-    if (!cap.isOpened())
+
+    cv::VideoCapture cap;
+    if (!video::openSource(cap, inputPath))
     {
         std::cerr << "Error: Could not open video source " << inputPath << std::endl;
         return 1;
@@ -74,36 +109,98 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Display
-    bool display = vm["display"].as<bool>() || !vm.count("output");
+    std::unique_ptr<io::AsyncResultWriter> resultWriter = nullptr;
+    if (vm.count("results"))
+    {
+        resultWriter = std::make_unique<io::AsyncResultWriter>(vm["results"].as<std::string>(), format, false);
+    }
+
+    // Display, frames are only drawn when displayed or recorded
+    bool display = vm["display"].as<bool>() || (!vm.count("output") && !vm.count("results"));
+    bool draw = display || writer.isOpened();
     if (display)
     {
         cv::namedWindow("Segmentations", cv::WINDOW_AUTOSIZE);
     }
 
-    Frame frame;
+    // Live source
+    std::unique_ptr<video::LatestFrameCapture> liveCapture = nullptr;
+    if (vm["live"].as<bool>())
+    {
+        liveCapture = std::make_unique<video::LatestFrameCapture>(cap);
+    }
+
+    // Live sources are processed frame by frame, offline videos are batched across frames
+    const size_t batchSize = liveCapture ? 1 : static_cast<size_t>(std::max(1, vm["batch"].as<int>()));
+    std::vector<Frame> frames(batchSize);
+    std::vector<double> timestamps(batchSize);
+    auto readFrame = [&](size_t i)
+    {
+        if (liveCapture)
+        {
+            bool success = liveCapture->read(frames[i].image);
+            timestamps[i] = std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+            return success;
+        }
+        cap >> frames[i];
+        timestamps[i] = cap.get(cv::CAP_PROP_POS_MSEC);
+        return !frames[i].empty();
+    };
+
+    std::vector<cv::Mat> images;
+    images.reserve(batchSize);
+    int64_t frameIndex = 0;
     signal(SIGINT, signalHandler);
 
     while (running)
     {
-        cap >> frame;
-        if (frame.empty())
+        images.clear();
+        while (images.size() < batchSize && readFrame(images.size()))
+        {
+            images.push_back(frames[images.size()].image);
+        }
+        if (images.empty())
             break;
 
         // Detect objects
-        auto detections = model->process(frame.image);
+        auto batchDetections = model->process(images);
+
+        // Consume results in frame order
+        for (size_t i = 0; i < images.size() && running; ++i)
+        {
+            auto &detections = batchDetections[i];
+
+            // Draw detections
+            if (draw)
+            {
+                cv::Mat output = frames[i].draw(detections);
 
-        // Draw detections
-        cv::Mat output = frame.draw(detections);
+                if (display)
+                    cv::imshow("Segmentations", output);
 
-        if (display)
-            cv::imshow("Segmentations", output);
+                if (writer.isOpened())
+                    writer.write(output);
+            }
 
-        if (writer.isOpened())
-            writer.write(output);
+            // Structured results
+            if (resultWriter)
+                resultWriter->write({frameIndex, timestamps[i], std::move(detections)});
+            ++frameIndex;
 
-        if (cv::waitKey(1) == 27)
-            running = false;
+            if (display && cv::waitKey(1) == 27)
+                running = false;
+        }
+
+        // End of stream
+        if (images.size() < batchSize)
+            break;
+    }
+
+    if (liveCapture)
+    {
+        liveCapture->release();
+        std::cerr << "Live capture: " << liveCapture->getGrabbedFrames() << " frames grabbed, "
+                  << liveCapture->getDroppedFrames() << " stale frames dropped" << std::endl;
     }
 
     if (cap.isOpened())
@@ -112,6 +209,9 @@ int main(int argc, char *argv[])
     if (writer.isOpened())
         writer.release();
 
+    if (resultWriter)
+        resultWriter->close();
+
     if (display)
         cv::destroyAllWindows();
 
@@ -0,0 +1,77 @@
+#include <string>
+#include <fstream>
+#include <signal.h>
+#include <atomic>
+#include <boost/program_options.hpp>
+
+#include <server/server.hpp>
+#include <models/detection/factory.hpp>
+#include <models/segmentation/factory.hpp>
+
+namespace po = boost::program_options;
+
+std::atomic<bool> running{true};
+
+void signalHandler([[maybe_unused]] int signum)
+{
+    running = false;
+}
+
+int main(int argc, char *argv[])
+{
+    po::options_description options("Program options");
+    options.add_options()("help,h", "Show help message");
+    options.add_options()("config,c", po::value<std::string>()->required(), "Path to model config.json");
+    options.add_options()("socket,s", po::value<std::string>()->default_value("/tmp/tensorrt-vision.sock"), "Unix domain socket to listen on");
+    options.add_options()("batch-timeout", po::value<int>()->default_value(2000), "Time to wait for more requests to fill a batch (us)");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << options << "\n";
+        return 1;
+    }
+
+    po::notify(vm);
+
+    // Load config
+    std::string configPath = vm["config"].as<std::string>();
+    std::ifstream file(configPath);
+    auto config = nlohmann::json::parse(file);
+    bool segment = config.contains("segmenter");
+    const auto &modelConfig = segment ? config["segmenter"] : config["detector"];
+
+    if (modelConfig.value("architecture", "") == "remote")
+    {
+        std::cerr << "Error: The server needs a local model, not a remote one" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> classNames = modelConfig.value("class_names", std::vector<std::string>{});
+    size_t maxBatchSize = 1;
+    if (modelConfig.contains("engine"))
+        maxBatchSize = modelConfig["engine"].value("batch_size", 1);
+
+    // Load model
+    std::unique_ptr<trt::DetectionProcessor> model = nullptr;
+    if (segment)
+    {
+        model = seg::SegmenterFactory::create(configPath);
+    }
+    else
+    {
+        model = det::DetectorFactory::create(configPath);
+    }
+
+    // Serve
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
+    server::InferenceServer inferenceServer(std::move(model), classNames, maxBatchSize,
+                                            std::chrono::microseconds(vm["batch-timeout"].as<int>()));
+    inferenceServer.serve(vm["socket"].as<std::string>(), running);
+
+    return 0;
+}
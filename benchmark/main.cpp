@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <nlohmann/json.hpp>
+#include <opencv2/dnn.hpp>
+
+#include <engine/preprocess.hpp>
+#include <utils/nms.hpp>
+#include <utils/tensorrt_utils.hpp>
+#include <models/detection/yolo.hpp>
+#include <models/segmentation/yolo.hpp>
+#include <models/classification/classifier.hpp>
+
+#include "reference.hpp"
+#include "support/synthetic.hpp"
+
+namespace po = boost::program_options;
+
+namespace
+{
+    // Results are summed into the sink so that the compiler cannot drop the benchmarked calls
+    volatile size_t sink = 0;
+
+    class Runner
+    {
+    public:
+        Runner(double minTime, const std::string &filter) : m_minTime(minTime), m_filter(filter) {};
+
+        bool matches(const std::string &name) const { return std::regex_search(name, m_filter); };
+
+        // Times the case until it ran for the minimum time, in samples of at least a millisecond
+        void run(const std::string &name, const nlohmann::json &params, bool check, const std::function<size_t()> &function)
+        {
+            using Clock = std::chrono::steady_clock;
+
+            // Warm-up, caches and allocator pools
+            const auto warmStart = Clock::now();
+            sink = sink + function();
+            const double once = std::max(1.0, std::chrono::duration<double, std::nano>(Clock::now() - warmStart).count());
+            const size_t perSample = std::max<size_t>(1, static_cast<size_t>(1e6 / once));
+
+            std::vector<double> samples;
+            double total = 0.0;
+            while (total < m_minTime * 1e9 || samples.size() < 5)
+            {
+                const auto start = Clock::now();
+                for (size_t i = 0; i < perSample; ++i)
+                    sink = sink + function();
+                const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+                samples.push_back(elapsed / perSample);
+                total += elapsed;
+            }
+            std::sort(samples.begin(), samples.end());
+
+            nlohmann::json result = {
+                {"name", name},
+                {"params", params},
+                {"check", check ? "pass" : "fail"},
+                {"iterations", samples.size() * perSample},
+                {"ns_per_op", {{"median", samples[samples.size() / 2]}, {"min", samples.front()}, {"p90", samples[samples.size() * 9 / 10]}}},
+            };
+            std::cerr << name << " " << params.dump() << ": " << samples[samples.size() / 2] / 1e3 << " us" << (check ? "" : " CHECK FAILED") << std::endl;
+            m_results.push_back(std::move(result));
+            m_failed = m_failed || !check;
+        }
+
+        const nlohmann::json &getResults() const { return m_results; };
+        bool hasFailed() const { return m_failed; };
+
+    private:
+        const double m_minTime; // s
+        const std::regex m_filter;
+        nlohmann::json m_results = nlohmann::json::array();
+        bool m_failed = false;
+    };
+
+    const cv::Size INPUT_SIZE(640, 640);
+    const std::vector<double> DENSITIES = {0.001, 0.01, 0.1};
+
+    void benchmarkPreprocess(Runner &runner, uint32_t seed)
+    {
+        testing::OutputGenerator generator(seed, cv::Size2f(INPUT_SIZE), 0.25f);
+        const cv::Mat frame = generator.frame({1920, 1080});
+
+        if (runner.matches("preprocess/letterbox"))
+        {
+            trt::PreprocessDescriptor descriptor;
+            descriptor.size = INPUT_SIZE;
+            descriptor.scaleFill = false;
+
+            // A 16:9 frame is padded by 280 rows of the pad color, wherever the letterbox places them
+            const cv::Mat tensor = trt::preprocessImage(frame, descriptor);
+            const cv::Vec3f pad = cv::Vec3f::all(static_cast<float>(descriptor.padColor[0] * descriptor.scale));
+            int padRows = 0;
+            for (int y = 0; y < tensor.rows; ++y)
+            {
+                bool uniform = true;
+                for (int x = 0; x < tensor.cols && uniform; ++x)
+                    uniform = cv::norm(tensor.at<cv::Vec3f>(y, x) - pad) < 1e-6;
+                padRows += uniform;
+            }
+            const bool check = tensor.size() == INPUT_SIZE && tensor.type() == CV_32FC3 && padRows == 280;
+
+            runner.run("preprocess/letterbox", {{"input", "1920x1080"}, {"size", "640x640"}}, check, [&]()
+                       { return trt::preprocessImage(frame, descriptor).total(); });
+        }
+
+        if (runner.matches("preprocess/stretch"))
+        {
+            trt::PreprocessDescriptor descriptor;
+            descriptor.size = INPUT_SIZE;
+            descriptor.resize = trt::ResizeMode::STRETCH;
+
+            cv::Mat rgb, resized, reference;
+            cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
+            cv::resize(rgb, resized, INPUT_SIZE, 0, 0, cv::INTER_LINEAR);
+            resized.convertTo(reference, CV_32FC3, descriptor.scale);
+            const bool check = cv::norm(trt::preprocessImage(frame, descriptor), reference, cv::NORM_INF) == 0.0;
+
+            runner.run("preprocess/stretch", {{"input", "1920x1080"}, {"size", "640x640"}}, check, [&]()
+                       { return trt::preprocessImage(frame, descriptor).total(); });
+        }
+    }
+
+    void benchmarkBlob(Runner &runner, uint32_t seed)
+    {
+        if (!runner.matches("blob/blobFromMats"))
+            return;
+
+        for (size_t batchSize : {1, 8})
+        {
+            testing::OutputGenerator generator(seed, cv::Size2f(INPUT_SIZE), 0.25f);
+            std::vector<cv::Mat> batch;
+            for (size_t i = 0; i < batchSize; ++i)
+                batch.push_back(generator.tensor(INPUT_SIZE));
+
+            const cv::Mat blob = trt::blobFromMats(batch);
+            const auto reference = bench::referenceBlob(batch);
+            const bool check = blob.total() * blob.channels() == reference.size() &&
+                               std::equal(reference.begin(), reference.end(), blob.ptr<float>());
+
+            runner.run("blob/blobFromMats", {{"batch", batchSize}, {"size", "640x640"}}, check, [&]()
+                       { return trt::blobFromMats(batch).total(); });
+        }
+    }
+
+    void benchmarkDetection(Runner &runner, uint32_t seed)
+    {
+        det::YoloConfig config;
+        const cv::Size2f inputSize(INPUT_SIZE);
+        const int numClasses = 80;
+
+        for (double density : DENSITIES)
+        {
+            if (runner.matches("detect/yolov8"))
+            {
+                testing::OutputGenerator generator(seed, inputSize, config.confidenceThreshold);
+                const int numAnchors = 8400;
+                const auto output = generator.yolo(numClasses, numAnchors, density);
+                const auto reference = bench::referenceDecode(
+                    numAnchors, numClasses, inputSize, config.confidenceThreshold, config.nmsThreshold, config.topK,
+                    [&](int anchor, int channel)
+                    { return output.data[static_cast<size_t>(channel) * numAnchors + anchor]; },
+                    [&](int anchor, int classId)
+                    { return output.data[static_cast<size_t>(4 + classId) * numAnchors + anchor]; });
+                const auto detections = det::decodeYolo(output.data.data(), output.rows, output.cols, inputSize, config);
+
+                runner.run("detect/yolov8", {{"anchors", numAnchors}, {"classes", numClasses}, {"density", density}, {"detections", detections.size()}},
+                           bench::sameDetections(detections, reference), [&]()
+                           { return det::decodeYolo(output.data.data(), output.rows, output.cols, inputSize, config).size(); });
+            }
+
+            if (runner.matches("detect/yolov7"))
+            {
+                testing::OutputGenerator generator(seed, inputSize, config.confidenceThreshold);
+                const int numAnchors = 25200;
+                const auto output = generator.yolov7(numClasses, numAnchors, density);
+                const auto reference = bench::referenceDecode(
+                    numAnchors, numClasses, inputSize, config.confidenceThreshold, config.nmsThreshold, config.topK,
+                    [&](int anchor, int channel)
+                    { return output.data[static_cast<size_t>(anchor) * output.cols + (channel < 4 ? channel : channel + 1)]; },
+                    [&](int anchor, int classId)
+                    { return output.data[static_cast<size_t>(anchor) * output.cols + 5 + classId] * output.data[static_cast<size_t>(anchor) * output.cols + 4]; });
+                const auto detections = det::decodeYolov7(output.data.data(), output.rows, output.cols, inputSize, config);
+
+                runner.run("detect/yolov7", {{"anchors", numAnchors}, {"classes", numClasses}, {"density", density}, {"detections", detections.size()}},
+                           bench::sameDetections(detections, reference), [&]()
+                           { return det::decodeYolov7(output.data.data(), output.rows, output.cols, inputSize, config).size(); });
+            }
+        }
+    }
+
+    void benchmarkSegmentation(Runner &runner, uint32_t seed)
+    {
+        if (!runner.matches("segment/yolov8"))
+            return;
+
+        seg::YoloConfig config;
+        const cv::Size2f inputSize(INPUT_SIZE);
+        const int numClasses = 80, numAnchors = 8400, numMasks = 32, maskSize = 160;
+        const int numChannels = 4 + numClasses + numMasks;
+
+        for (double density : DENSITIES)
+        {
+            testing::OutputGenerator generator(seed, inputSize, config.confidenceThreshold);
+            const auto output = generator.yolo(numClasses, numAnchors, density, numMasks, maskSize);
+            const auto reference = bench::referenceDecode(
+                numAnchors, numClasses, inputSize, config.confidenceThreshold, config.nmsThreshold, config.topK,
+                [&](int anchor, int channel)
+                { return output.data[static_cast<size_t>(channel) * numAnchors + anchor]; },
+                [&](int anchor, int classId)
+                { return output.data[static_cast<size_t>(4 + classId) * numAnchors + anchor]; });
+            const auto detections = seg::decodeYolo(output.data.data(), output.protos.data(), numChannels, numAnchors,
+                                                    numMasks, maskSize, maskSize, inputSize, config);
+
+            // Boxes, then the first pixel of every mask against the prototypes weighted by its anchor
+            bool check = bench::sameDetections(detections, reference);
+            for (size_t i = 0; check && i < detections.size(); ++i)
+            {
+                const cv::Rect roi = cv::Rect(static_cast<int>(detections[i].bbox.x * maskSize), static_cast<int>(detections[i].bbox.y * maskSize),
+                                              static_cast<int>(detections[i].bbox.width * maskSize), static_cast<int>(detections[i].bbox.height * maskSize)) &
+                                     cv::Rect(0, 0, maskSize, maskSize);
+                if (detections[i].mask.size() != roi.size())
+                {
+                    check = false;
+                    break;
+                }
+                if (roi.empty())
+                    continue;
+
+                float value = 0.f;
+                for (int k = 0; k < numMasks; ++k)
+                {
+                    value += output.data[static_cast<size_t>(4 + numClasses + k) * numAnchors + reference[i].anchor] *
+                             output.protos[static_cast<size_t>(k) * maskSize * maskSize + roi.y * maskSize + roi.x];
+                }
+                check = std::abs(detections[i].mask.at<float>(0, 0) - bench::sigmoid(value)) < 1e-4f;
+            }
+
+            runner.run("segment/yolov8", {{"anchors", numAnchors}, {"classes", numClasses}, {"masks", numMasks}, {"mask_size", maskSize}, {"density", density}, {"detections", detections.size()}},
+                       check, [&]()
+                       { return seg::decodeYolo(output.data.data(), output.protos.data(), numChannels, numAnchors,
+                                                numMasks, maskSize, maskSize, inputSize, config)
+                             .size(); });
+        }
+    }
+
+    void benchmarkNms(Runner &runner, uint32_t seed)
+    {
+        const float scoreThreshold = 0.25f, nmsThreshold = 0.45f;
+        for (int count : {100, 1000, 5000})
+        {
+            testing::OutputGenerator generator(seed, cv::Size2f(INPUT_SIZE), scoreThreshold);
+            std::vector<cv::Rect2d> boxes;
+            std::vector<float> scores;
+            generator.boxes(count, boxes, scores);
+            const auto reference = bench::referenceNms(boxes, scores, scoreThreshold, nmsThreshold, 0);
+
+            // OpenCV implementation, for comparison
+            if (runner.matches("nms/NMSBoxes"))
+            {
+                std::vector<int> indices;
+                cv::dnn::NMSBoxes(boxes, scores, scoreThreshold, nmsThreshold, indices);
+                const bool check = indices == reference;
+
+                runner.run("nms/NMSBoxes", {{"boxes", count}, {"kept", indices.size()}}, check, [&]()
+                           {
+                               cv::dnn::NMSBoxes(boxes, scores, scoreThreshold, nmsThreshold, indices);
+                               return indices.size(); });
+            }
+
+            // Used by the YOLO decoding
+            if (runner.matches("nms/nmsBoxes"))
+            {
+                std::vector<int> indices, candidates;
+                trt::nmsBoxes(boxes, scores, scoreThreshold, nmsThreshold, indices, candidates);
+                const bool check = indices == reference;
+
+                runner.run("nms/nmsBoxes", {{"boxes", count}, {"kept", indices.size()}}, check, [&]()
+                           {
+                               trt::nmsBoxes(boxes, scores, scoreThreshold, nmsThreshold, indices, candidates);
+                               return indices.size(); });
+            }
+        }
+    }
+
+    void benchmarkClassification(Runner &runner, uint32_t seed)
+    {
+        cls::ClassifierConfig config;
+        const int numClasses = 1000;
+        testing::OutputGenerator generator(seed, cv::Size2f(INPUT_SIZE), config.confidenceThreshold);
+        const auto scores = generator.scores(numClasses, 5);
+
+        int best = -1;
+        int above = 0;
+        for (int i = 0; i < numClasses; ++i)
+        {
+            if (scores[i] >= config.confidenceThreshold)
+                ++above;
+            if (scores[i] >= config.confidenceThreshold && (best < 0 || scores[i] > scores[best]))
+                best = i;
+        }
+
+        if (runner.matches("classify/single"))
+        {
+            const auto detection = cls::decodeSingleLabel(scores, config);
+            const bool check = detection.class_id == best && detection.labels.size() == (best >= 0 ? 1u : 0u);
+            runner.run("classify/single", {{"classes", numClasses}}, check, [&]()
+                       { return static_cast<size_t>(cls::decodeSingleLabel(scores, config).class_id); });
+        }
+
+        if (runner.matches("classify/multi"))
+        {
+            const auto detection = cls::decodeMultiLabel(scores, config);
+            const bool check = detection.class_id == best && detection.labels.size() == static_cast<size_t>(above);
+            runner.run("classify/multi", {{"classes", numClasses}, {"above", above}}, check, [&]()
+                       { return cls::decodeMultiLabel(scores, config).labels.size(); });
+        }
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    po::options_description options("Program options");
+    options.add_options()("help,h", "Show help message");
+    options.add_options()("filter", po::value<std::string>()->default_value(""), "Only run the benchmarks whose name matches the regex");
+    options.add_options()("min-time", po::value<double>()->default_value(0.5), "Minimum time per benchmark (s)");
+    options.add_options()("seed", po::value<uint32_t>()->default_value(42), "Seed of the synthetic frames and outputs");
+    options.add_options()("threads", po::value<int>()->default_value(1), "OpenCV threads, 1 for stable timings");
+    options.add_options()("output,o", po::value<std::string>()->default_value("-"), "Output JSON file ('-' for stdout)");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, options), vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << options << "\n";
+        return 1;
+    }
+
+    po::notify(vm);
+
+    cv::setNumThreads(vm["threads"].as<int>());
+    const uint32_t seed = vm["seed"].as<uint32_t>();
+
+    // Every case generates its inputs from the seed, they do not depend on the filter
+    Runner runner(vm["min-time"].as<double>(), vm["filter"].as<std::string>());
+    benchmarkPreprocess(runner, seed);
+    benchmarkBlob(runner, seed);
+    benchmarkDetection(runner, seed);
+    benchmarkSegmentation(runner, seed);
+    benchmarkNms(runner, seed);
+    benchmarkClassification(runner, seed);
+
+    // Same seed and toolchain, same inputs: results of two builds can be diffed case by case
+    const nlohmann::json report = {
+        {"seed", seed},
+        {"threads", vm["threads"].as<int>()},
+        {"opencv", CV_VERSION},
+        {"compiler", __VERSION__},
+        {"results", runner.getResults()},
+    };
+
+    const std::string outputPath = vm["output"].as<std::string>();
+    if (outputPath == "-")
+    {
+        std::cout << report.dump(2) << std::endl;
+    }
+    else
+    {
+        std::ofstream file(outputPath);
+        if (!file.is_open())
+        {
+            std::cerr << "Error: Could not open output file " << outputPath << std::endl;
+            return 1;
+        }
+        file << report.dump(2) << std::endl;
+    }
+
+    return runner.hasFailed() ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <types/detection.hpp>
+
+namespace bench
+{
+    // Straightforward implementations the optimized code is checked against. They follow the contract of
+    // cv::dnn::NMSBoxes: scores strictly above the threshold, stable sort, top_k applied before suppression.
+
+    struct ReferenceDetection
+    {
+        int classId = -1;
+        float score = 0.f;
+        cv::Rect2d bbox{};
+        int anchor = -1;
+    };
+
+    inline float referenceOverlap(const cv::Rect2d &a, const cv::Rect2d &b)
+    {
+        const double areaA = a.area();
+        const double areaB = b.area();
+        if (areaA + areaB <= std::numeric_limits<double>::epsilon())
+            return 1.f;
+        const double intersection = (a & b).area();
+        return 1.f - static_cast<float>(1.0 - intersection / (areaA + areaB - intersection));
+    }
+
+    inline std::vector<int> referenceNms(const std::vector<cv::Rect2d> &boxes, const std::vector<float> &scores,
+                                         float scoreThreshold, float nmsThreshold, int topK)
+    {
+        std::vector<int> candidates;
+        for (size_t i = 0; i < scores.size(); ++i)
+        {
+            if (scores[i] > scoreThreshold)
+                candidates.push_back(static_cast<int>(i));
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [&scores](int a, int b)
+                         { return scores[a] > scores[b]; });
+        if (topK > 0 && static_cast<size_t>(topK) < candidates.size())
+            candidates.resize(topK);
+
+        std::vector<int> kept;
+        for (int candidate : candidates)
+        {
+            bool keep = true;
+            for (size_t k = 0; k < kept.size() && keep; ++k)
+                keep = referenceOverlap(boxes[candidate], boxes[kept[k]]) <= nmsThreshold;
+            if (keep)
+                kept.push_back(candidate);
+        }
+        return kept;
+    }
+
+    // Decoding of any YOLO layout through an accessor (anchor, channel), with the class score of an anchor
+    template <typename Accessor, typename Score>
+    std::vector<ReferenceDetection> referenceDecode(int numAnchors, int numClasses, const cv::Size2f &inputSize,
+                                                    float confidenceThreshold, float nmsThreshold, int topK, Accessor at, Score score)
+    {
+        std::vector<cv::Rect2d> boxes;
+        std::vector<float> scores;
+        std::vector<int> classIds;
+        std::vector<int> anchors;
+        for (int anchor = 0; anchor < numAnchors; ++anchor)
+        {
+            int classId = 0;
+            for (int c = 1; c < numClasses; ++c)
+            {
+                if (at(anchor, 4 + c) > at(anchor, 4 + classId))
+                    classId = c;
+            }
+            const float value = score(anchor, classId);
+            if (value < confidenceThreshold)
+                continue;
+
+            const float cx = at(anchor, 0), cy = at(anchor, 1), w = at(anchor, 2), h = at(anchor, 3);
+            boxes.emplace_back(std::clamp((cx - 0.5f * w) / inputSize.width, 0.f, 1.f),
+                               std::clamp((cy - 0.5f * h) / inputSize.height, 0.f, 1.f),
+                               std::clamp(w / inputSize.width, 0.f, 1.f),
+                               std::clamp(h / inputSize.height, 0.f, 1.f));
+            scores.push_back(value);
+            classIds.push_back(classId);
+            anchors.push_back(anchor);
+        }
+
+        std::vector<ReferenceDetection> detections;
+        for (int index : referenceNms(boxes, scores, confidenceThreshold, nmsThreshold, topK))
+            detections.push_back({classIds[index], scores[index], boxes[index], anchors[index]});
+        return detections;
+    }
+
+    inline bool sameDetections(const std::vector<Detection> &detections, const std::vector<ReferenceDetection> &reference)
+    {
+        if (detections.size() != reference.size())
+            return false;
+        for (size_t i = 0; i < detections.size(); ++i)
+        {
+            const auto &a = detections[i];
+            const auto &b = reference[i];
+            if (a.class_id != b.classId || a.confidence != b.score ||
+                std::abs(a.bbox.x - b.bbox.x) > 1e-6 || std::abs(a.bbox.y - b.bbox.y) > 1e-6 ||
+                std::abs(a.bbox.width - b.bbox.width) > 1e-6 || std::abs(a.bbox.height - b.bbox.height) > 1e-6)
+                return false;
+        }
+        return true;
+    }
+
+    // NCHW batch of HWC images
+    inline std::vector<float> referenceBlob(const std::vector<cv::Mat> &images)
+    {
+        std::vector<float> blob;
+        blob.reserve(images.size() * images[0].total() * 3);
+        for (const auto &image : images)
+        {
+            for (int c = 0; c < 3; ++c)
+                for (int y = 0; y < image.rows; ++y)
+                    for (int x = 0; x < image.cols; ++x)
+                        blob.push_back(image.at<cv::Vec3f>(y, x)[c]);
+        }
+        return blob;
+    }
+
+    inline float sigmoid(float value)
+    {
+        return 1.f / (1.f + std::exp(-value));
+    }
+
+} // namespace bench
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+#include <utils/mapped_file.hpp>
+
+namespace trt
+{
+    // Single file model: a serialized engine with the config sections it was exported with (class names, thresholds...)
+    //   file: BundleHeader | config JSON | padding | engine
+    // The engine starts on a page boundary so that it is mapped as is.
+    namespace bundle
+    {
+        static constexpr char MAGIC[8] = {'T', 'R', 'T', 'B', 'N', 'D', 'L', 'E'};
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint64_t ALIGNMENT = 4096;
+
+        struct BundleHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t reserved;
+            uint64_t configSize;
+            uint64_t engineOffset;
+            uint64_t engineSize;
+        };
+
+        static_assert(sizeof(BundleHeader) == 40, "Unexpected bundle header size");
+    } // namespace bundle
+
+    class ModelBundle
+    {
+    public:
+        explicit ModelBundle(const std::string &path);
+
+        static bool isBundle(const std::string &path);
+        // Bundle a config (sections by task, like a config file) with the engine at enginePath
+        static void write(const std::string &path, const nlohmann::json &config, const std::string &enginePath);
+
+        const nlohmann::json &getConfig() const { return m_config; };
+        const char *getEngineData() const { return m_file.data() + m_header->engineOffset; };
+        size_t getEngineSize() const { return m_header->engineSize; };
+
+        // Read the engine from disk ahead of its deserialization
+        void loadEngine() const { m_file.load(m_header->engineOffset, m_header->engineSize); };
+
+    private:
+        MappedFile m_file;
+        const bundle::BundleHeader *m_header = nullptr;
+        nlohmann::json m_config{};
+    };
+
+    // Parse a config file. A task section (or a single task config) whose engine model path is a bundle is completed
+    // by the same section of the bundle config, keys of the config file taking precedence.
+    nlohmann::json loadConfig(const std::string &path);
+
+} // namespace trt
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <cstddef>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sys/types.h>
 #include <vector>
 #include <string>
 #include <NvInfer.h>
 #include "engine/logger.hpp"
+#include "metrics/allocations.hpp"
+#include "metrics/metrics.hpp"
+#include "metrics/trace.hpp"
 #include "utils/json_utils.hpp"
 #include <opencv2/opencv.hpp>
 
@@ -33,6 +38,7 @@ namespace trt
         std::string modelPath{};
         int batchSize = 1;
         Precision precision = Precision::FP16;
+        bool warmup = true; // run one inference at load, so that the first frame is not slower
 
         std::shared_ptr<const JsonConfig> clone() const override { return std::make_shared<EngineConfig>(*this); }
 
@@ -44,9 +50,55 @@ namespace trt
                 batchSize = data["batch_size"].get<int>();
             if (data.contains("precision"))
                 precision = static_cast<Precision>(data["precision"].get<int>());
+            if (data.contains("warmup"))
+                warmup = data["warmup"].get<bool>();
         }
     };
 
+    // Startup phases of an engine (ms). The mapped engine file is paged in during the read phase.
+    struct EngineLoadTimings
+    {
+        double readMs = 0.0;
+        double deserializeMs = 0.0;
+        double contextMs = 0.0; // execution context and IO buffers
+        double warmupMs = 0.0;
+        bool shared = false; // model already loaded by another engine, nothing was read nor deserialized
+    };
+
+    // Deserialized model, shared by the engines loading the same model file
+    struct EngineModel
+    {
+        NvLogger logger{};
+        std::unique_ptr<nvinfer1::IRuntime> runtime = nullptr;
+        std::unique_ptr<nvinfer1::ICudaEngine> engine = nullptr;
+    };
+
+    // Models of the process by file and device. Engines of the same model share its weights and only create
+    // their own execution context and IO buffers. A model is released with the last engine using it.
+    class EngineRegistry
+    {
+    public:
+        static EngineRegistry &instance();
+
+        // Deserialize a model or share the one already loaded, nullptr on failure
+        std::shared_ptr<EngineModel> acquire(const std::string &engineModelPath, int deviceIndex, EngineLoadTimings &timings);
+
+        // Models currently loaded
+        size_t size() const;
+
+    private:
+        struct Entry
+        {
+            std::mutex mutex;
+            std::weak_ptr<EngineModel> model{};
+        };
+
+        EngineRegistry() = default;
+
+        mutable std::mutex m_mutex;
+        std::map<std::pair<std::string, int>, std::shared_ptr<Entry>> m_entries{};
+    };
+
     class Engine
     {
     public:
@@ -54,8 +106,10 @@ namespace trt
         ~Engine();
         // Clear memory
         void clearBuffers();
-        // Load and prepare engine for inference
+        // Load and prepare engine for inference, from an engine file or a model bundle
         bool loadNetwork(const std::string &engineModelPath);
+        // Run one inference on a blank batch, CUDA kernels and memory pools are initialized before the first frame
+        bool warmUp();
         // Load inputs to CUDA memory
         bool prepareInputs(const std::vector<std::vector<cv::Mat>> &inputs, cudaStream_t &inferenceCudaStream, const int32_t batchSize);
         // Copy the outputs back to CPU
@@ -73,6 +127,9 @@ namespace trt
         [[nodiscard]] const EngineOptions &getOptions() const { return m_options; };
         [[nodiscard]] const std::vector<nvinfer1::Dims3> &getInputDims() const { return m_inputDims; };
         [[nodiscard]] const std::vector<nvinfer1::Dims> &getOutputDims() const { return m_outputDims; };
+        [[nodiscard]] const EngineLoadTimings &getLoadTimings() const { return m_loadTimings; };
+        // File name of the loaded model without extension, labels its metrics
+        [[nodiscard]] const std::string &getModelName() const { return m_modelName; };
 
     private:
         // Holds pointer to the input and output GPU buffers
@@ -81,13 +138,42 @@ namespace trt
         std::vector<nvinfer1::Dims3> m_inputDims{};
         std::vector<nvinfer1::Dims> m_outputDims{};
         std::vector<std::string> m_IOTensorNames{};
+        // Host NCHW blob of each input, reused between calls (pageable copies return once the blob is staged)
+        std::vector<cv::Mat> m_inputBlobs{};
 
-        std::unique_ptr<nvinfer1::IRuntime> m_runtime = nullptr;
-        std::unique_ptr<nvinfer1::ICudaEngine> m_engine = nullptr;
+        std::shared_ptr<EngineModel> m_model = nullptr;
         std::unique_ptr<nvinfer1::IExecutionContext> m_context = nullptr;
 
         NvLogger m_logger{};
         const EngineOptions m_options;
+        EngineLoadTimings m_loadTimings{};
+        std::string m_modelName{};
+
+        // Latencies of the inference phases: host to device copies, enqueue, device to host copies and sync
+        metrics::Histogram *m_inputLatency = nullptr;
+        metrics::Histogram *m_enqueueLatency = nullptr;
+        metrics::Histogram *m_outputLatency = nullptr;
+        const char *m_traceName = nullptr;
+        metrics::AllocationMetrics m_inputAllocations{};
+        metrics::AllocationMetrics m_enqueueAllocations{};
+        metrics::AllocationMetrics m_outputAllocations{};
+    };
+
+    // Load timings of the engines of the process, for startup reports. Models may be loaded concurrently,
+    // so the sum of the phases is not the startup time.
+    class StartupReport
+    {
+    public:
+        static StartupReport &instance();
+
+        void add(const std::string &modelPath, const EngineLoadTimings &timings);
+        nlohmann::json toJson() const;
+
+    private:
+        StartupReport() = default;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::pair<std::string, EngineLoadTimings>> m_engines{};
     };
 
     bool loadEngine(Engine &engine, const std::string &engineModelPath);
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory>
 #include <types/detection.hpp>
+#include <engine/preprocess.hpp>
 
 namespace trt
 {
@@ -14,6 +16,13 @@ namespace trt
 
         // Process multiple frames to get batched detections
         virtual std::vector<std::vector<Detection>> process(const std::vector<cv::Mat> &frames) = 0;
+
+        // Frames identified for a preprocess cache shared with other models, see trt::PreprocessCache
+        virtual std::vector<std::vector<Detection>> process(const std::vector<cv::Mat> &frames, [[maybe_unused]] const std::vector<uint64_t> &frameIds)
+        {
+            return process(frames);
+        }
+        virtual void setPreprocessCache([[maybe_unused]] std::shared_ptr<PreprocessCache> cache, [[maybe_unused]] const std::string &consumer) {}
     };
 
     class ClassificationProcessor
@@ -26,5 +35,15 @@ namespace trt
 
         // Process multiple frames to get batched classifications
         virtual std::vector<Detection> process(const std::vector<cv::Mat> &frames) = 0;
+
+        // Process regions of a frame to get batched classifications, ROIs are normalized like detection boxes
+        virtual std::vector<Detection> process(const cv::Mat &frame, const std::vector<cv::Rect2d> &rois) = 0;
+
+        // Frames identified for a preprocess cache shared with other models, see trt::PreprocessCache
+        virtual std::vector<Detection> process(const std::vector<cv::Mat> &frames, [[maybe_unused]] const std::vector<uint64_t> &frameIds)
+        {
+            return process(frames);
+        }
+        virtual void setPreprocessCache([[maybe_unused]] std::shared_ptr<PreprocessCache> cache, [[maybe_unused]] const std::string &consumer) {}
     };
 }
\ No newline at end of file
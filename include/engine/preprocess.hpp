@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <opencv2/opencv.hpp>
+
+namespace trt
+{
+    enum class ResizeMode
+    {
+        LETTERBOX, // same geometry as letterbox() in utils/detection_utils.hpp
+        STRETCH    // plain bilinear resize to the input size
+    };
+
+    // Image to input tensor conversion of a model. The result is a packed HWC image of the input size,
+    // converted to the planar engine layout when the batch is copied to the device.
+    struct PreprocessDescriptor
+    {
+        cv::Size size{};
+        ResizeMode resize = ResizeMode::LETTERBOX;
+        cv::Scalar padColor{114, 114, 114};
+        bool autoShape = false; // letterbox: pad to a multiple of the stride only
+        bool scaleFill = true;  // letterbox: stretch instead of padding
+        bool scaleUp = false;   // letterbox: upscale images smaller than the input size
+        int stride = 32;
+        bool swapRB = true; // BGR to RGB
+        double scale = 1.0 / 255.0;
+        int type = CV_32FC3;
+
+        auto tie() const
+        {
+            return std::tie(size.width, size.height, resize, padColor[0], padColor[1], padColor[2],
+                            autoShape, scaleFill, scaleUp, stride, swapRB, scale, type);
+        }
+
+        bool operator==(const PreprocessDescriptor &other) const { return tie() == other.tie(); };
+        bool operator!=(const PreprocessDescriptor &other) const { return tie() != other.tie(); };
+        bool operator<(const PreprocessDescriptor &other) const { return tie() < other.tie(); };
+    };
+
+    cv::Mat preprocessImage(const cv::Mat &image, const PreprocessDescriptor &descriptor);
+
+    // Intermediate and output images of preprocessImage, kept by the caller between frames
+    struct PreprocessBuffers
+    {
+        cv::Mat rgb{};
+        cv::Mat resized{};
+        cv::Mat tensor{};
+    };
+
+    // Same conversion into reused buffers, the returned tensor is overwritten by the next call. Nothing is
+    // allocated once the buffers match the frame size, apart from the scratch buffers of cv::resize.
+    const cv::Mat &preprocessImage(const cv::Mat &image, const PreprocessDescriptor &descriptor, PreprocessBuffers &buffers);
+
+    // Input tensors of the frames in flight, shared by the models whose preprocessing is identical.
+    // Consumers (one name per model, whatever its number of instances) declare their descriptor, and a tensor
+    // is computed by the first consumer of a frame and released once every consumer of its descriptor read it.
+    // Descriptors with a single consumer bypass the cache.
+    class PreprocessCache
+    {
+    public:
+        // Frames older than the last maxFrames ones are evicted, in case a consumer skipped them
+        explicit PreprocessCache(size_t maxFrames = 16) : m_maxFrames(maxFrames) {};
+
+        void addConsumer(const PreprocessDescriptor &descriptor, const std::string &consumer);
+
+        // Frame ids are unique per source image, e.g. the sequence number of a stream
+        cv::Mat get(uint64_t frameId, const cv::Mat &image, const PreprocessDescriptor &descriptor, const std::string &consumer);
+
+        [[nodiscard]] uint64_t getHits() const { return m_hits; };
+        [[nodiscard]] uint64_t getMisses() const { return m_misses; };
+
+    private:
+        struct Entry
+        {
+            std::shared_future<cv::Mat> tensor{};
+            std::set<std::string> readers{};
+        };
+
+        const size_t m_maxFrames;
+        std::mutex m_mutex;
+        std::map<PreprocessDescriptor, std::set<std::string>> m_consumers{};
+        std::map<std::pair<uint64_t, PreprocessDescriptor>, Entry> m_entries{};
+        uint64_t m_lastFrameId = 0;
+        std::atomic<uint64_t> m_hits{0};
+        std::atomic<uint64_t> m_misses{0};
+    };
+
+} // namespace trt
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "engine.hpp"
+#include "preprocess.hpp"
+#include "metrics/allocations.hpp"
+#include "metrics/trace.hpp"
 
 namespace trt
 {
@@ -14,18 +17,67 @@ namespace trt
         // Image & batch inference
         OutputType process(const cv::Mat &image);
         std::vector<OutputType> process(const std::vector<cv::Mat> &imageBatch);
+        // Batch inference over frames identified for the preprocess cache, see setPreprocessCache()
+        std::vector<OutputType> process(const std::vector<cv::Mat> &imageBatch, const std::vector<uint64_t> &frameIds);
+        // Batch inference over regions of an image, ROIs are normalized like detection boxes
+        std::vector<OutputType> process(const cv::Mat &image, const std::vector<cv::Rect2d> &rois);
+
+        // Spatial size of the engine input, images larger than this are downscaled by preprocessing
+        cv::Size getInputSize() const;
+
+        const PreprocessDescriptor &getPreprocessDescriptor() const { return preprocessing; };
+        // Share the input tensors of identified frames with the other consumers of the cache, the consumer names
+        // a model and is the same for all its instances
+        void setPreprocessCache(std::shared_ptr<PreprocessCache> cache, const std::string &consumer);
+
+    protected:
+        // Processor without an engine, only the preprocessing and postprocessing stages can run, e.g. on recorded
+        // engine outputs. Its metrics are labeled with the given model name.
+        ModelProcessor(const std::string &name, const cv::Size &inputSize);
+
+        // Stages of the batch inference. The returned batches belong to the processor and are reused by the next
+        // call, nothing is allocated by the stages once warm except by the engine and the cache.
+        const std::vector<cv::Mat> &preprocessBatch(const std::vector<cv::Mat> &imageBatch, const std::vector<uint64_t> &frameIds);
+        const std::vector<EngineOutput> &inferBatch(const std::vector<cv::Mat> &processedBatch);
+        std::vector<OutputType> postprocessBatch(const std::vector<EngineOutput> &featureBatch);
 
     private:
-        // Image & batch preprocessing
-        virtual bool preprocess(const cv::Mat &srcImg, cv::Mat &dstImg) = 0;
-        bool preprocess(const std::vector<cv::Mat> &inputBatch, std::vector<cv::Mat> &outputBatch);
+        void initMetrics(const std::string &name);
 
-        // Image & batch postprocessing
+        // Image preprocessing
+        bool preprocess(const cv::Mat &srcImg, cv::Mat &dstImg);
+
+        // Image postprocessing
         virtual OutputType postprocess(const EngineOutput &featureVector) = 0;
-        std::vector<OutputType> postprocess(const std::vector<EngineOutput> &featureBatch);
 
     protected:
         std::unique_ptr<Engine> engine = nullptr;
+        // Letterboxed RGB input by default, models adjust it in their constructor
+        PreprocessDescriptor preprocessing{};
+
+    private:
+        std::shared_ptr<PreprocessCache> preprocessCache = nullptr;
+        std::string preprocessConsumer{};
+
+        // Buffers of the stages, one preprocessing buffer per image of the largest batch
+        std::vector<PreprocessBuffers> preprocessBuffers{};
+        std::vector<cv::Mat> processedImages{};
+        std::vector<cv::Mat> inferenceBatch{};
+        std::vector<EngineOutput> inferenceOutputs{};
+        std::vector<EngineOutput> featureVectors{};
+
+        // Stage latencies, engine batch sizes and processed images, labeled by model
+        metrics::Histogram *preprocessLatency = nullptr;
+        metrics::Histogram *inferenceLatency = nullptr;
+        metrics::Histogram *postprocessLatency = nullptr;
+        metrics::Histogram *batchSizes = nullptr;
+        metrics::Counter *images = nullptr;
+        // Heap allocations of each stage, with -Dalloc_tracking=true
+        metrics::AllocationMetrics preprocessAllocations{};
+        metrics::AllocationMetrics inferenceAllocations{};
+        metrics::AllocationMetrics postprocessAllocations{};
+        // Model name in the trace spans
+        const char *traceName = nullptr;
     };
 } // namespace trt
 
@@ -2,7 +2,7 @@
 
 #include "processor.hpp"
 #include <opencv2/opencv.hpp>
-#include <utils/vector_utils.hpp>
+#include "utils/tensorrt_utils.hpp"
 
 namespace trt
 {
@@ -16,6 +16,58 @@ namespace trt
         // Load engine
         engine = std::make_unique<Engine>(options);
         loadEngine(*engine, config.modelPath);
+        if (config.warmup && !engine->warmUp())
+        {
+            throw std::runtime_error("Engine warm-up failed");
+        }
+        StartupReport::instance().add(config.modelPath, engine->getLoadTimings());
+        preprocessing.size = getInputSize();
+        initMetrics(engine->getModelName());
+    }
+
+    template <typename OutputType, typename EngineOutput>
+    ModelProcessor<OutputType, EngineOutput>::ModelProcessor(const std::string &name, const cv::Size &inputSize)
+    {
+        preprocessing.size = inputSize;
+        initMetrics(name);
+    }
+
+    template <typename OutputType, typename EngineOutput>
+    void ModelProcessor<OutputType, EngineOutput>::initMetrics(const std::string &name)
+    {
+        auto &registry = metrics::Registry::instance();
+        const metrics::Labels labels = {{"model", name}};
+        preprocessLatency = &registry.latency("trt_preprocess_seconds", labels);
+        inferenceLatency = &registry.latency("trt_inference_seconds", labels);
+        postprocessLatency = &registry.latency("trt_postprocess_seconds", labels);
+        batchSizes = &registry.histogram("trt_batch_size", labels);
+        images = &registry.counter("trt_images_total", labels);
+        traceName = metrics::Tracer::instance().intern(name);
+        preprocessAllocations = metrics::getAllocationMetrics({{"model", name}, {"stage", "preprocess"}});
+        inferenceAllocations = metrics::getAllocationMetrics({{"model", name}, {"stage", "inference"}});
+        postprocessAllocations = metrics::getAllocationMetrics({{"model", name}, {"stage", "postprocess"}});
+    }
+
+    template <typename OutputType, typename EngineOutput>
+    cv::Size ModelProcessor<OutputType, EngineOutput>::getInputSize() const
+    {
+        if (!engine)
+        {
+            return preprocessing.size;
+        }
+        const auto &inputDims = engine->getInputDims();
+        return inputDims.empty() ? cv::Size() : cv::Size(inputDims[0].d[2], inputDims[0].d[1]);
+    }
+
+    template <typename OutputType, typename EngineOutput>
+    void ModelProcessor<OutputType, EngineOutput>::setPreprocessCache(std::shared_ptr<PreprocessCache> cache, const std::string &consumer)
+    {
+        preprocessCache = std::move(cache);
+        preprocessConsumer = consumer;
+        if (preprocessCache)
+        {
+            preprocessCache->addConsumer(preprocessing, consumer);
+        }
     }
 
     template <typename OutputType, typename EngineOutput>
@@ -26,84 +78,137 @@ namespace trt
             throw std::invalid_argument("Input image is empty");
         }
 
+        if (!engine)
+        {
+            throw std::runtime_error("Model has no engine");
+        }
+
         cv::Mat processedImage;
         EngineOutput featureVector;
 
-        if (!preprocess(image, processedImage))
         {
-            throw std::runtime_error("Model preprocessing failed");
+            metrics::ScopedTimer timer(*preprocessLatency);
+            metrics::TraceSpan span("preprocess", traceName);
+            metrics::AllocationScope allocations(preprocessAllocations);
+            if (!preprocess(image, processedImage))
+            {
+                throw std::runtime_error("Model preprocessing failed");
+            }
         }
-        if (!engine->runInference(processedImage, featureVector))
         {
-            throw std::runtime_error("Model inference failed");
+            metrics::ScopedTimer timer(*inferenceLatency);
+            metrics::TraceSpan span("inference", traceName);
+            metrics::AllocationScope allocations(inferenceAllocations);
+            if (!engine->runInference(processedImage, featureVector))
+            {
+                throw std::runtime_error("Model inference failed");
+            }
         }
+        batchSizes->record(1);
+        images->add();
+
+        metrics::ScopedTimer timer(*postprocessLatency);
+        metrics::TraceSpan span("postprocess", traceName);
+        metrics::AllocationScope allocations(postprocessAllocations);
         return postprocess(featureVector);
     }
 
     template <typename OutputType, typename EngineOutput>
     std::vector<OutputType> ModelProcessor<OutputType, EngineOutput>::process(const std::vector<cv::Mat> &imageBatch)
+    {
+        return process(imageBatch, {});
+    }
+
+    template <typename OutputType, typename EngineOutput>
+    std::vector<OutputType> ModelProcessor<OutputType, EngineOutput>::process(const std::vector<cv::Mat> &imageBatch, const std::vector<uint64_t> &frameIds)
     {
         if (imageBatch.empty())
         {
             return {};
         }
-
-        // Pre-allocate memory
-        std::vector<cv::Mat> processedBatch;
-        processedBatch.reserve(imageBatch.size());
-
-        std::vector<EngineOutput> featureBatch;
-        featureBatch.reserve(imageBatch.size());
-
-        if (!preprocess(imageBatch, processedBatch))
+        if (!frameIds.empty() && frameIds.size() != imageBatch.size())
         {
-            throw std::runtime_error("Batched model preprocessing failed");
+            throw std::invalid_argument("Frame ids do not match the image batch");
         }
 
-        const size_t maxBatchSize = static_cast<size_t>(engine->getOptions().maxBatchSize);
+        const auto &processedBatch = preprocessBatch(imageBatch, frameIds);
+        const auto &featureBatch = inferBatch(processedBatch);
+        images->add(imageBatch.size());
+        return postprocessBatch(featureBatch);
+    }
 
-        // Process in batches
-        std::vector<cv::Mat> images;
-        images.reserve(maxBatchSize);
+    template <typename OutputType, typename EngineOutput>
+    const std::vector<cv::Mat> &ModelProcessor<OutputType, EngineOutput>::preprocessBatch(const std::vector<cv::Mat> &imageBatch, const std::vector<uint64_t> &frameIds)
+    {
+        metrics::ScopedTimer timer(*preprocessLatency);
+        metrics::TraceSpan span("preprocess", traceName);
+        metrics::AllocationScope allocations(preprocessAllocations);
 
-        std::vector<EngineOutput> features;
-        features.reserve(maxBatchSize);
+        // Frames without an id, e.g. crops, are never cached
+        const bool cached = preprocessCache && frameIds.size() == imageBatch.size();
+        if (preprocessBuffers.size() < imageBatch.size())
+        {
+            preprocessBuffers.resize(imageBatch.size());
+        }
 
-        for (size_t i = 0; i < processedBatch.size(); i += maxBatchSize)
+        processedImages.clear();
+        for (size_t i = 0; i < imageBatch.size(); ++i)
         {
-            const size_t batchSize = std::min(maxBatchSize, processedBatch.size() - i);
-            images = vector_ops::slice(processedBatch, i, i + batchSize);
-            if (!engine->runInference(images, features))
+            if (cached)
+            {
+                processedImages.push_back(preprocessCache->get(frameIds[i], imageBatch[i], preprocessing, preprocessConsumer));
+            }
+            else
+            {
+                processedImages.push_back(preprocessImage(imageBatch[i], preprocessing, preprocessBuffers[i]));
+            }
+            if (processedImages.back().empty())
             {
-                throw std::runtime_error("Batched model inference failed");
+                throw std::runtime_error("Batched model preprocessing failed");
             }
-            featureBatch.insert(featureBatch.end(),
-                                std::make_move_iterator(features.begin()),
-                                std::make_move_iterator(features.end()));
         }
-
-        return postprocess(featureBatch);
+        return processedImages;
     }
 
     template <typename OutputType, typename EngineOutput>
-    bool ModelProcessor<OutputType, EngineOutput>::preprocess(const std::vector<cv::Mat> &inputBatch, std::vector<cv::Mat> &outputBatch)
+    const std::vector<EngineOutput> &ModelProcessor<OutputType, EngineOutput>::inferBatch(const std::vector<cv::Mat> &processedBatch)
     {
-        outputBatch.reserve(inputBatch.size());
-        cv::Mat processedImage;
-        for (const auto &image : inputBatch)
+        if (!engine)
         {
-            if (!preprocess(image, processedImage))
+            throw std::runtime_error("Model has no engine");
+        }
+
+        // Process in batches
+        const size_t maxBatchSize = static_cast<size_t>(engine->getOptions().maxBatchSize);
+        featureVectors.clear();
+        for (size_t i = 0; i < processedBatch.size(); i += maxBatchSize)
+        {
+            const size_t batchSize = std::min(maxBatchSize, processedBatch.size() - i);
+            inferenceBatch.assign(processedBatch.begin() + i, processedBatch.begin() + i + batchSize);
             {
-                return false;
+                metrics::ScopedTimer timer(*inferenceLatency);
+                metrics::TraceSpan span("inference", traceName);
+                metrics::AllocationScope allocations(inferenceAllocations);
+                if (!engine->runInference(inferenceBatch, inferenceOutputs))
+                {
+                    throw std::runtime_error("Batched model inference failed");
+                }
             }
-            outputBatch.push_back(processedImage);
+            batchSizes->record(batchSize);
+            featureVectors.insert(featureVectors.end(),
+                                  std::make_move_iterator(inferenceOutputs.begin()),
+                                  std::make_move_iterator(inferenceOutputs.end()));
         }
-        return true;
+        return featureVectors;
     }
 
     template <typename OutputType, typename EngineOutput>
-    std::vector<OutputType> ModelProcessor<OutputType, EngineOutput>::postprocess(const std::vector<EngineOutput> &featureBatch)
+    std::vector<OutputType> ModelProcessor<OutputType, EngineOutput>::postprocessBatch(const std::vector<EngineOutput> &featureBatch)
     {
+        metrics::ScopedTimer timer(*postprocessLatency);
+        metrics::TraceSpan span("postprocess", traceName);
+        metrics::AllocationScope allocations(postprocessAllocations);
+
         // Multi batch SISO postprocessing (MBSISO)
         std::vector<OutputType> outputs;
         outputs.reserve(featureBatch.size());
@@ -117,4 +222,33 @@ namespace trt
         return outputs;
     }
 
+    template <typename OutputType, typename EngineOutput>
+    std::vector<OutputType> ModelProcessor<OutputType, EngineOutput>::process(const cv::Mat &image, const std::vector<cv::Rect2d> &rois)
+    {
+        if (image.empty())
+        {
+            throw std::invalid_argument("Input image is empty");
+        }
+
+        // Crops are views on the image, they are only copied once preprocessed into the batch
+        std::vector<cv::Mat> crops;
+        crops.reserve(rois.size());
+        for (const auto &roi : rois)
+        {
+            crops.push_back(image(toPixelRect(roi, image.size())));
+        }
+        return process(crops);
+    }
+
+    template <typename OutputType, typename EngineOutput>
+    bool ModelProcessor<OutputType, EngineOutput>::preprocess(const cv::Mat &srcImg, cv::Mat &dstImg)
+    {
+        if (preprocessBuffers.empty())
+        {
+            preprocessBuffers.resize(1);
+        }
+        dstImg = preprocessImage(srcImg, preprocessing, preprocessBuffers.front());
+        return !dstImg.empty();
+    }
+
 } // namespace trt
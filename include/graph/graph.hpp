@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include <graph/node.hpp>
+
+namespace graph
+{
+    // Processing graph declared in the "graph" section of a config file:
+    //   {"graph": {"nodes": [{"name": "source", "type": "source", "input": "video.mp4"},
+    //                        {"name": "detector", "type": "detector", "inputs": ["source"], "batch": 8}, ...]}}
+    // Every node runs its own workers behind a bounded input queue. A packet sent to several nodes is copied,
+    // so that branches run in parallel, and nodes with several inputs merge the branches of each frame.
+    class Graph
+    {
+    public:
+        Graph(const std::string &configPath);
+        Graph(const GraphContext &t_context);
+        ~Graph();
+
+        Graph(const Graph &) = delete;
+        Graph &operator=(const Graph &) = delete;
+
+        // Blocks until the source is exhausted or the graph is stopped, rethrows the first node error
+        void run();
+        // Stop reading the source, packets already read still go through the graph
+        void stop() { m_running = false; };
+
+        // Per node packet counts, busy time and queue length
+        nlohmann::json getStats() const;
+
+    private:
+        struct Stage;
+
+        void work(Stage &stage, size_t worker);
+        void emit(Stage &stage, PacketPtr packet);
+        void deliver(Stage &stage, PacketPtr packet);
+        void closeInput(Stage &stage);
+        void fail(std::exception_ptr error);
+
+        std::vector<std::unique_ptr<Stage>> m_stages{};
+        std::atomic<bool> m_running{false};
+        std::mutex m_errorMutex;
+        std::exception_ptr m_error = nullptr;
+    };
+
+    // Merge the detections of another branch of the same frame: labels, features, masks and track ids
+    void mergeDetections(std::vector<Detection> &detections, const std::vector<Detection> &other);
+
+} // namespace graph
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <opencv2/opencv.hpp>
+#include <types/detection.hpp>
+#include <engine/preprocess.hpp>
+
+namespace graph
+{
+    // A frame flowing through the graph. The image is shared between branches and must not be modified in place.
+    struct Packet
+    {
+        uint64_t sequence = 0; // position in the source stream, used to join branches and restore order
+        int64_t frameIndex = 0;
+        double timestamp = 0.0; // ms
+        cv::Mat image{};
+        std::vector<Detection> detections{};
+        std::map<std::string, Detection> classifications{}; // classes of the whole frame, by frame classifier node
+    };
+
+    using PacketPtr = std::shared_ptr<Packet>;
+
+    // Node declaration of a graph config:
+    //   {"name": "reid", "type": "reid", "inputs": ["detector"], "workers": 2, "queue": 8, "batch": 1, ...}
+    // Other keys are parameters of the node type.
+    struct NodeConfig
+    {
+        std::string name{};
+        std::string type{};
+        std::vector<std::string> inputs{};
+        size_t workers = 1;   // node instances processing packets concurrently
+        size_t queueSize = 8; // packets buffered at the node input
+        size_t batchSize = 1; // packets per process() call, at most
+        nlohmann::json params = nlohmann::json::object();
+
+        void loadFromJson(const nlohmann::json &data);
+    };
+
+    // Whole config file, model nodes load their model from its sections.
+    // Model nodes with the same input geometry share the input tensors of each frame through the preprocess cache.
+    struct GraphContext
+    {
+        std::string configPath{};
+        nlohmann::json config{};
+        std::shared_ptr<trt::PreprocessCache> preprocessCache = nullptr;
+    };
+
+    class Node
+    {
+    public:
+        virtual ~Node() = default;
+
+        // Source nodes have no input and produce packets until they return false
+        virtual bool read([[maybe_unused]] Packet &packet) { return false; };
+
+        // Process a batch of packets in place, instances of a node run concurrently
+        virtual void process(std::vector<PacketPtr> &packets) = 0;
+
+        // Ordered nodes are stateful: they run on a single worker and see packets in sequence order
+        virtual bool isOrdered() const { return false; };
+
+        // Called once after the last packet
+        virtual void close() {};
+    };
+
+    using NodeFactory = std::function<std::unique_ptr<Node>(const NodeConfig &, const GraphContext &)>;
+
+    // Node types by name, built-in types are registered on first use
+    class NodeRegistry
+    {
+    public:
+        static NodeRegistry &instance();
+
+        void add(const std::string &type, NodeFactory factory);
+        std::unique_ptr<Node> create(const NodeConfig &node, const GraphContext &context) const;
+
+        bool contains(const std::string &type) const;
+        std::vector<std::string> getTypes() const;
+
+    private:
+        NodeRegistry();
+
+        mutable std::mutex m_mutex;
+        std::map<std::string, NodeFactory> m_factories{};
+    };
+
+} // namespace graph
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+#include "io/result_writer.hpp"
+
+namespace io
+{
+    // Columnar detection log, made of self-indexed chunks that can be memory-mapped:
+    //   file   : FileHeader | chunk...
+    //   chunk  : ChunkHeader | ClassIndexEntry[numClasses] | int32 track ids[numTracks] | columns
+    //   columns: int64 frame | float64 timestamp | float32 x, y, w, h | float32 confidence | int32 class id | int32 track id
+    // Every block starts on an 8 byte boundary, values are stored in host byte order.
+    namespace log
+    {
+        static constexpr char FILE_MAGIC[4] = {'T', 'R', 'V', 'L'};
+        static constexpr char CHUNK_MAGIC[4] = {'C', 'H', 'N', 'K'};
+        static constexpr uint32_t VERSION = 1;
+
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint64_t reserved;
+        };
+
+        struct ChunkHeader
+        {
+            char magic[4];
+            uint32_t rowCount;
+            uint64_t chunkSize;
+            int64_t firstFrame;
+            int64_t lastFrame;
+            double firstTimestamp;
+            double lastTimestamp;
+            float maxConfidence;
+            uint32_t numClasses;
+            uint32_t numTracks;
+            uint32_t reserved;
+        };
+
+        struct ClassIndexEntry
+        {
+            int32_t classId;
+            uint32_t count;
+            float maxConfidence;
+            uint32_t reserved;
+        };
+
+        static_assert(sizeof(FileHeader) == 16, "Unexpected detection log header size");
+        static_assert(sizeof(ChunkHeader) == 64, "Unexpected detection log chunk header size");
+        static_assert(sizeof(ClassIndexEntry) == 16, "Unexpected detection log class index size");
+    } // namespace log
+
+    // Appends results as columnar chunks of at most `chunkRows` detections
+    class DetectionLogWriter : public ResultWriter
+    {
+    public:
+        DetectionLogWriter(std::ostream &stream, size_t chunkRows = 65536);
+
+        void write(const FrameResult &result) override;
+        // Chunks are only cut when full, flushing does not create small chunks
+        void flush() override { m_stream.flush(); };
+        void close() override;
+
+    private:
+        void writeChunk();
+
+        std::ostream &m_stream;
+        const size_t m_chunkRows;
+
+        bool m_hasFrames = false;
+        int64_t m_firstFrame = 0;
+        int64_t m_lastFrame = 0;
+        double m_firstTimestamp = 0.0;
+        double m_lastTimestamp = 0.0;
+
+        std::vector<int64_t> m_frames{};
+        std::vector<double> m_timestamps{};
+        std::vector<float> m_x{}, m_y{}, m_width{}, m_height{};
+        std::vector<float> m_confidences{};
+        std::vector<int32_t> m_classIds{};
+        std::vector<int32_t> m_trackIds{};
+    };
+
+    struct DetectionQuery
+    {
+        std::optional<int32_t> classId{};
+        std::optional<int32_t> trackId{};
+        float minConfidence = 0.f;
+        int64_t firstFrame = std::numeric_limits<int64_t>::min();
+        int64_t lastFrame = std::numeric_limits<int64_t>::max();
+        double fromTimestamp = std::numeric_limits<double>::lowest();
+        double toTimestamp = std::numeric_limits<double>::max();
+    };
+
+    struct DetectionRow
+    {
+        int64_t frameIndex = 0;
+        double timestamp = 0.0;
+        cv::Rect2f bbox{};
+        float confidence = 0.f;
+        int32_t classId = -1;
+        int32_t trackId = -1;
+    };
+
+    // Read-only, memory-mapped view of a detection log
+    class DetectionLog
+    {
+    public:
+        explicit DetectionLog(const std::string &path);
+        ~DetectionLog();
+
+        DetectionLog(const DetectionLog &) = delete;
+        DetectionLog &operator=(const DetectionLog &) = delete;
+
+        // Matching detections in log order, chunks are skipped based on their index blocks
+        std::vector<DetectionRow> query(const DetectionQuery &query) const;
+
+        [[nodiscard]] size_t getNumChunks() const { return m_chunks.size(); };
+        [[nodiscard]] uint64_t getNumRows() const;
+
+    private:
+        struct Chunk
+        {
+            const log::ChunkHeader *header = nullptr;
+            const log::ClassIndexEntry *classes = nullptr;
+            const int32_t *tracks = nullptr;
+            const int64_t *frames = nullptr;
+            const double *timestamps = nullptr;
+            const float *x = nullptr, *y = nullptr, *width = nullptr, *height = nullptr;
+            const float *confidences = nullptr;
+            const int32_t *classIds = nullptr;
+            const int32_t *trackIds = nullptr;
+        };
+
+        bool mayMatch(const Chunk &chunk, const DetectionQuery &query) const;
+
+        int m_fd = -1;
+        const char *m_data = nullptr;
+        size_t m_size = 0;
+        std::vector<Chunk> m_chunks{};
+    };
+
+} // namespace io
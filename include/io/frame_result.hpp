@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <types/detection.hpp>
+
+namespace io
+{
+
+    // Detections of a single video frame
+    struct FrameResult
+    {
+        int64_t frameIndex = 0;
+        double timestamp = 0.0; // ms
+        std::vector<Detection> detections{};
+        // Classes of the whole frame by classifier, only written by the JSON format
+        std::map<std::string, Detection> classifications{};
+    };
+
+    inline nlohmann::json toJson(const Detection &det)
+    {
+        nlohmann::json json = {
+            {"class_id", det.class_id},
+            {"class_name", det.class_name},
+            {"confidence", det.confidence},
+            {"track_id", det.track_id},
+            {"bbox", {det.bbox.x, det.bbox.y, det.bbox.width, det.bbox.height}}};
+
+        // Labels of a secondary classifier, if any
+        if (!det.labels.empty())
+        {
+            json["labels"] = nlohmann::json::object();
+            for (const auto &[id, name] : det.labels)
+                json["labels"][std::to_string(id)] = name;
+        }
+        return json;
+    }
+
+    inline nlohmann::json toJson(const FrameResult &result)
+    {
+        nlohmann::json detections = nlohmann::json::array();
+        for (const auto &det : result.detections)
+        {
+            detections.push_back(toJson(det));
+        }
+        nlohmann::json json = {
+            {"frame", result.frameIndex},
+            {"timestamp", result.timestamp},
+            {"detections", std::move(detections)}};
+
+        if (!result.classifications.empty())
+        {
+            json["classifications"] = nlohmann::json::object();
+            for (const auto &[name, det] : result.classifications)
+                json["classifications"][name] = {{"class_id", det.class_id}, {"class_name", det.class_name}, {"confidence", det.confidence}};
+        }
+        return json;
+    }
+
+} // namespace io
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace io
+{
+    // Image paths of an image, a directory (sorted) or a list file (.txt, .lst) with one path per line
+    std::vector<std::string> listImages(const std::string &input);
+    // Whether the input names several images rather than a single one
+    bool isImageList(const std::string &input);
+
+    // Size of a JPEG or PNG image from its header, empty if unknown
+    cv::Size readImageSize(const std::vector<uint8_t> &buffer);
+    // Color decode flags with the largest JPEG reduction (1/2, 1/4, 1/8) that keeps the image larger than `target`
+    int getDecodeFlags(const std::vector<uint8_t> &buffer, const cv::Size &target);
+
+    // Read an image at the smallest resolution that still covers `target`, at full resolution if `target` is empty
+    cv::Mat readImage(const std::string &path, const cv::Size &target = cv::Size());
+
+    // Read whole files in parallel, empty buffers for unreadable files
+    std::vector<std::vector<uint8_t>> readFiles(const std::vector<std::string> &paths, size_t numThreads = 0);
+    // Decode color images in parallel like readImage, empty images for undecodable buffers
+    std::vector<cv::Mat> decodeImages(const std::vector<std::vector<uint8_t>> &buffers, size_t numThreads = 0, const cv::Size &target = cv::Size());
+    std::vector<cv::Mat> readImages(const std::vector<std::string> &paths, size_t numThreads = 0, const cv::Size &target = cv::Size());
+
+    // FNV-1a hash of a buffer
+    uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+} // namespace io
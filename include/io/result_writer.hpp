@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "io/frame_result.hpp"
+
+namespace io
+{
+    enum class ResultFormat
+    {
+        JSONL,
+        BINARY,
+        COLUMNAR,
+        UNKNOWN
+    };
+
+    inline std::string getResultFormatName(ResultFormat format)
+    {
+        switch (format)
+        {
+        case ResultFormat::JSONL:
+            return "json";
+        case ResultFormat::BINARY:
+            return "binary";
+        case ResultFormat::COLUMNAR:
+            return "columnar";
+        default:
+            throw std::runtime_error("Unknown result format");
+        }
+    };
+
+    inline auto &getResultFormats()
+    {
+        static std::array<ResultFormat, 3> formats{
+            ResultFormat::JSONL,
+            ResultFormat::BINARY,
+            ResultFormat::COLUMNAR};
+
+        return formats;
+    };
+
+    inline ResultFormat getResultFormat(const std::string &name)
+    {
+        std::string lower_name = name;
+        std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::tolower);
+
+        for (const auto &format : getResultFormats())
+        {
+            if (lower_name == getResultFormatName(format))
+            {
+                return format;
+            }
+        }
+        return ResultFormat::UNKNOWN;
+    };
+
+    class ResultWriter
+    {
+    public:
+        virtual ~ResultWriter() = default;
+        virtual void write(const FrameResult &result) = 0;
+        virtual void flush() = 0;
+        // Called once after the last result
+        virtual void close() { flush(); };
+    };
+
+    // One JSON object per line
+    class JsonLinesWriter : public ResultWriter
+    {
+    public:
+        JsonLinesWriter(std::ostream &stream, bool embeddings = false) : m_stream(stream), m_embeddings(embeddings) {}
+
+        void write(const FrameResult &result) override;
+        void flush() override { m_stream.flush(); };
+
+    private:
+        std::ostream &m_stream;
+        const bool m_embeddings;
+    };
+
+    // Length-prefixed binary records, all values in host byte order:
+    //   header : char[4] "TRVR" | uint32 version
+    //   record : uint32 payload size | int64 frame index | float64 timestamp (ms) | uint32 detection count | detections
+    //   detection : float32 x, y, w, h | float32 confidence | int32 class id | int32 track id | uint32 embedding size | float32 embedding[]
+    class BinaryResultWriter : public ResultWriter
+    {
+    public:
+        static constexpr char MAGIC[4] = {'T', 'R', 'V', 'R'};
+        static constexpr uint32_t VERSION = 1;
+
+        BinaryResultWriter(std::ostream &stream, bool embeddings = false);
+
+        void write(const FrameResult &result) override;
+        void flush() override { m_stream.flush(); };
+
+    private:
+        std::ostream &m_stream;
+        const bool m_embeddings;
+        std::string m_buffer{};
+    };
+
+    // Reads records written by BinaryResultWriter
+    class BinaryResultReader
+    {
+    public:
+        explicit BinaryResultReader(std::istream &stream);
+
+        // False at the end of the stream
+        bool read(FrameResult &result);
+
+    private:
+        std::istream &m_stream;
+        std::string m_buffer{};
+    };
+
+    // Writes results on a dedicated thread to keep I/O off the inference path
+    class AsyncResultWriter
+    {
+    public:
+        // Write to a file, or to stdout when path is "-"
+        AsyncResultWriter(const std::string &path, ResultFormat format, bool embeddings = false, size_t capacity = 1024);
+        ~AsyncResultWriter();
+
+        AsyncResultWriter(const AsyncResultWriter &) = delete;
+        AsyncResultWriter &operator=(const AsyncResultWriter &) = delete;
+
+        // Blocks only when the writer falls more than `capacity` results behind
+        void write(FrameResult &&result);
+        // Write all pending results and stop the writer thread
+        void close();
+
+    private:
+        void writeLoop();
+
+        std::ofstream m_file{};
+        std::unique_ptr<ResultWriter> m_writer = nullptr;
+        const size_t m_capacity;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::deque<FrameResult> m_queue{};
+        bool m_closed = false;
+        std::thread m_thread;
+    };
+
+} // namespace io
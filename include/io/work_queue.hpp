@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace io
+{
+    // Items split in fixed-size chunks, shared by any number of processes through a directory:
+    //   queue.json         : item count, chunk size and item list hash, checked when resuming
+    //   items.txt          : the items, one per line, in chunk order
+    //   chunk-000000.lock  : locked with flock() while a worker owns the chunk, released if the worker dies
+    //   chunk-000000.done  : checkpoint, created once the chunk is complete
+    // Locks rely on flock(), the directory must be local or on a file system that supports it.
+    class FileWorkQueue
+    {
+    public:
+        FileWorkQueue(const std::string &directory, const std::vector<std::string> &items, size_t chunkSize);
+        ~FileWorkQueue();
+
+        FileWorkQueue(const FileWorkQueue &) = delete;
+        FileWorkQueue &operator=(const FileWorkQueue &) = delete;
+
+        // Next chunk that is neither complete nor owned by another worker
+        std::optional<size_t> claim();
+        // Checkpoint a claimed chunk and release it
+        void complete(size_t chunk);
+        // Release a claimed chunk unfinished, another worker picks it up
+        void release(size_t chunk);
+
+        // Item range [begin, end) of a chunk
+        std::pair<size_t, size_t> getRange(size_t chunk) const;
+        // Path of a per-chunk file in the queue directory
+        std::string getPath(size_t chunk, const std::string &extension) const;
+
+        [[nodiscard]] size_t getNumChunks() const { return m_numChunks; };
+        [[nodiscard]] size_t getNumCompleted() const;
+        [[nodiscard]] bool isCompleted(size_t chunk) const;
+
+    private:
+        const std::string m_directory;
+        const size_t m_numItems;
+        const size_t m_chunkSize;
+        const size_t m_numChunks;
+
+        std::mutex m_mutex;
+        std::map<size_t, int> m_locks{};
+        size_t m_next = 0;
+    };
+
+} // namespace io
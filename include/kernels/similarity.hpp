@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace kernels
+{
+
+    enum class Isa
+    {
+        SCALAR,
+        AVX2,
+        AVX512,
+        NEON,
+        UNKNOWN
+    };
+
+    inline std::string getIsaName(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::SCALAR:
+            return "scalar";
+        case Isa::AVX2:
+            return "avx2";
+        case Isa::AVX512:
+            return "avx512";
+        case Isa::NEON:
+            return "neon";
+        default:
+            return "unknown";
+        }
+    }
+
+    inline const std::array<Isa, 4> &getIsas()
+    {
+        static const std::array<Isa, 4> isas = {Isa::SCALAR, Isa::AVX2, Isa::AVX512, Isa::NEON};
+        return isas;
+    }
+
+    inline Isa getIsa(const std::string &name)
+    {
+        for (auto isa : getIsas())
+        {
+            if (getIsaName(isa) == name)
+                return isa;
+        }
+        return Isa::UNKNOWN;
+    }
+
+    // Whether the kernels of an instruction set are built and supported by this CPU
+    bool isSupported(Isa isa);
+    // Instruction set used by the kernels, the best supported one unless overridden
+    Isa getActiveIsa();
+    // Override the instruction set, returns false if not supported
+    bool setActiveIsa(Isa isa);
+
+    // Row-major embeddings: fp32 (CV_32F), fp16 (CV_16F) or int8 (CV_8S) with one CV_32F scale per row
+    struct Embeddings
+    {
+        cv::Mat data{};
+        cv::Mat scales{};
+
+        Embeddings() = default;
+        Embeddings(const cv::Mat &data, const cv::Mat &scales = cv::Mat()) : data(data), scales(scales) {}
+
+        [[nodiscard]] int rows() const { return data.rows; };
+        [[nodiscard]] int dims() const { return data.cols; };
+
+        // Convert fp32 embeddings to fp32, fp16 or int8 (symmetric per-row scale)
+        static Embeddings quantize(const cv::Mat &embeddings, int depth);
+    };
+
+    struct Match
+    {
+        int index = -1;
+        float score = 0.f;
+    };
+
+    // L2-normalize fp32 embeddings in place, one per row
+    void normalize(cv::Mat &embeddings);
+    void normalize(std::vector<float> &embedding);
+
+    // Cosine similarity of two embeddings
+    float cosine(const std::vector<float> &a, const std::vector<float> &b);
+
+    // Cosine similarity and L2 distance matrices, a.rows() x b.rows() CV_32F
+    cv::Mat cosine(const Embeddings &a, const Embeddings &b);
+    cv::Mat l2(const Embeddings &a, const Embeddings &b);
+
+    // Dot products of query row q against the listed gallery rows, the cosine similarity of normalized embeddings
+    void dot(const Embeddings &queries, int q, const Embeddings &gallery, const int32_t *indices, size_t count, float *out);
+
+    // Most similar gallery embedding of each query, without materializing the similarity matrix
+    std::vector<Match> argmax(const Embeddings &queries, const Embeddings &gallery);
+    // Top k most similar gallery embeddings of each query, sorted by decreasing cosine similarity
+    std::vector<std::vector<Match>> topK(const Embeddings &queries, const Embeddings &gallery, size_t k);
+
+} // namespace kernels
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <metrics/metrics.hpp>
+
+namespace metrics
+{
+    // Heap allocations made by a thread, counted by the global operator new and the cv::Mat allocator when the
+    // library is built with -Dalloc_tracking=true, always zero otherwise. Allocations made inside OpenCV count
+    // as well, e.g. the scratch buffers of cv::resize.
+    struct AllocationStats
+    {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+#ifdef TRT_ALLOC_TRACKING
+    constexpr bool ALLOCATION_TRACKING = true;
+#else
+    constexpr bool ALLOCATION_TRACKING = false;
+#endif
+
+    // Allocations of the calling thread since it started
+    AllocationStats getThreadAllocations();
+
+    // Allocations per scope and allocated bytes of a stage
+    struct AllocationMetrics
+    {
+        Histogram *allocations = nullptr;
+        Counter *bytes = nullptr;
+    };
+
+    // Registers trt_allocations and trt_allocated_bytes_total with the labels of a stage,
+    // nothing without allocation tracking so that exports are not cluttered with zeros
+    AllocationMetrics getAllocationMetrics(const Labels &labels);
+
+    // Records the allocations made by the thread during the lifetime of the scope: their number in a
+    // histogram, one value per scope, and their size in a counter. No-op without allocation tracking.
+    class AllocationScope
+    {
+    public:
+        explicit AllocationScope(const AllocationMetrics &metrics) : m_metrics(metrics)
+        {
+            if constexpr (ALLOCATION_TRACKING)
+                m_start = getThreadAllocations();
+        };
+        ~AllocationScope()
+        {
+            if constexpr (ALLOCATION_TRACKING)
+            {
+                if (!m_metrics.allocations)
+                    return;
+                const auto end = getThreadAllocations();
+                m_metrics.allocations->record(end.count - m_start.count);
+                m_metrics.bytes->add(end.bytes - m_start.bytes);
+            }
+        };
+
+        AllocationScope(const AllocationScope &) = delete;
+        AllocationScope &operator=(const AllocationScope &) = delete;
+
+    private:
+        const AllocationMetrics m_metrics;
+        AllocationStats m_start{};
+    };
+
+} // namespace metrics
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utils/json_utils.hpp>
+#include <metrics/metrics.hpp>
+
+namespace metrics
+{
+    // "metrics" section of a config file:
+    //   {"prometheus": "/var/lib/node_exporter/trt.prom", "socket": "/tmp/trt-metrics.sock", "json": "metrics.jsonl", "interval": 10}
+    struct ExporterConfig : public JsonConfig
+    {
+        std::string prometheusPath{}; // rewritten every interval, for the node exporter textfile collector
+        std::string socketPath{};     // Unix socket answering every connection with the Prometheus text over HTTP
+        std::string jsonPath{};       // JSON line appended every interval, with counter rates ("-" for stderr)
+        double interval = 10.0;       // s
+
+        std::shared_ptr<const JsonConfig> clone() const override { return std::make_shared<ExporterConfig>(*this); }
+
+        void loadFromJson(const nlohmann::json &data) override
+        {
+            if (data.contains("prometheus"))
+                prometheusPath = data["prometheus"].get<std::string>();
+            if (data.contains("socket"))
+                socketPath = data["socket"].get<std::string>();
+            if (data.contains("json"))
+                jsonPath = data["json"].get<std::string>();
+            if (data.contains("interval"))
+                interval = data["interval"].get<double>();
+        }
+    };
+
+    // Exports the registry snapshots on background threads until destroyed
+    class Exporter
+    {
+    public:
+        explicit Exporter(const ExporterConfig &config);
+        ~Exporter();
+
+        Exporter(const Exporter &) = delete;
+        Exporter &operator=(const Exporter &) = delete;
+
+    private:
+        void writeLoop();
+        void serveLoop(int listener);
+        void write();
+
+        const ExporterConfig m_config;
+        std::atomic<bool> m_running{true};
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::thread m_writeThread;
+        std::thread m_serveThread;
+        // Previous JSON snapshot, for counter rates
+        nlohmann::json m_previous{};
+        std::chrono::steady_clock::time_point m_previousTime{};
+    };
+
+} // namespace metrics
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace metrics
+{
+    using Labels = std::map<std::string, std::string>;
+
+    class Counter
+    {
+    public:
+        void add(uint64_t value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); };
+        [[nodiscard]] uint64_t get() const { return m_value.load(std::memory_order_relaxed); };
+
+    private:
+        std::atomic<uint64_t> m_value{0};
+    };
+
+    class Gauge
+    {
+    public:
+        void set(double value) { m_value.store(value, std::memory_order_relaxed); };
+        [[nodiscard]] double get() const { return m_value.load(std::memory_order_relaxed); };
+
+    private:
+        std::atomic<double> m_value{0.0};
+    };
+
+    // Distribution of integer values (latencies in ns, batch sizes...) in log buckets: exact up to 8,
+    // then 8 buckets per power of two, so quantiles are within 12.5%. Recording never locks nor allocates.
+    class Histogram
+    {
+    public:
+        static constexpr size_t SUB_BITS = 3;
+        static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+        static constexpr size_t NUM_BUCKETS = SUB_BUCKETS + (64 - SUB_BITS) * SUB_BUCKETS;
+
+        // Exported values are multiplied by the scale, e.g. 1e-9 for latencies recorded in ns and exported in s
+        explicit Histogram(double scale = 1.0) : m_scale(scale) {};
+
+        void record(uint64_t value);
+
+        [[nodiscard]] uint64_t getCount() const { return m_count.load(std::memory_order_relaxed); };
+        [[nodiscard]] double getSum() const { return m_sum.load(std::memory_order_relaxed) * m_scale; };
+        [[nodiscard]] double getMax() const { return m_max.load(std::memory_order_relaxed) * m_scale; };
+        [[nodiscard]] double getScale() const { return m_scale; };
+        // Upper bound of the bucket holding the quantile, 0 when empty
+        [[nodiscard]] double getQuantile(double quantile) const;
+        [[nodiscard]] uint64_t getBucketCount(size_t bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); };
+
+        static size_t getBucket(uint64_t value);
+        // Largest value of a bucket
+        static uint64_t getBucketUpperBound(size_t bucket);
+
+    private:
+        const double m_scale;
+        std::array<std::atomic<uint64_t>, NUM_BUCKETS> m_buckets{};
+        std::atomic<uint64_t> m_count{0};
+        std::atomic<uint64_t> m_sum{0};
+        std::atomic<uint64_t> m_max{0};
+    };
+
+    // Records the lifetime of the timer in ns
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram &histogram) : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {};
+        ~ScopedTimer()
+        {
+            m_histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+        };
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        Histogram &m_histogram;
+        const std::chrono::steady_clock::time_point m_start;
+    };
+
+    // Metrics of the process by name and labels. Metrics are created once and never removed, so instrumented
+    // code looks them up at construction and keeps a reference for the hot path.
+    class Registry
+    {
+    public:
+        static Registry &instance();
+
+        Counter &counter(const std::string &name, const Labels &labels = {});
+        Gauge &gauge(const std::string &name, const Labels &labels = {});
+        // Latencies are recorded in ns and exported in seconds, names should end with _seconds
+        Histogram &latency(const std::string &name, const Labels &labels = {});
+        Histogram &histogram(const std::string &name, const Labels &labels = {}, double scale = 1.0);
+
+        // Prometheus text exposition format
+        std::string toPrometheus() const;
+        // Counter and gauge values, histogram count, sum, max and p50/p95/p99
+        nlohmann::json toJson() const;
+
+    private:
+        Registry() = default;
+
+        using Key = std::pair<std::string, Labels>;
+
+        mutable std::mutex m_mutex;
+        std::map<Key, std::unique_ptr<Counter>> m_counters{};
+        std::map<Key, std::unique_ptr<Gauge>> m_gauges{};
+        std::map<Key, std::unique_ptr<Histogram>> m_histograms{};
+    };
+
+} // namespace metrics
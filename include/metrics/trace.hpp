@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace metrics
+{
+    // Span of a thread, exported as a Chrome trace complete event
+    struct TraceEvent
+    {
+        const char *name = nullptr;   // static or interned
+        const char *detail = nullptr; // e.g. model or node name, static or interned
+        int64_t frame = -1;
+        uint64_t begin = 0; // ns since the start of the trace
+        uint64_t end = 0;
+    };
+
+    // Opt-in timeline of the spans of every thread, dumped as Chrome trace-event JSON for Perfetto or
+    // chrome://tracing. Each thread appends to its own fixed-size buffer without locking, events past
+    // the capacity are dropped. A disabled tracer costs a relaxed atomic load per span.
+    class Tracer
+    {
+    public:
+        static Tracer &instance();
+
+        // A new trace discards the events of the previous one
+        void start();
+        void stop();
+        [[nodiscard]] bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); };
+
+        // Chrome trace-event JSON of the events recorded so far
+        bool dump(const std::string &path) const;
+
+        void record(const char *name, const char *detail, int64_t frame, std::chrono::steady_clock::time_point begin);
+        // Copy of a dynamic name that lives as long as the process, for span names and details
+        const char *intern(const std::string &name);
+
+        // Frame of the spans recorded next by the calling thread, -1 for none
+        static void setFrame(int64_t frame);
+        static int64_t getFrame();
+        // Name of the calling thread in the trace
+        static void setThreadName(const std::string &name);
+
+        [[nodiscard]] uint64_t getDroppedEvents() const;
+
+        static constexpr size_t BUFFER_CAPACITY = 1 << 16;
+
+    private:
+        struct Buffer
+        {
+            std::vector<TraceEvent> events = std::vector<TraceEvent>(BUFFER_CAPACITY);
+            std::atomic<size_t> size{0}; // events published by the owning thread
+            std::atomic<uint64_t> dropped{0};
+            uint64_t generation = 0;
+            uint32_t threadId = 0;
+            std::string threadName{};
+        };
+
+        Tracer() = default;
+        Buffer &getBuffer();
+
+        std::atomic<bool> m_enabled{false};
+        std::atomic<uint64_t> m_generation{0};
+        std::atomic<int64_t> m_epoch{0}; // steady clock ns at start
+
+        mutable std::mutex m_mutex;
+        std::vector<std::shared_ptr<Buffer>> m_buffers{};
+        std::set<std::string> m_names{};
+        uint32_t m_nextThreadId = 0;
+    };
+
+    // Records the lifetime of the span when the tracer is enabled
+    class TraceSpan
+    {
+    public:
+        explicit TraceSpan(const char *name, const char *detail = nullptr, int64_t frame = Tracer::getFrame())
+            : m_name(name), m_detail(detail), m_frame(frame), m_enabled(Tracer::instance().isEnabled())
+        {
+            if (m_enabled)
+                m_begin = std::chrono::steady_clock::now();
+        };
+        ~TraceSpan()
+        {
+            if (m_enabled)
+                Tracer::instance().record(m_name, m_detail, m_frame, m_begin);
+        };
+
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan &operator=(const TraceSpan &) = delete;
+
+    private:
+        const char *m_name;
+        const char *m_detail;
+        const int64_t m_frame;
+        const bool m_enabled;
+        std::chrono::steady_clock::time_point m_begin{};
+    };
+
+    // Traces for a few seconds each time the process receives a signal, e.g. `kill -USR1 <pid>`,
+    // and dumps every capture to the same path. Only one trigger can be installed at a time.
+    class TraceTrigger
+    {
+    public:
+        TraceTrigger(int signum, const std::string &path, double seconds);
+        ~TraceTrigger();
+
+        TraceTrigger(const TraceTrigger &) = delete;
+        TraceTrigger &operator=(const TraceTrigger &) = delete;
+
+    private:
+        void watchLoop();
+
+        const int m_signum;
+        const std::string m_path;
+        const double m_seconds;
+        std::atomic<bool> m_running{true};
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::thread m_thread;
+    };
+
+} // namespace metrics
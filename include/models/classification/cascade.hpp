@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+#include <types/detection.hpp>
+#include <utils/json_utils.hpp>
+#include <engine/interface.hpp>
+#include <models/classification/classifier.hpp>
+
+namespace cls
+{
+    struct CascadeConfig : JsonConfig
+    {
+        std::vector<std::string> classNames{}; // detector classes to classify, all if empty
+        float padding = 0.f;                   // crop margin on each side, relative to the box size
+        int minSize = 0;                       // crops smaller than this (pixels) are not classified
+        bool multiLabel = false;
+
+        void loadFromJson(const nlohmann::json &data) override
+        {
+            if (data.contains("class_names"))
+                classNames = data["class_names"].get<std::vector<std::string>>();
+            if (data.contains("padding"))
+                padding = data["padding"].get<float>();
+            if (data.contains("min_size"))
+                minSize = data["min_size"].get<int>();
+            if (data.contains("multi_label"))
+                multiLabel = data["multi_label"].get<bool>();
+        }
+
+        std::shared_ptr<const JsonConfig> clone() const override { return std::make_shared<CascadeConfig>(*this); }
+    };
+
+    // Classify the crops of the detections of each frame in batched calls, the classifier labels are added to each detection
+    void classifyDetections(trt::ClassificationProcessor &classifier, const CascadeConfig &config,
+                            const std::vector<cv::Mat> &frames, std::vector<std::vector<Detection>> &detections);
+
+    // Single or multi label classifier of a classifier config section
+    std::unique_ptr<trt::ClassificationProcessor> createClassifier(const nlohmann::json &data, bool multiLabel);
+
+    // Detector followed by a classifier on the crops of its detections.
+    // Crops of a whole batch of frames are classified together, the classifier labels are added to each detection.
+    class Cascade : public trt::DetectionProcessor
+    {
+    public:
+        Cascade(std::unique_ptr<trt::DetectionProcessor> detector,
+                std::unique_ptr<trt::ClassificationProcessor> classifier,
+                const CascadeConfig &config = {});
+
+        std::vector<Detection> process(const cv::Mat &frame) override;
+        std::vector<std::vector<Detection>> process(const std::vector<cv::Mat> &frames) override;
+        std::vector<std::vector<Detection>> process(const std::vector<cv::Mat> &frames, const std::vector<uint64_t> &frameIds) override;
+        // Frames are only shared with the detector, the classifier runs on crops
+        void setPreprocessCache(std::shared_ptr<trt::PreprocessCache> cache, const std::string &consumer) override;
+
+        // Classify the detections of frames that were already detected
+        void classify(const std::vector<cv::Mat> &frames, std::vector<std::vector<Detection>> &detections);
+
+        const CascadeConfig &getConfig() const { return m_config; };
+
+        // Wrap a detector when the config has a "cascade" section, the classifier is loaded from the "classifier" section
+        static std::unique_ptr<trt::DetectionProcessor> create(std::unique_ptr<trt::DetectionProcessor> detector, const nlohmann::json &data);
+
+    private:
+        std::unique_ptr<trt::DetectionProcessor> m_detector;
+        std::unique_ptr<trt::ClassificationProcessor> m_classifier;
+        const CascadeConfig m_config;
+    };
+
+} // namespace cls
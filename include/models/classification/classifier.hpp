@@ -1,8 +1,9 @@
 #pragma once
 
-#include <fstream>
 #include <types/detection.hpp>
 #include <utils/json_utils.hpp>
+#include <utils/class_names.hpp>
+#include <engine/bundle.hpp>
 #include <engine/processor.hpp>
 #include <engine/interface.hpp>
 
@@ -27,8 +28,7 @@ namespace cls
 
         static ClassifierConfig load(const std::string &filename, const std::string &task = "")
         {
-            std::ifstream file(filename);
-            auto data = nlohmann::json::parse(file);
+            auto data = trt::loadConfig(filename);
 
             ClassifierConfig config;
             if (task.empty())
@@ -50,6 +50,17 @@ namespace cls
         std::shared_ptr<const JsonConfig> clone() const override { return std::make_shared<ClassifierConfig>(*this); }
     };
 
+    inline std::string getClassName(const ClassifierConfig &config, int class_id)
+    {
+        return trt::getClassName(config.classNames, class_id);
+    }
+
+    // Classification heads, free of the engine so that they can run on recorded or synthetic scores
+    // Best class above the confidence threshold
+    Detection decodeSingleLabel(const std::vector<float> &scores, const ClassifierConfig &config);
+    // Every class above the confidence threshold, the best one in the main fields
+    Detection decodeMultiLabel(const std::vector<float> &scores, const ClassifierConfig &config);
+
     // Base classifier class
     class BaseClassifier : public trt::ClassificationProcessor, public trt::SISOProcessor<Detection>
     {
@@ -67,15 +78,29 @@ namespace cls
             return trt::SISOProcessor<Detection>::process(frames);
         }
 
+        std::vector<Detection> process(const cv::Mat &frame, const std::vector<cv::Rect2d> &rois) override
+        {
+            return trt::SISOProcessor<Detection>::process(frame, rois);
+        }
+
+        std::vector<Detection> process(const std::vector<cv::Mat> &frames, const std::vector<uint64_t> &frameIds) override
+        {
+            return trt::SISOProcessor<Detection>::process(frames, frameIds);
+        }
+
+        void setPreprocessCache(std::shared_ptr<trt::PreprocessCache> cache, const std::string &consumer) override
+        {
+            trt::SISOProcessor<Detection>::setPreprocessCache(std::move(cache), consumer);
+        }
+
         const ClassifierConfig &getConfig() const { return config; }
 
         const std::string getClassName(int class_id) const
         {
-            return (static_cast<size_t>(class_id) < config.classNames.size()) ? config.classNames[class_id] : std::to_string(class_id);
+            return cls::getClassName(config, class_id);
         }
 
     protected:
-        bool preprocess(const cv::Mat &srcImg, cv::Mat &dstImg) override;
         const ClassifierConfig config;
     };
 
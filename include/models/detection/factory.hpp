@@ -1,15 +1,18 @@
 #pragma once
 
-#include <fstream>
 #include <nlohmann/json.hpp>
+#include <engine/bundle.hpp>
 
 #include "yolo.hpp"
+#include <server/client.hpp>
+#include <models/classification/cascade.hpp>
 
 namespace det
 {
     enum class ModelType
     {
         YOLO,
+        REMOTE,
         UNKNOWN
     };
 
@@ -19,6 +22,8 @@ namespace det
         {
         case ModelType::YOLO:
             return "yolo";
+        case ModelType::REMOTE:
+            return "remote";
         default:
             throw std::runtime_error("Unkown model type");
         }
@@ -26,8 +31,9 @@ namespace det
 
     inline auto &getModels()
     {
-        static std::array<ModelType, 1> models{
-            ModelType::YOLO};
+        static std::array<ModelType, 2> models{
+            ModelType::YOLO,
+            ModelType::REMOTE};
 
         return models;
     };
@@ -52,19 +58,35 @@ namespace det
     public:
         static std::unique_ptr<trt::DetectionProcessor> create(const std::string &config_file)
         {
-            std::ifstream file(config_file);
-            auto data = nlohmann::json::parse(file);
-            ModelType model = getModelType(data["detector"]["architecture"]);
+            return create(trt::loadConfig(config_file), "detector");
+        }
+
+        // Model of another section than "detector", e.g. one of several detectors of a graph
+        static std::unique_ptr<trt::DetectionProcessor> create(const nlohmann::json &data, const std::string &section)
+        {
+            ModelType model = getModelType(data.at(section).at("architecture").get<std::string>());
 
+            std::unique_ptr<trt::DetectionProcessor> detector = nullptr;
             switch (model)
             {
             case ModelType::YOLO:
             {
-                return YoloFactory::create(data);
+                detector = YoloFactory::create(data, section);
+                break;
+            }
+            case ModelType::REMOTE:
+            {
+                auto config = server::RemoteConfig();
+                config.loadFromJson(data.at(section));
+                detector = std::make_unique<server::RemoteDetector>(config);
+                break;
             }
             default:
                 throw std::runtime_error("Unknown model architecture");
             }
+
+            // Optional classifier on the detected objects
+            return cls::Cascade::create(std::move(detector), data);
         }
     };
 
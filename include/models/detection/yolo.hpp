@@ -2,6 +2,7 @@
 
 #include <types/detection.hpp>
 #include <utils/json_utils.hpp>
+#include <utils/class_names.hpp>
 #include "detector.hpp"
 
 namespace det
@@ -82,23 +83,59 @@ namespace det
         std::shared_ptr<const JsonConfig> clone() const override { return std::make_shared<YoloConfig>(*this); }
     };
 
+    inline std::string getClassName(const YoloConfig &config, int class_id)
+    {
+        return trt::getClassName(config.classNames, class_id);
+    }
+
+    // Intermediate results of the decoding, kept by the caller between frames
+    struct YoloBuffers
+    {
+        std::vector<float> maxScores{};
+        std::vector<int> maxClasses{};
+        std::vector<cv::Rect2d> bboxes{};
+        std::vector<float> scores{};
+        std::vector<int> classIds{};
+        std::vector<int> candidates{};
+        std::vector<int> indices{};
+    };
+
+    // Output decoding and NMS, free of the engine so that it can run on recorded or synthetic outputs.
+    // Boxes are normalized by the input size.
+    // YOLOv8/v11 output: [4 + classes, anchors]
+    std::vector<Detection> decodeYolo(const float *output, int numChannels, int numAnchors, const cv::Size2f &inputSize, const YoloConfig &config);
+    // YOLOv7 output: [anchors, 5 + classes], with an objectness score
+    std::vector<Detection> decodeYolov7(const float *output, int numAnchors, int numChannels, const cv::Size2f &inputSize, const YoloConfig &config);
+
+    // Same decoding into reused buffers and detections, nothing is allocated once they are warm
+    // (class names longer than the small string buffer are still copied)
+    void decodeYolo(const float *output, int numChannels, int numAnchors, const cv::Size2f &inputSize, const YoloConfig &config,
+                    YoloBuffers &buffers, std::vector<Detection> &detections);
+    void decodeYolov7(const float *output, int numAnchors, int numChannels, const cv::Size2f &inputSize, const YoloConfig &config,
+                      YoloBuffers &buffers, std::vector<Detection> &detections);
+
     class Yolo : public Detector<trt::SingleOutput>
     {
     public:
-        Yolo(const YoloConfig &t_config)
-            : Detector<trt::SingleOutput>(t_config.engine), config(t_config) {};
+        Yolo(const YoloConfig &t_config);
         virtual ~Yolo() = default;
         const YoloConfig &getConfig() const { return config; };
         const std::string getClassName(int class_id) const
         {
-            return (static_cast<size_t>(class_id) < config.classNames.size()) ? config.classNames[class_id] : std::to_string(class_id);
+            return det::getClassName(config, class_id);
         };
 
     protected:
+        // Without an engine, decodes outputs of the given shape, e.g. recorded or synthetic ones
+        Yolo(const std::string &name, const YoloConfig &t_config, const cv::Size &inputSize, int t_outputRows, int t_outputCols);
+
         const YoloConfig config;
+        YoloBuffers buffers{};
+        // Output shape, [4 + classes, anchors] for YOLOv8/v11 and [anchors, 5 + classes] for YOLOv7
+        int outputRows = 0;
+        int outputCols = 0;
 
     private:
-        bool preprocess(const cv::Mat &srcImg, cv::Mat &dstImg) override;
         virtual std::vector<Detection> postprocess(const trt::SingleOutput &featureVector);
     };
 
@@ -117,12 +154,13 @@ namespace det
     class YoloFactory
     {
     public:
-        static std::unique_ptr<Yolo> create(const nlohmann::json &data)
+        // Model of the given section of the config
+        static std::unique_ptr<Yolo> create(const nlohmann::json &data, const std::string &section = "detector")
         {
-            YoloVersion version = getYoloVersion(data["detector"]["name"]);
+            YoloVersion version = getYoloVersion(data.at(section).at("name").get<std::string>());
 
             auto config = YoloConfig();
-            config.loadFromJson(data["detector"]);
+            config.loadFromJson(data.at(section));
 
             switch (version)
             {
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <models/reid/gallery.hpp>
+
+namespace reid
+{
+    // On-disk fp32 embeddings keyed by a content hash, stored as a gallery whose ids are the keys
+    class EmbeddingCache
+    {
+    public:
+        explicit EmbeddingCache(const std::string &path);
+
+        std::optional<std::vector<float>> get(uint64_t key) const;
+        // Store one embedding per row, the cache is created with the dimension of the first ones
+        void put(const std::vector<uint64_t> &keys, const cv::Mat &embeddings);
+
+        [[nodiscard]] size_t size() const { return m_index.size(); };
+
+    private:
+        const std::string m_path;
+        std::unique_ptr<Gallery> m_gallery{};
+        std::unordered_map<uint64_t, size_t> m_index{};
+    };
+
+} // namespace reid
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <kernels/similarity.hpp>
+
+namespace reid
+{
+    // Append-only gallery of normalized embeddings, memory-mapped for instant startup:
+    //   <path>      : FileHeader | record...
+    //   record      : RecordHeader | embedding (fp32, fp16 or int8), padded to 8 bytes
+    //   <path>.meta : metadata blob, referenced by offset and size from records
+    // Values are stored in host byte order, a single process appends to a gallery.
+    namespace gallery
+    {
+        static constexpr char FILE_MAGIC[4] = {'T', 'R', 'V', 'G'};
+        static constexpr uint32_t VERSION = 1;
+
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            int32_t dims;
+            int32_t depth;
+            uint32_t recordSize;
+            uint32_t reserved;
+            uint64_t count;
+        };
+
+        struct RecordHeader
+        {
+            int64_t id;
+            uint64_t metadataOffset;
+            uint32_t metadataSize;
+            float scale;
+        };
+
+        static_assert(sizeof(FileHeader) == 32, "Unexpected gallery header size");
+        static_assert(sizeof(RecordHeader) == 24, "Unexpected gallery record header size");
+    } // namespace gallery
+
+    struct GalleryMatch
+    {
+        int64_t id = -1;
+        float score = 0.f;
+        std::string metadata{};
+    };
+
+    class Gallery
+    {
+    public:
+        // Open an existing gallery
+        explicit Gallery(const std::string &path, size_t maxEntries = 1 << 24);
+        // Open a gallery, or create it with embeddings of `dims` values stored as CV_32F, CV_16F or CV_8S
+        Gallery(const std::string &path, int dims, int depth, size_t maxEntries = 1 << 24);
+        ~Gallery();
+
+        Gallery(const Gallery &) = delete;
+        Gallery &operator=(const Gallery &) = delete;
+
+        // Append embeddings, safe to call while other threads search
+        size_t add(int64_t id, const std::vector<float> &embedding, const std::string &metadata = "");
+        void add(const std::vector<int64_t> &ids, const cv::Mat &embeddings, const std::vector<std::string> &metadata = {});
+
+        // Top k most similar entries of each query (one fp32 embedding per row), brute force over `numThreads` threads
+        std::vector<std::vector<GalleryMatch>> search(const cv::Mat &queries, size_t k, size_t numThreads = 0) const;
+
+        // Embeddings of the entries [begin, end), a view into the mapped file
+        kernels::Embeddings getEmbeddings(size_t begin, size_t end) const;
+        [[nodiscard]] int64_t getId(size_t index) const;
+        [[nodiscard]] std::string getMetadata(size_t index) const;
+
+        [[nodiscard]] size_t size() const { return m_count.load(std::memory_order_acquire); };
+        [[nodiscard]] int getDims() const { return m_dims; };
+        [[nodiscard]] int getDepth() const { return m_depth; };
+
+        // Persist the mapped records to disk
+        void flush();
+
+    private:
+        void open(const std::string &path, int dims, int depth, bool create, size_t maxEntries);
+        void close();
+        void reserve(size_t count);
+        gallery::RecordHeader *getRecord(size_t index) const;
+
+        int m_fd = -1;
+        int m_metadataFd = -1;
+        char *m_data = nullptr;
+        size_t m_mappedSize = 0;
+        size_t m_fileSize = 0;
+        uint64_t m_metadataSize = 0;
+
+        int m_dims = 0;
+        int m_depth = CV_32F;
+        size_t m_recordSize = 0;
+        size_t m_maxEntries = 0;
+
+        std::mutex m_appendMutex{};
+        std::atomic<size_t> m_count{0};
+    };
+
+} // namespace reid
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <models/reid/gallery.hpp>
+
+namespace reid
+{
+    // Serialized index, memory-mapped on load:
+    //   FileHeader | level 0 links | levels | upper link offsets | upper links
+    //   links: int32 count, int32 neighbors[max], one block per node and level
+    // Every section starts on an 8 byte boundary, values are stored in host byte order.
+    namespace hnsw
+    {
+        static constexpr char FILE_MAGIC[4] = {'T', 'R', 'V', 'H'};
+        static constexpr uint32_t VERSION = 1;
+
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t m;
+            uint32_t efConstruction;
+            uint64_t count;
+            int32_t entryPoint;
+            int32_t maxLevel;
+            uint64_t upperSize;
+            uint64_t reserved;
+        };
+
+        static_assert(sizeof(FileHeader) == 48, "Unexpected index header size");
+    } // namespace hnsw
+
+    struct HnswParams
+    {
+        size_t m = 16;               // neighbors per node on upper layers, twice as many on layer 0
+        size_t efConstruction = 200; // candidates explored per insert, higher builds a better graph
+        size_t efSearch = 64;        // candidates explored per query, trades speed for recall
+        uint32_t seed = 42;
+    };
+
+    // Hierarchical navigable small world graph over the entries of a gallery
+    class HnswIndex
+    {
+    public:
+        HnswIndex(const Gallery &gallery, const HnswParams &params = {});
+        // Load a serialized index of `gallery`, entries appended since are indexed on the next update
+        HnswIndex(const Gallery &gallery, const std::string &path, size_t efSearch = 64);
+        ~HnswIndex();
+
+        HnswIndex(const HnswIndex &) = delete;
+        HnswIndex &operator=(const HnswIndex &) = delete;
+
+        // Index the gallery entries appended since the last update, over `numThreads` threads.
+        // Searches may run meanwhile, updates must not overlap each other.
+        void update(size_t numThreads = 0);
+
+        // Approximate top k of each query (one fp32 embedding per row), exploring max(k, ef) candidates
+        std::vector<std::vector<GalleryMatch>> search(const cv::Mat &queries, size_t k, size_t ef = 0) const;
+
+        void save(const std::string &path) const;
+
+        [[nodiscard]] size_t size() const { return m_count; };
+        [[nodiscard]] const HnswParams &getParams() const { return m_params; };
+        void setEfSearch(size_t ef) { m_params.efSearch = ef; };
+
+    private:
+        struct Candidate
+        {
+            float similarity;
+            int32_t node;
+        };
+
+        int32_t *getLinks(int32_t node, int level) const;
+        std::vector<int32_t> getNeighbors(int32_t node, int level) const;
+        int drawLevel(int32_t node) const;
+
+        void reserve(size_t capacity);
+        void insert(int32_t node, const kernels::Embeddings &embeddings);
+        std::vector<Candidate> searchLayer(const kernels::Embeddings &queries, int q, const kernels::Embeddings &embeddings,
+                                           int32_t entry, size_t ef, int level) const;
+        std::vector<int32_t> selectNeighbors(std::vector<Candidate> candidates, size_t max, const kernels::Embeddings &embeddings) const;
+        void connect(int32_t node, int32_t neighbor, int level, const kernels::Embeddings &embeddings);
+
+        const Gallery &m_gallery;
+        HnswParams m_params;
+        size_t m_maxLinks0 = 0;
+
+        // Links either live in the owned buffers or in the mapped file until the index grows
+        size_t m_capacity = 0;
+        std::atomic<size_t> m_count{0};
+        int32_t *m_links0 = nullptr;
+        int32_t *m_levels = nullptr;
+        std::vector<int32_t *> m_upperLinks{};
+        std::vector<int32_t> m_ownedLinks0{};
+        std::vector<int32_t> m_ownedLevels{};
+        std::vector<std::unique_ptr<int32_t[]>> m_ownedUpperLinks{};
+        void *m_mapped = nullptr;
+        size_t m_mappedSize = 0;
+
+        int32_t m_entryPoint = -1;
+        int m_maxLevel = -1;
+
+        mutable std::shared_mutex m_resizeMutex{};
+        mutable std::mutex m_entryMutex{};
+        mutable std::array<std::mutex, 4096> m_nodeMutexes{};
+    };
+
+} // namespace reid
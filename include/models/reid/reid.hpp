@@ -1,6 +1,7 @@
 #pragma once
-#include <fstream>
+#include <types/detection.hpp>
 #include <utils/json_utils.hpp>
+#include <engine/bundle.hpp>
 #include <engine/processor.hpp>
 
 namespace reid
@@ -23,8 +24,7 @@ namespace reid
 
         static ReIdConfig load(const std::string &filename, const std::string &task = "")
         {
-            std::ifstream file(filename);
-            auto data = nlohmann::json::parse(file);
+            auto data = trt::loadConfig(filename);
 
             ReIdConfig config;
             if (task.empty())
@@ -50,8 +50,14 @@ namespace reid
         ReId(const ReIdConfig &config) : trt::SISOProcessor<std::vector<float>>(config.engine), m_config(config) {}
         const ReIdConfig &getConfig() const { return m_config; };
 
+        // Embeddings of normalized ROIs of an image, one row per ROI
+        cv::Mat embed(const cv::Mat &image, const std::vector<cv::Rect2d> &rois);
+        // Fill the features of every detection of an image in batched calls
+        void extractFeatures(const cv::Mat &image, std::vector<Detection> &detections);
+        // Fill the features of a subset of detections of an image
+        void extractFeatures(const cv::Mat &image, std::vector<Detection> &detections, const std::vector<size_t> &indices);
+
     protected:
-        bool preprocess(const cv::Mat &srcImg, cv::Mat &dstImg) override;
         std::vector<float> postprocess(const trt::SingleOutput &featureVector) override;
 
     private:
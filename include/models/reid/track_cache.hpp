@@ -0,0 +1,72 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <types/detection.hpp>
+#include <utils/json_utils.hpp>
+
+namespace reid
+{
+
+    struct TrackCacheConfig : public JsonConfig
+    {
+        int refreshInterval = 10;         // frames between two refreshes of a track
+        float matchThreshold = 0.5f;      // minimum IoU between a detection and the last box of a track
+        float ambiguityThreshold = 0.3f;  // IoU above which another box makes the match ambiguous
+        float maxScaleChange = 0.2f;      // relative area change since the last refresh
+        int maxAge = 30;                  // frames after which a lost track is forgotten
+
+        std::shared_ptr<const JsonConfig> clone() const override { return std::make_shared<TrackCacheConfig>(*this); }
+
+        void loadFromJson(const nlohmann::json &data) override
+        {
+            if (data.contains("refresh_interval"))
+                refreshInterval = data["refresh_interval"].get<int>();
+            if (data.contains("match_threshold"))
+                matchThreshold = data["match_threshold"].get<float>();
+            if (data.contains("ambiguity_threshold"))
+                ambiguityThreshold = data["ambiguity_threshold"].get<float>();
+            if (data.contains("max_scale_change"))
+                maxScaleChange = data["max_scale_change"].get<float>();
+            if (data.contains("max_age"))
+                maxAge = data["max_age"].get<int>();
+        }
+    };
+
+    // Caches the outputs of secondary models (ReId features, classifier labels) per track.
+    // A detection reuses the outputs of a track when it unambiguously continues it,
+    // otherwise it has to go through the secondary models again.
+    class TrackCache
+    {
+    public:
+        TrackCache(const TrackCacheConfig &config) : m_config(config) {}
+
+        // Fill cached outputs, return the indices of detections to recompute
+        std::vector<size_t> lookup(std::vector<Detection> &detections);
+        // Record the outputs of tracked detections, once the tracker assigned their track ids.
+        // The detections are the ones given to lookup, in the same order.
+        void update(const std::vector<Detection> &detections);
+
+        [[nodiscard]] uint64_t getHits() const { return m_hits; };
+        [[nodiscard]] uint64_t getMisses() const { return m_misses; };
+
+    private:
+        struct Entry
+        {
+            cv::Rect2d lastBox{};
+            cv::Rect2d refreshBox{};
+            int64_t lastSeen = 0;
+            int64_t refreshedAt = 0;
+            std::vector<float> features{};
+            std::map<int, std::string> labels{};
+        };
+
+        const TrackCacheConfig m_config;
+        std::map<int, Entry> m_entries{};
+        std::vector<int> m_sources{}; // track whose outputs each detection of the frame reuses, -1 if none
+        int64_t m_frame = 0;
+        uint64_t m_hits = 0;
+        uint64_t m_misses = 0;
+    };
+
+} // namespace reid
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include <engine/interface.hpp>
+#include <models/reid/reid.hpp>
+
+namespace reid
+{
+    struct VideoSearchConfig
+    {
+        size_t frameStride = 5;   // search one frame out of `frameStride`
+        size_t frameBatch = 8;    // frames per detector call
+        size_t queueSize = 4;     // batches buffered between stages
+        std::string className{};  // only embed detections of this class, all if empty
+        float minSimilarity = 0.5f;
+    };
+
+    struct VideoMatch
+    {
+        int64_t frameIndex = 0;
+        double timestamp = 0.0;
+        cv::Rect2d bbox{};
+        int query = -1;
+        float similarity = 0.f;
+    };
+
+    // Finds query embeddings in a video: decoding, detection and embedding run as overlapping stages
+    class VideoSearch
+    {
+    public:
+        VideoSearch(trt::DetectionProcessor &detector, ReId &reid, const VideoSearchConfig &config = {});
+
+        // Search every detection for the most similar query (one normalized embedding per row),
+        // matches are reported in frame order as soon as they are embedded
+        void run(cv::VideoCapture &capture, const cv::Mat &queries, const std::function<void(const VideoMatch &)> &callback);
+        void stop() { m_running = false; };
+
+        [[nodiscard]] uint64_t getSearchedFrames() const { return m_searchedFrames; };
+        [[nodiscard]] uint64_t getDetections() const { return m_detections; };
+
+    private:
+        trt::DetectionProcessor &m_detector;
+        ReId &m_reid;
+        const VideoSearchConfig m_config;
+
+        std::atomic<bool> m_running{false};
+        std::atomic<uint64_t> m_searchedFrames{0};
+        std::atomic<uint64_t> m_detections{0};
+    };
+
+} // namespace reid
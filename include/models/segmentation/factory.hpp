@@ -1,9 +1,10 @@
 #pragma once
 
-#include <fstream>
 #include <nlohmann/json.hpp>
+#include <engine/bundle.hpp>
 
 #include "yolo.hpp"
+#include <models/classification/cascade.hpp>
 
 namespace seg
 {
@@ -52,19 +53,34 @@ namespace seg
     public:
         static std::unique_ptr<trt::DetectionProcessor> create(const std::string &config_file)
         {
-            std::ifstream file(config_file);
-            auto data = nlohmann::json::parse(file);
-            ModelType model = getModelType(data["segmenter"]["architecture"]);
+            return create(trt::loadConfig(config_file), "segmenter");
+        }
+
+        // Model of another section than "segmenter", e.g. one of several segmenters of a graph
+        static std::unique_ptr<trt::DetectionProcessor> create(const nlohmann::json &data, const std::string &section)
+        {
+            // The inference server only sends boxes back, a remote segmenter would lose its masks
+            const std::string architecture = data.at(section).at("architecture").get<std::string>();
+            if (architecture == "remote")
+            {
+                throw std::runtime_error("Remote segmentation is not supported, masks are not transferred by the inference server");
+            }
+            ModelType model = getModelType(architecture);
 
+            std::unique_ptr<trt::DetectionProcessor> detector = nullptr;
             switch (model)
             {
             case ModelType::YOLO:
             {
-                return YoloFactory::create(data);
+                detector = YoloFactory::create(data, section);
+                break;
             }
             default:
                 throw std::runtime_error("Unknown model architecture");
             }
+
+            // Optional classifier on the detected objects
+            return cls::Cascade::create(std::move(detector), data);
         }
     };
 
@@ -23,6 +23,16 @@ namespace seg
         {
             return trt::ModelProcessor<std::vector<Detection>, EngineOutput>::process(frames);
         }
+
+        std::vector<std::vector<Detection>> process(const std::vector<cv::Mat> &frames, const std::vector<uint64_t> &frameIds) override
+        {
+            return trt::ModelProcessor<std::vector<Detection>, EngineOutput>::process(frames, frameIds);
+        }
+
+        void setPreprocessCache(std::shared_ptr<trt::PreprocessCache> cache, const std::string &consumer) override
+        {
+            trt::ModelProcessor<std::vector<Detection>, EngineOutput>::setPreprocessCache(std::move(cache), consumer);
+        }
     };
 
 } // seg
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <types/detection.hpp>
 #include <utils/json_utils.hpp>
+#include <utils/class_names.hpp>
 #include "segmenter.hpp"
 
 namespace seg
@@ -79,23 +80,36 @@ namespace seg
         std::shared_ptr<const JsonConfig> clone() const override { return std::make_shared<YoloConfig>(*this); }
     };
 
+    inline std::string getClassName(const YoloConfig &config, int class_id)
+    {
+        return trt::getClassName(config.classNames, class_id);
+    }
+
+    // Output decoding, NMS and mask assembly, free of the engine so that it can run on recorded or synthetic
+    // outputs. output0: [4 + classes + masks, anchors], protos: [masks, maskHeight, maskWidth]
+    std::vector<Detection> decodeYolo(const float *output0, const float *protos, int numChannels, int numAnchors,
+                                      int numMasks, int maskHeight, int maskWidth, const cv::Size2f &inputSize, const YoloConfig &config);
+
     class Yolo : public Segmenter<trt::MultiOutput>
     {
     public:
         Yolo(const YoloConfig &t_config)
-            : Segmenter<trt::MultiOutput>(t_config.engine), config(t_config) {};
+            : Segmenter<trt::MultiOutput>(t_config.engine), config(t_config)
+        {
+            // Masks are decoded on the stretched input
+            preprocessing.resize = trt::ResizeMode::STRETCH;
+        };
         virtual ~Yolo() = default;
         const YoloConfig &getConfig() const { return config; };
         const std::string getClassName(int class_id) const
         {
-            return (static_cast<size_t>(class_id) < config.classNames.size()) ? config.classNames[class_id] : std::to_string(class_id);
+            return seg::getClassName(config, class_id);
         };
 
     protected:
         const YoloConfig config;
 
     private:
-        bool preprocess(const cv::Mat &srcImg, cv::Mat &dstImg) override;
         std::vector<Detection> postprocess(const trt::MultiOutput &engineOutputs) override;
     };
 
@@ -105,12 +119,13 @@ namespace seg
     class YoloFactory
     {
     public:
-        static std::unique_ptr<Yolo> create(const nlohmann::json &data)
+        // Model of the given section of the config
+        static std::unique_ptr<Yolo> create(const nlohmann::json &data, const std::string &section = "segmenter")
         {
-            YoloVersion version = getYoloVersion(data["segmenter"]["name"]);
+            YoloVersion version = getYoloVersion(data.at(section).at("name").get<std::string>());
 
             auto config = YoloConfig();
-            config.loadFromJson(data["segmenter"]);
+            config.loadFromJson(data.at(section));
 
             switch (version)
             {
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <utils/json_utils.hpp>
+#include <utils/class_names.hpp>
+#include <engine/interface.hpp>
+#include "server/protocol.hpp"
+
+namespace server
+{
+
+    struct RemoteConfig : public JsonConfig
+    {
+        std::string socketPath = "/tmp/tensorrt-vision.sock";
+        int slots = 4;
+        size_t slotSize = 3840 * 2160 * 3;
+
+        std::shared_ptr<const JsonConfig> clone() const override { return std::make_shared<RemoteConfig>(*this); }
+
+        void loadFromJson(const nlohmann::json &data) override
+        {
+            if (data.contains("socket"))
+                socketPath = data["socket"].get<std::string>();
+            if (data.contains("slots"))
+                slots = data["slots"].get<int>();
+            if (data.contains("slot_size"))
+                slotSize = data["slot_size"].get<size_t>();
+        }
+    };
+
+    // Detection processor running on a local inference server.
+    // Frames are written into a shared memory ring, only compact results go through the socket.
+    class RemoteDetector : public trt::DetectionProcessor
+    {
+    public:
+        RemoteDetector(const RemoteConfig &config);
+        ~RemoteDetector();
+
+        std::vector<Detection> process(const cv::Mat &frame) override;
+        std::vector<std::vector<Detection>> process(const std::vector<cv::Mat> &frames) override;
+
+        const RemoteConfig &getConfig() const { return m_config; };
+        const std::string getClassName(int class_id) const
+        {
+            return trt::getClassName(m_classNames, class_id);
+        };
+
+    private:
+        void sendFrame(const cv::Mat &frame, uint32_t slot);
+        std::vector<Detection> receiveDetections(uint64_t sequence);
+
+        const RemoteConfig m_config;
+        std::unique_ptr<SharedMemory> m_memory = nullptr;
+        std::vector<std::string> m_classNames{};
+        int m_socket = -1;
+        uint64_t m_sequence = 0;
+        std::mutex m_mutex;
+    };
+
+} // namespace server
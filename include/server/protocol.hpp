@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace server
+{
+    // Messages exchanged over the Unix domain socket, each one is a MessageHeader followed by its payload.
+    // Frames never go through the socket, they are written by the client into its shared memory ring.
+    enum class MessageType : uint32_t
+    {
+        HELLO = 1, // client -> server: Hello
+        WELCOME,   // server -> client: JSON model description
+        REQUEST,   // client -> server: FrameRequest
+        RESPONSE,  // server -> client: FrameResponse followed by CompactDetection[count]
+        ERROR      // server -> client: error message
+    };
+
+    struct MessageHeader
+    {
+        MessageType type;
+        uint32_t size;
+    };
+
+    struct Hello
+    {
+        char shmName[64];
+        uint32_t slots;
+        uint32_t reserved;
+        uint64_t slotSize;
+    };
+
+    struct FrameRequest
+    {
+        uint64_t sequence;
+        uint32_t slot;
+        int32_t rows;
+        int32_t cols;
+        int32_t type;
+        uint64_t step;
+    };
+
+    struct FrameResponse
+    {
+        uint64_t sequence;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    struct CompactDetection
+    {
+        float x, y, width, height;
+        float confidence;
+        int32_t classId;
+    };
+
+    // Largest payloads accepted, a response carries at most MAX_RESPONSE_DETECTIONS detections
+    constexpr uint32_t MAX_RESPONSE_DETECTIONS = 1 << 16;
+    constexpr uint32_t MAX_WELCOME_SIZE = 1 << 20;
+    constexpr uint32_t MAX_ERROR_SIZE = 1 << 12;
+
+    // Blocking helpers, false when the peer is gone.
+    // A payload larger than the maximum of its message type is not read and returns false as well.
+    bool sendMessage(int fd, MessageType type, const void *payload, size_t size);
+    bool receiveMessage(int fd, MessageHeader &header, std::string &payload);
+
+    // POSIX shared memory segment mapped read/write
+    class SharedMemory
+    {
+    public:
+        // Create a new segment, or map an existing one
+        SharedMemory(const std::string &name, size_t size, bool create);
+        ~SharedMemory();
+
+        SharedMemory(const SharedMemory &) = delete;
+        SharedMemory &operator=(const SharedMemory &) = delete;
+
+        // Remove the name, the mapping stays valid until destruction
+        void unlink();
+
+        [[nodiscard]] uint8_t *data() const { return m_data; };
+        [[nodiscard]] size_t size() const { return m_size; };
+
+    private:
+        std::string m_name;
+        uint8_t *m_data = nullptr;
+        size_t m_size = 0;
+        bool m_owner = false;
+    };
+
+} // namespace server
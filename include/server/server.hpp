@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <engine/interface.hpp>
+#include "server/protocol.hpp"
+
+namespace server
+{
+
+    // Owns a detection processor and serves it to local clients over a Unix domain socket.
+    // Requests of all clients are batched together into a single engine call.
+    class InferenceServer
+    {
+    public:
+        InferenceServer(std::unique_ptr<trt::DetectionProcessor> processor,
+                        std::vector<std::string> classNames,
+                        size_t maxBatchSize,
+                        std::chrono::microseconds batchTimeout = std::chrono::microseconds(2000));
+        ~InferenceServer();
+
+        // Blocks until `running` is cleared
+        void serve(const std::string &socketPath, const std::atomic<bool> &running);
+
+    private:
+        struct Client;
+        struct Request
+        {
+            std::shared_ptr<Client> client;
+            FrameRequest frame;
+        };
+
+        void handleMessage(const std::shared_ptr<Client> &client);
+        void inferenceLoop();
+
+        std::unique_ptr<trt::DetectionProcessor> m_processor;
+        const std::vector<std::string> m_classNames;
+        const size_t m_maxBatchSize;
+        const std::chrono::microseconds m_batchTimeout;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::deque<Request> m_requests{};
+        bool m_stopped = false;
+    };
+
+} // namespace server
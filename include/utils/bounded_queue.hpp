@@ -0,0 +1,83 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <condition_variable>
+
+namespace trt
+{
+    // Blocking FIFO between pipeline stages, producers wait while it is full
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t capacity) : m_capacity(std::max<size_t>(1, capacity)) {}
+
+        // Returns false if the queue was closed
+        bool push(T value)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notFull.wait(lock, [this]()
+                           { return m_closed || m_items.size() < m_capacity; });
+            if (m_closed)
+                return false;
+
+            m_items.push_back(std::move(value));
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        // Returns nothing once the queue is closed and drained
+        std::optional<T> pop()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [this]()
+                            { return m_closed || !m_items.empty(); });
+            if (m_items.empty())
+                return std::nullopt;
+
+            T value = std::move(m_items.front());
+            m_items.pop_front();
+            m_notFull.notify_one();
+            return value;
+        }
+
+        // Returns nothing if the queue is empty, without waiting
+        std::optional<T> tryPop()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_items.empty())
+                return std::nullopt;
+
+            T value = std::move(m_items.front());
+            m_items.pop_front();
+            m_notFull.notify_one();
+            return value;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_items.size();
+        }
+
+        // Wake up every producer and consumer, remaining items can still be popped
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_notFull.notify_all();
+            m_notEmpty.notify_all();
+        }
+
+    private:
+        const size_t m_capacity;
+        std::deque<T> m_items{};
+        bool m_closed = false;
+        mutable std::mutex m_mutex{};
+        std::condition_variable m_notFull{};
+        std::condition_variable m_notEmpty{};
+    };
+
+} // namespace trt
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace trt
+{
+    // Name of a class id, the id itself when the model has no name for it
+    inline std::string getClassName(const std::vector<std::string> &classNames, int class_id)
+    {
+        return (static_cast<size_t>(class_id) < classNames.size()) ? classNames[class_id] : std::to_string(class_id);
+    }
+} // namespace trt
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace trt
+{
+    // Read-only mapping of a whole file, pages are read from the page cache on first access instead of being copied
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string &path)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Could not open " + path);
+
+            struct stat info{};
+            if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("Empty or unreadable file " + path);
+            }
+
+            m_size = static_cast<size_t>(info.st_size);
+            void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED)
+                throw std::runtime_error("Could not map " + path);
+            m_data = static_cast<const char *>(data);
+        }
+
+        ~MappedFile()
+        {
+            if (m_data)
+                ::munmap(const_cast<char *>(m_data), m_size);
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        // Read a range from disk and map its pages, so that later accesses neither wait on I/O nor fault
+        void load(size_t offset, size_t length) const
+        {
+            const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            const size_t start = offset / page * page;
+            const size_t end = std::min(m_size, offset + length);
+            ::madvise(const_cast<char *>(m_data) + start, end - start, MADV_WILLNEED);
+
+            // One read per page, the readahead requested above fills the page cache in large requests
+            volatile char sink = 0;
+            for (size_t i = start; i < end; i += page)
+                sink = sink + m_data[i];
+        }
+
+        [[nodiscard]] const char *data() const { return m_data; };
+        [[nodiscard]] size_t size() const { return m_size; };
+
+    private:
+        const char *m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+} // namespace trt
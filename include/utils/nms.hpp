@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace trt
+{
+    // Overlap of two boxes, computed like cv::dnn::NMSBoxes
+    inline float boxOverlap(const cv::Rect2d &a, const cv::Rect2d &b)
+    {
+        const double areaA = a.area();
+        const double areaB = b.area();
+        if (areaA + areaB <= std::numeric_limits<double>::epsilon())
+            return 1.f;
+        const double intersection = (a & b).area();
+        return 1.f - static_cast<float>(1.0 - intersection / (areaA + areaB - intersection));
+    }
+
+    // Same result as cv::dnn::NMSBoxes: boxes scored strictly above the threshold are visited by decreasing score,
+    // ties in input order, only the first topK if positive. The candidates are scratch space, nothing is allocated
+    // once the candidates and the indices have the capacity of all the boxes.
+    inline void nmsBoxes(const std::vector<cv::Rect2d> &bboxes, const std::vector<float> &scores, float scoreThreshold,
+                         float nmsThreshold, std::vector<int> &indices, std::vector<int> &candidates, float eta = 1.f, int topK = 0)
+    {
+        candidates.clear();
+        candidates.reserve(scores.size());
+        for (size_t i = 0; i < scores.size(); ++i)
+        {
+            if (scores[i] > scoreThreshold)
+                candidates.push_back(static_cast<int>(i));
+        }
+
+        // Ties broken by index instead of std::stable_sort, which allocates a temporary buffer
+        auto higher = [&scores](int a, int b)
+        { return scores[a] > scores[b] || (scores[a] == scores[b] && a < b); };
+        if (topK > 0 && static_cast<size_t>(topK) < candidates.size())
+        {
+            std::partial_sort(candidates.begin(), candidates.begin() + topK, candidates.end(), higher);
+            candidates.resize(topK);
+        }
+        else
+        {
+            std::sort(candidates.begin(), candidates.end(), higher);
+        }
+
+        indices.clear();
+        indices.reserve(candidates.size());
+        float threshold = nmsThreshold;
+        for (int candidate : candidates)
+        {
+            bool keep = true;
+            for (size_t k = 0; k < indices.size() && keep; ++k)
+                keep = boxOverlap(bboxes[candidate], bboxes[indices[k]]) <= threshold;
+            if (keep)
+            {
+                indices.push_back(candidate);
+                if (eta < 1.f && threshold > 0.5f)
+                    threshold *= eta;
+            }
+        }
+    }
+} // namespace trt
@@ -4,18 +4,35 @@
 
 namespace trt
 {
-    inline cv::Mat blobFromMats(const std::vector<cv::Mat> &batchInput)
+    // Pixel rectangle of a normalized ROI, clipped to the image and at least 1x1
+    inline cv::Rect toPixelRect(const cv::Rect2d &roi, const cv::Size &size)
+    {
+        int x = std::clamp(static_cast<int>(std::round(roi.x * size.width)), 0, size.width - 1);
+        int y = std::clamp(static_cast<int>(std::round(roi.y * size.height)), 0, size.height - 1);
+        int width = std::clamp(static_cast<int>(std::round(roi.width * size.width)), 1, size.width - x);
+        int height = std::clamp(static_cast<int>(std::round(roi.height * size.height)), 1, size.height - y);
+        return cv::Rect(x, y, width, height);
+    }
+
+    // Planar NCHW blob of a batch of HWC images, written to dst which is only reallocated when its size changes
+    inline void blobFromMats(const std::vector<cv::Mat> &batchInput, cv::Mat &dst)
     {
-        cv::Mat dst(1, batchInput[0].rows * batchInput[0].cols * batchInput.size(), CV_32FC3);
+        dst.create(1, batchInput[0].rows * batchInput[0].cols * batchInput.size(), CV_32FC3);
         size_t width = batchInput[0].cols * batchInput[0].rows;
         for (size_t img = 0; img < batchInput.size(); img++)
         {
-            std::vector<cv::Mat> input_channels{
+            cv::Mat input_channels[3] = {
                 cv::Mat(batchInput[0].rows, batchInput[0].cols, CV_32F, &(dst.ptr()[0 + width * 3 * sizeof(float) * img])),
                 cv::Mat(batchInput[0].rows, batchInput[0].cols, CV_32F, &(dst.ptr()[width * sizeof(float) + width * 3 * sizeof(float) * img])),
                 cv::Mat(batchInput[0].rows, batchInput[0].cols, CV_32F, &(dst.ptr()[width * 2 * sizeof(float) + width * 3 * sizeof(float) * img]))};
             cv::split(batchInput[img], input_channels); // HWC -> CHW
         }
+    }
+
+    inline cv::Mat blobFromMats(const std::vector<cv::Mat> &batchInput)
+    {
+        cv::Mat dst;
+        blobFromMats(batchInput, dst);
         return dst;
     }
 } // namespace trt
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <opencv2/opencv.hpp>
+
+namespace video
+{
+
+    // Open a video file, stream URL or camera index (0,1,...)
+    bool openSource(cv::VideoCapture &capture, const std::string &source);
+
+    // Keeps only the newest frame of a live source.
+    // A dedicated thread grabs frames as fast as the source delivers them, so that frames
+    // never queue up in the capture backend when processing is slower than the camera.
+    class LatestFrameCapture
+    {
+    public:
+        // The capture must be opened, it is exclusively used by the grab thread until release()
+        explicit LatestFrameCapture(cv::VideoCapture &capture);
+        ~LatestFrameCapture();
+
+        LatestFrameCapture(const LatestFrameCapture &) = delete;
+        LatestFrameCapture &operator=(const LatestFrameCapture &) = delete;
+
+        // Wait for a frame newer than the last one read, false once the source is exhausted
+        bool read(cv::Mat &image);
+        // Take the latest frame if a new one is available, never blocks
+        bool tryRead(cv::Mat &image);
+        // Stop the grab thread and give the capture back to the caller
+        void release();
+
+        [[nodiscard]] bool isFinished();
+        [[nodiscard]] uint64_t getGrabbedFrames() const { return m_grabbed; };
+        [[nodiscard]] uint64_t getDroppedFrames() const { return m_dropped; };
+
+    private:
+        void grabLoop();
+
+        cv::VideoCapture &m_capture;
+        std::thread m_thread;
+
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        cv::Mat m_latest{};
+        bool m_hasFrame = false;
+        bool m_finished = false;
+
+        std::atomic<bool> m_running{true};
+        std::atomic<uint64_t> m_grabbed{0};
+        std::atomic<uint64_t> m_dropped{0};
+    };
+
+} // namespace video
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "video/capture.hpp"
+
+namespace video
+{
+
+    struct SourceFrame
+    {
+        size_t source = 0;
+        cv::Mat image{};
+    };
+
+    struct SourceStats
+    {
+        uint64_t processed = 0;
+        uint64_t dropped = 0;
+        double fps = 0.0;
+    };
+
+    // Decodes several live sources on their own threads and gathers their latest frames,
+    // so that frames of many streams can be batched into a single engine call.
+    class MultiSourceCapture
+    {
+    public:
+        explicit MultiSourceCapture(const std::vector<std::string> &sources);
+        ~MultiSourceCapture();
+
+        // Wait for new frames and take at most one (the latest) per source, false once all sources are exhausted
+        bool gather(std::vector<SourceFrame> &batch);
+        void release();
+
+        [[nodiscard]] size_t size() const { return m_sources.size(); };
+        [[nodiscard]] const std::string &getSource(size_t source) const { return m_sources[source]; };
+        [[nodiscard]] double getFps(size_t source) const { return m_fps[source]; };
+        [[nodiscard]] cv::Size getFrameSize(size_t source) const { return m_frameSizes[source]; };
+        [[nodiscard]] std::vector<SourceStats> getStats() const;
+
+    private:
+        std::vector<std::string> m_sources{};
+        std::vector<double> m_fps{};
+        std::vector<cv::Size> m_frameSizes{};
+        std::vector<uint64_t> m_processed{};
+
+        std::vector<std::unique_ptr<cv::VideoCapture>> m_captures{};
+        std::vector<std::unique_ptr<LatestFrameCapture>> m_grabbers{};
+
+        std::chrono::steady_clock::time_point m_start{};
+    };
+
+} // namespace video
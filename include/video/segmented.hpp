@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "io/frame_result.hpp"
+
+namespace video
+{
+
+    // Frame range [begin, end), a negative end reads until the end of the video
+    struct VideoSegment
+    {
+        int64_t begin = 0;
+        int64_t end = -1;
+    };
+
+    using BatchProcessor = std::function<std::vector<std::vector<Detection>>(const std::vector<cv::Mat> &)>;
+    using BatchProcessorFactory = std::function<BatchProcessor(size_t segment)>;
+    using ResultCallback = std::function<void(io::FrameResult &&)>;
+
+    // Splits a single video into time ranges that are decoded and inferred in parallel,
+    // each by its own worker and backend instance. Results are merged back in frame order.
+    // A worker waits once queueSize results of its segment are waiting to be merged.
+    class SegmentedVideoProcessor
+    {
+    public:
+        SegmentedVideoProcessor(const std::string &path, size_t numSegments, size_t batchSize = 1, size_t queueSize = 64);
+        ~SegmentedVideoProcessor();
+
+        // Blocks until the whole video is processed, the callback is invoked in frame order on the calling thread
+        void run(const BatchProcessorFactory &factory, const ResultCallback &callback);
+        // Stop all workers, can be called from the result callback
+        void stop() { m_running = false; };
+
+        [[nodiscard]] const std::vector<VideoSegment> &getSegments() const { return m_segments; };
+
+    private:
+        struct Worker;
+        void processSegment(Worker &worker, const BatchProcessorFactory &factory);
+
+        std::vector<VideoSegment> m_segments{};
+        std::vector<std::unique_ptr<cv::VideoCapture>> m_captures{};
+        const size_t m_batchSize;
+        const size_t m_queueSize;
+        std::atomic<bool> m_running{true};
+    };
+
+} // namespace video
@@ -0,0 +1,108 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <engine/bundle.hpp>
+
+namespace trt
+{
+    ModelBundle::ModelBundle(const std::string &path) : m_file(path)
+    {
+        if (m_file.size() < sizeof(bundle::BundleHeader))
+            throw std::runtime_error("Invalid model bundle " + path);
+
+        m_header = reinterpret_cast<const bundle::BundleHeader *>(m_file.data());
+        if (std::memcmp(m_header->magic, bundle::MAGIC, sizeof(m_header->magic)) != 0 || m_header->version != bundle::VERSION)
+            throw std::runtime_error("Unsupported model bundle " + path);
+
+        if (sizeof(bundle::BundleHeader) + m_header->configSize > m_header->engineOffset ||
+            m_header->engineOffset + m_header->engineSize > m_file.size())
+        {
+            throw std::runtime_error("Truncated model bundle " + path);
+        }
+
+        const char *config = m_file.data() + sizeof(bundle::BundleHeader);
+        m_config = nlohmann::json::parse(config, config + m_header->configSize);
+    }
+
+    bool ModelBundle::isBundle(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        char magic[sizeof(bundle::MAGIC)] = {};
+        return file.read(magic, sizeof(magic)) && std::memcmp(magic, bundle::MAGIC, sizeof(magic)) == 0;
+    }
+
+    void ModelBundle::write(const std::string &path, const nlohmann::json &config, const std::string &enginePath)
+    {
+        MappedFile engine(enginePath);
+        const std::string configData = config.dump();
+
+        bundle::BundleHeader header{};
+        std::memcpy(header.magic, bundle::MAGIC, sizeof(header.magic));
+        header.version = bundle::VERSION;
+        header.configSize = configData.size();
+        header.engineOffset = (sizeof(header) + configData.size() + bundle::ALIGNMENT - 1) / bundle::ALIGNMENT * bundle::ALIGNMENT;
+        header.engineSize = engine.size();
+
+        // Written next to the target and renamed, a bundle is never seen half written
+        const std::string tmpPath = path + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                throw std::runtime_error("Could not create model bundle " + path);
+
+            const std::vector<char> padding(header.engineOffset - sizeof(header) - configData.size(), 0);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(configData.data(), configData.size());
+            file.write(padding.data(), padding.size());
+            file.write(engine.data(), engine.size());
+            if (!file)
+                throw std::runtime_error("Could not write model bundle " + path);
+        }
+
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+            throw std::runtime_error("Could not create model bundle " + path);
+    }
+
+    namespace
+    {
+        // Complete a config section with the matching section of its bundle, if its model is bundled
+        void completeFromBundle(nlohmann::json &section, const std::string &task)
+        {
+            if (!section.is_object() || !section.contains("engine") || !section["engine"].contains("model_path"))
+                return;
+
+            const auto modelPath = section["engine"]["model_path"].get<std::string>();
+            if (!ModelBundle::isBundle(modelPath))
+                return;
+
+            // A bundle with a single section completes the task whatever its name
+            const auto bundleConfig = ModelBundle(modelPath).getConfig();
+            nlohmann::json merged;
+            if (!task.empty() && bundleConfig.contains(task))
+                merged = bundleConfig[task];
+            else if (bundleConfig.size() == 1)
+                merged = bundleConfig.begin().value();
+            else
+                return;
+
+            merged.merge_patch(section);
+            section = std::move(merged);
+        }
+    } // namespace
+
+    nlohmann::json loadConfig(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+            throw std::runtime_error("Could not open config file " + path);
+        auto config = nlohmann::json::parse(file);
+
+        // Single task configs have their engine at the root
+        completeFromBundle(config, "");
+        for (auto &[task, section] : config.items())
+            completeFromBundle(section, task);
+        return config;
+    }
+
+} // namespace trt
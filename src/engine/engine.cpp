@@ -1,5 +1,7 @@
-#include <fstream>
+#include <algorithm>
+#include <chrono>
 #include <boost/filesystem.hpp>
+#include "engine/bundle.hpp"
 #include "engine/engine.hpp"
 #include "utils/cuda_utils.hpp"
 #include "utils/tensorrt_utils.hpp"
@@ -15,8 +17,7 @@ namespace trt
     {
         clearBuffers();
         m_context.reset();
-        m_engine.reset();
-        m_runtime.reset();
+        m_model.reset();
     }
 
     void Engine::clearBuffers()
@@ -33,47 +34,155 @@ namespace trt
         m_IOTensorNames.clear();
     }
 
-    bool Engine::loadNetwork(const std::string &engineModelPath)
+    namespace
     {
-        // Read serialized model from disk
-        if (!fs::exists(engineModelPath))
+        using Clock = std::chrono::steady_clock;
+
+        double elapsedMs(Clock::time_point start)
         {
-            m_logger.log(NvLogger::Severity::kERROR, "{} does not exist", engineModelPath);
-            return false;
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
         }
 
-        std::ifstream file(engineModelPath, std::ios::binary | std::ios::ate);
-        std::streamsize size = file.tellg();
-        file.seekg(0, std::ios::beg);
+        uint64_t elapsedNs(Clock::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        }
 
-        std::vector<char> buffer(size);
-        if (!file.read(buffer.data(), size))
+        // Deserialize an engine file or bundle from a read-only mapping, released once deserialized
+        std::shared_ptr<EngineModel> deserializeModel(const std::string &engineModelPath, int deviceIndex, EngineLoadTimings &timings)
         {
-            m_logger.log(NvLogger::Severity::kERROR, "Failed to read engine model from disk");
-            return false;
+            auto model = std::make_shared<EngineModel>();
+            auto &logger = model->logger;
+
+            auto start = Clock::now();
+            std::unique_ptr<ModelBundle> bundle = nullptr;
+            std::unique_ptr<MappedFile> file = nullptr;
+            const char *engineData = nullptr;
+            size_t engineSize = 0;
+            try
+            {
+                if (ModelBundle::isBundle(engineModelPath))
+                {
+                    bundle = std::make_unique<ModelBundle>(engineModelPath);
+                    bundle->loadEngine();
+                    engineData = bundle->getEngineData();
+                    engineSize = bundle->getEngineSize();
+                }
+                else
+                {
+                    file = std::make_unique<MappedFile>(engineModelPath);
+                    file->load(0, file->size());
+                    engineData = file->data();
+                    engineSize = file->size();
+                }
+            }
+            catch (const std::exception &e)
+            {
+                logger.log(NvLogger::Severity::kERROR, "Failed to read engine model from disk: {}", e.what());
+                return nullptr;
+            }
+            timings.readMs = elapsedMs(start);
+
+            // Create a runtime
+            start = Clock::now();
+            model->runtime = std::unique_ptr<nvinfer1::IRuntime>(nvinfer1::createInferRuntime(logger));
+            if (!model->runtime)
+            {
+                logger.log(NvLogger::Severity::kERROR, "Failed to create InferRuntime");
+                return nullptr;
+            }
+
+            // Set device
+            cuda::checkCudaErrorCode(cudaSetDevice(deviceIndex));
+
+            // Create engine
+            model->engine = std::unique_ptr<nvinfer1::ICudaEngine>(model->runtime->deserializeCudaEngine(engineData, engineSize));
+            if (!model->engine)
+            {
+                logger.log(NvLogger::Severity::kERROR, "Failed to deserialize engine");
+                return nullptr;
+            }
+            timings.deserializeMs = elapsedMs(start);
+            return model;
         }
+    } // namespace
+
+    EngineRegistry &EngineRegistry::instance()
+    {
+        static EngineRegistry registry;
+        return registry;
+    }
 
-        // Create a runtime
-        m_runtime = std::unique_ptr<nvinfer1::IRuntime>(nvinfer1::createInferRuntime(m_logger));
-        if (!m_runtime)
+    std::shared_ptr<EngineModel> EngineRegistry::acquire(const std::string &engineModelPath, int deviceIndex, EngineLoadTimings &timings)
+    {
+        // Paths are canonical so that two spellings of a file share its model
+        boost::system::error_code error;
+        const auto path = fs::canonical(engineModelPath, error);
+        const std::pair<std::string, int> key(error ? engineModelPath : path.string(), deviceIndex);
+
+        std::shared_ptr<Entry> entry;
         {
-            m_logger.log(NvLogger::Severity::kERROR, "Failed to create InferRuntime");
-            return false;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto &slot = m_entries[key];
+            if (!slot)
+                slot = std::make_shared<Entry>();
+            entry = slot;
         }
 
-        // Set device
-        cuda::checkCudaErrorCode(cudaSetDevice(m_options.deviceIndex));
+        // Concurrent loads of the same model wait for the first one
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        if (auto model = entry->model.lock())
+        {
+            timings.shared = true;
+            return model;
+        }
+
+        auto model = deserializeModel(key.first, deviceIndex, timings);
+        entry->model = model;
+        return model;
+    }
+
+    size_t EngineRegistry::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::count_if(m_entries.begin(), m_entries.end(), [](const auto &item)
+                             {
+                                 std::lock_guard<std::mutex> entryLock(item.second->mutex);
+                                 return !item.second->model.expired(); });
+    }
 
-        // Create engine
-        m_engine = std::unique_ptr<nvinfer1::ICudaEngine>(m_runtime->deserializeCudaEngine(buffer.data(), buffer.size()));
-        if (!m_engine)
+    bool Engine::loadNetwork(const std::string &engineModelPath)
+    {
+        if (!fs::exists(engineModelPath))
         {
-            m_logger.log(NvLogger::Severity::kERROR, "Failed to deserialize engine");
+            m_logger.log(NvLogger::Severity::kERROR, "{} does not exist", engineModelPath);
             return false;
         }
 
+        // Weights are shared with the other engines of the same model, see EngineRegistry
+        m_loadTimings = {};
+        m_model = EngineRegistry::instance().acquire(engineModelPath, m_options.deviceIndex, m_loadTimings);
+        if (!m_model)
+        {
+            return false;
+        }
+
+        m_modelName = fs::path(engineModelPath).stem().string();
+        auto &registry = metrics::Registry::instance();
+        m_inputLatency = &registry.latency("trt_engine_input_seconds", {{"model", m_modelName}});
+        m_enqueueLatency = &registry.latency("trt_engine_enqueue_seconds", {{"model", m_modelName}});
+        m_outputLatency = &registry.latency("trt_engine_output_seconds", {{"model", m_modelName}});
+        m_traceName = metrics::Tracer::instance().intern(m_modelName);
+        m_inputAllocations = metrics::getAllocationMetrics({{"model", m_modelName}, {"stage", "input"}});
+        m_enqueueAllocations = metrics::getAllocationMetrics({{"model", m_modelName}, {"stage", "enqueue"}});
+        m_outputAllocations = metrics::getAllocationMetrics({{"model", m_modelName}, {"stage", "output"}});
+
+        // Set device
+        cuda::checkCudaErrorCode(cudaSetDevice(m_options.deviceIndex));
+
         // Create execution context
-        m_context = std::unique_ptr<nvinfer1::IExecutionContext>(m_engine->createExecutionContext());
+        const auto start = Clock::now();
+        m_context = std::unique_ptr<nvinfer1::IExecutionContext>(m_model->engine->createExecutionContext());
         if (!m_context)
         {
             m_logger.log(NvLogger::Severity::kERROR, "Failed to create execution context");
@@ -86,14 +195,14 @@ namespace trt
 
         // Allocate GPU memory for input and output buffers
         clearBuffers();
-        m_buffers.resize(m_engine->getNbIOTensors());
+        m_buffers.resize(m_model->engine->getNbIOTensors());
 
-        for (int i = 0; i < m_engine->getNbIOTensors(); ++i)
+        for (int i = 0; i < m_model->engine->getNbIOTensors(); ++i)
         {
-            const auto tensorName = m_engine->getIOTensorName(i);
-            const auto tensorType = m_engine->getTensorIOMode(tensorName);
-            const auto tensorShape = m_engine->getTensorShape(tensorName);
-            const auto tensorDataType = m_engine->getTensorDataType(tensorName);
+            const auto tensorName = m_model->engine->getIOTensorName(i);
+            const auto tensorType = m_model->engine->getTensorIOMode(tensorName);
+            const auto tensorShape = m_model->engine->getTensorShape(tensorName);
+            const auto tensorDataType = m_model->engine->getTensorDataType(tensorName);
             m_IOTensorNames.emplace_back(tensorName);
 
             if (tensorDataType != nvinfer1::DataType::kFLOAT)
@@ -132,13 +241,30 @@ namespace trt
         // Synchronize and destroy the CUDA stream
         cuda::checkCudaErrorCode(cudaStreamSynchronize(stream));
         cuda::checkCudaErrorCode(cudaStreamDestroy(stream));
+        m_loadTimings.contextMs = elapsedMs(start);
 
         return true;
     }
 
+    bool Engine::warmUp()
+    {
+        const auto start = Clock::now();
+        std::vector<std::vector<cv::Mat>> inputs;
+        for (const auto &dims : m_inputDims)
+        {
+            inputs.emplace_back(1, cv::Mat::zeros(dims.d[1], dims.d[2], CV_32FC(dims.d[0])));
+        }
+
+        std::vector<std::vector<std::vector<float>>> outputs;
+        const bool success = runInference(inputs, outputs);
+        m_loadTimings.warmupMs = elapsedMs(start);
+        return success;
+    }
+
     bool Engine::prepareInputs(const std::vector<std::vector<cv::Mat>> &inputs, cudaStream_t &inferenceCudaStream, const int32_t batchSize)
     {
         const auto numInputs = m_inputDims.size();
+        m_inputBlobs.resize(numInputs);
 
         for (size_t i = 0; i < numInputs; ++i)
         {
@@ -159,7 +285,8 @@ namespace trt
             // TODO: Separate m_InputTensor and m_OutputTensors
             m_context->setInputShape(m_IOTensorNames[i].c_str(), inputDims);
             // OpenCV reads images into memory in NHWC format, while TensorRT expects images in NCHW format
-            auto mfloat = blobFromMats(inputBatch);
+            auto &mfloat = m_inputBlobs[i];
+            blobFromMats(inputBatch, mfloat);
             auto *dataPointer = mfloat.ptr<void>();
 
             cuda::checkCudaErrorCode(cudaMemcpyAsync(
@@ -233,6 +360,7 @@ namespace trt
         }
 
         const auto numInputs = m_inputDims.size();
+        m_inputBlobs.resize(numInputs);
         if (inputs.size() != numInputs)
         {
             m_logger.log(NvLogger::Severity::kERROR, "Incorrect number of inputs provided!");
@@ -265,10 +393,16 @@ namespace trt
         cuda::checkCudaErrorCode(cudaStreamCreate(&inferenceCudaStream));
 
         // Load inputs to CUDA memory
-        if (!prepareInputs(inputs, inferenceCudaStream, batchSize))
+        auto phaseStart = Clock::now();
         {
-            return false;
+            metrics::TraceSpan span("input", m_traceName);
+            metrics::AllocationScope allocations(m_inputAllocations);
+            if (!prepareInputs(inputs, inferenceCudaStream, batchSize))
+            {
+                return false;
+            }
         }
+        m_inputLatency->record(elapsedNs(phaseStart));
 
         // Ensure all dynamic bindings have been defined
         if (!m_context->allInputDimensionsSpecified())
@@ -286,19 +420,31 @@ namespace trt
         }
 
         // Run inference
-        if (!m_context->enqueueV3(inferenceCudaStream))
+        phaseStart = Clock::now();
         {
-            return false;
+            metrics::TraceSpan span("enqueue", m_traceName);
+            metrics::AllocationScope allocations(m_enqueueAllocations);
+            if (!m_context->enqueueV3(inferenceCudaStream))
+            {
+                return false;
+            }
         }
+        m_enqueueLatency->record(elapsedNs(phaseStart));
 
         // Copy the outputs back to CPU
-        if (!prepareOutputs(outputs, inferenceCudaStream, batchSize))
+        phaseStart = Clock::now();
         {
-            return false;
-        }
+            metrics::TraceSpan span("output", m_traceName);
+            metrics::AllocationScope allocations(m_outputAllocations);
+            if (!prepareOutputs(outputs, inferenceCudaStream, batchSize))
+            {
+                return false;
+            }
 
-        // Synchronize the cuda stream
-        cuda::checkCudaErrorCode(cudaStreamSynchronize(inferenceCudaStream));
+            // Synchronize the cuda stream
+            cuda::checkCudaErrorCode(cudaStreamSynchronize(inferenceCudaStream));
+        }
+        m_outputLatency->record(elapsedNs(phaseStart));
         cuda::checkCudaErrorCode(cudaStreamDestroy(inferenceCudaStream));
         return true;
     }
@@ -307,11 +453,12 @@ namespace trt
     {
         outputs.clear();
         const auto numInputs = m_inputDims.size();
+        m_inputBlobs.resize(numInputs);
         for (int batch = 0; batch < batchSize; ++batch)
         {
             // Batch
             std::vector<std::vector<float>> batchOutputs{};
-            for (int32_t outputBinding = numInputs; outputBinding < m_engine->getNbIOTensors(); ++outputBinding)
+            for (int32_t outputBinding = numInputs; outputBinding < m_model->engine->getNbIOTensors(); ++outputBinding)
             {
                 // TODO: just separate inputs/outputs in different buffers
                 // We start at index m_inputDims.size() to account for the inputs in our m_buffers
@@ -342,6 +489,36 @@ namespace trt
         return success;
     }
 
+    StartupReport &StartupReport::instance()
+    {
+        static StartupReport report;
+        return report;
+    }
+
+    void StartupReport::add(const std::string &modelPath, const EngineLoadTimings &timings)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_engines.emplace_back(modelPath, timings);
+    }
+
+    nlohmann::json StartupReport::toJson() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        nlohmann::json engines = nlohmann::json::array();
+        for (const auto &[modelPath, timings] : m_engines)
+        {
+            engines.push_back({
+                {"model", modelPath},
+                {"read_ms", timings.readMs},
+                {"deserialize_ms", timings.deserializeMs},
+                {"context_ms", timings.contextMs},
+                {"warmup_ms", timings.warmupMs},
+                {"shared", timings.shared},
+            });
+        }
+        return engines;
+    }
+
     void setEngineOptions(EngineOptions &options, int batchSize, Precision precision)
     {
         // Specify what precision to use for inference. FP16 is approximately twice as fast as FP32
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include <engine/preprocess.hpp>
+
+namespace trt
+{
+    namespace
+    {
+        // Region of the tensor covered by the resized image, the rest is padding. The letterbox geometry is the one
+        // of letterbox() in utils/detection_utils.hpp: the image is scaled to fit and centered, padded up to the
+        // input size or only up to a multiple of the stride with autoShape, or stretched with scaleFill.
+        cv::Rect getImageRegion(const cv::Size &imageSize, const PreprocessDescriptor &descriptor, cv::Size &tensorSize)
+        {
+            const cv::Size &size = descriptor.size;
+            if (descriptor.resize == ResizeMode::STRETCH)
+            {
+                tensorSize = size;
+                return cv::Rect(0, 0, size.width, size.height);
+            }
+
+            double ratio = std::min(static_cast<double>(size.width) / imageSize.width, static_cast<double>(size.height) / imageSize.height);
+            if (!descriptor.scaleUp)
+                ratio = std::min(ratio, 1.0);
+
+            cv::Size scaled(static_cast<int>(std::round(imageSize.width * ratio)), static_cast<int>(std::round(imageSize.height * ratio)));
+            int padWidth = size.width - scaled.width;
+            int padHeight = size.height - scaled.height;
+            if (descriptor.autoShape)
+            {
+                padWidth %= descriptor.stride;
+                padHeight %= descriptor.stride;
+            }
+            else if (descriptor.scaleFill)
+            {
+                padWidth = padHeight = 0;
+                scaled = size;
+            }
+
+            tensorSize = cv::Size(scaled.width + padWidth, scaled.height + padHeight);
+            return cv::Rect(padWidth / 2, padHeight / 2, scaled.width, scaled.height);
+        }
+    } // namespace
+
+    cv::Mat preprocessImage(const cv::Mat &image, const PreprocessDescriptor &descriptor)
+    {
+        PreprocessBuffers buffers;
+        return preprocessImage(image, descriptor, buffers);
+    }
+
+    const cv::Mat &preprocessImage(const cv::Mat &image, const PreprocessDescriptor &descriptor, PreprocessBuffers &buffers)
+    {
+        // Every step writes to its own buffer, the source may be shared with other models
+        const cv::Mat *rgb = &image;
+        if (descriptor.swapRB)
+        {
+            cv::cvtColor(image, buffers.rgb, cv::COLOR_BGR2RGB);
+            rgb = &buffers.rgb;
+        }
+
+        cv::Size tensorSize;
+        const cv::Rect region = getImageRegion(rgb->size(), descriptor, tensorSize);
+        const cv::Mat *resized = rgb;
+        if (rgb->size() != region.size())
+        {
+            cv::resize(*rgb, buffers.resized, region.size(), 0, 0, cv::INTER_LINEAR);
+            resized = &buffers.resized;
+        }
+
+        // The image is converted in place into the tensor, the padding is filled around it
+        buffers.tensor.create(tensorSize, descriptor.type);
+        cv::Mat tensorImage = buffers.tensor(region);
+        resized->convertTo(tensorImage, descriptor.type, descriptor.scale);
+        if (region.size() != tensorSize)
+        {
+            const cv::Scalar pad = descriptor.padColor * descriptor.scale;
+            buffers.tensor.rowRange(0, region.y) = pad;
+            buffers.tensor.rowRange(region.br().y, tensorSize.height) = pad;
+            buffers.tensor(cv::Rect(0, region.y, region.x, region.height)) = pad;
+            buffers.tensor(cv::Rect(region.br().x, region.y, tensorSize.width - region.br().x, region.height)) = pad;
+        }
+        return buffers.tensor;
+    }
+
+    void PreprocessCache::addConsumer(const PreprocessDescriptor &descriptor, const std::string &consumer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_consumers[descriptor].insert(consumer);
+    }
+
+    cv::Mat PreprocessCache::get(uint64_t frameId, const cv::Mat &image, const PreprocessDescriptor &descriptor, const std::string &consumer)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto consumers = m_consumers.find(descriptor);
+        if (consumers == m_consumers.end() || consumers->second.size() < 2)
+        {
+            lock.unlock();
+            return preprocessImage(image, descriptor);
+        }
+
+        const auto key = std::make_pair(frameId, descriptor);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end())
+        {
+            // Waits for the consumer computing it, outside of the lock
+            auto tensor = it->second.tensor;
+            it->second.readers.insert(consumer);
+            if (it->second.readers.size() >= consumers->second.size())
+                m_entries.erase(it);
+            lock.unlock();
+
+            ++m_hits;
+            return tensor.get();
+        }
+
+        // A consumer lagging behind the window computes its own tensor, the others already evicted it
+        if (frameId + m_maxFrames <= m_lastFrameId)
+        {
+            lock.unlock();
+            ++m_misses;
+            return preprocessImage(image, descriptor);
+        }
+
+        std::promise<cv::Mat> promise;
+        auto &entry = m_entries[key];
+        entry.tensor = promise.get_future().share();
+        entry.readers.insert(consumer);
+        m_lastFrameId = std::max(m_lastFrameId, frameId);
+        while (!m_entries.empty() && m_entries.begin()->first.first + m_maxFrames <= m_lastFrameId)
+            m_entries.erase(m_entries.begin());
+        lock.unlock();
+
+        ++m_misses;
+        try
+        {
+            cv::Mat tensor = preprocessImage(image, descriptor);
+            promise.set_value(tensor);
+            return tensor;
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+} // namespace trt
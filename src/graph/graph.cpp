@@ -0,0 +1,415 @@
+#include <chrono>
+#include <future>
+#include <thread>
+#include <stdexcept>
+#include <unordered_map>
+#include <utils/bounded_queue.hpp>
+#include <engine/bundle.hpp>
+#include <metrics/metrics.hpp>
+#include <metrics/trace.hpp>
+#include <graph/graph.hpp>
+
+namespace graph
+{
+    struct Graph::Stage
+    {
+        NodeConfig config{};
+        std::vector<std::unique_ptr<Node>> instances{};
+        std::vector<Stage *> outputs{};
+        std::unique_ptr<trt::BoundedQueue<PacketPtr>> queue = nullptr;
+        bool ordered = false;
+
+        // Branches joined and packets reordered before the input queue, fed by upstream workers
+        std::mutex mutex;
+        std::map<uint64_t, std::pair<PacketPtr, size_t>> pending{};
+        std::map<uint64_t, PacketPtr> reorder{};
+        uint64_t nextSequence = 0;
+
+        std::atomic<size_t> openInputs{0};
+        std::atomic<size_t> activeWorkers{0};
+        std::vector<std::thread> threads{};
+
+        std::atomic<uint64_t> packets{0};
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> busyNs{0};
+
+        // Exported per node: call latency, packets and input queue depth
+        metrics::Histogram *latency = nullptr;
+        metrics::Counter *packetsTotal = nullptr;
+        metrics::Gauge *queueDepth = nullptr;
+        // Interned, the trace may be dumped after the graph is destroyed
+        const char *traceName = nullptr;
+        const char *traceType = nullptr;
+    };
+
+    void NodeConfig::loadFromJson(const nlohmann::json &data)
+    {
+        params = data;
+        name = data.at("name").get<std::string>();
+        type = data.at("type").get<std::string>();
+        if (data.contains("inputs"))
+            inputs = data["inputs"].get<std::vector<std::string>>();
+        if (data.contains("workers"))
+            workers = std::max(1, data["workers"].get<int>());
+        if (data.contains("queue"))
+            queueSize = std::max(1, data["queue"].get<int>());
+        if (data.contains("batch"))
+            batchSize = std::max(1, data["batch"].get<int>());
+    }
+
+    namespace
+    {
+        GraphContext loadContext(const std::string &configPath)
+        {
+            return {configPath, trt::loadConfig(configPath), nullptr};
+        }
+    } // namespace
+
+    Graph::Graph(const std::string &configPath) : Graph(loadContext(configPath)) {}
+
+    Graph::Graph(const GraphContext &t_context)
+    {
+        GraphContext context = t_context;
+        if (!context.preprocessCache)
+            context.preprocessCache = std::make_shared<trt::PreprocessCache>();
+
+        if (!context.config.contains("graph") || !context.config["graph"].contains("nodes"))
+            throw std::runtime_error("Config file does not contain a graph");
+
+        std::vector<NodeConfig> nodes;
+        std::unordered_map<std::string, size_t> indices;
+        for (const auto &data : context.config["graph"]["nodes"])
+        {
+            NodeConfig node;
+            node.loadFromJson(data);
+            if (!indices.emplace(node.name, nodes.size()).second)
+                throw std::runtime_error("Duplicate graph node " + node.name);
+            nodes.push_back(std::move(node));
+        }
+
+        // Nodes are created in topological order, sources first
+        std::vector<size_t> inputCounts(nodes.size(), 0);
+        std::vector<std::vector<size_t>> outputs(nodes.size());
+        size_t numSources = 0;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            if (nodes[i].inputs.empty())
+                ++numSources;
+            for (const auto &input : nodes[i].inputs)
+            {
+                auto it = indices.find(input);
+                if (it == indices.end())
+                    throw std::runtime_error("Unknown input " + input + " of graph node " + nodes[i].name);
+                outputs[it->second].push_back(i);
+                ++inputCounts[i];
+            }
+        }
+        if (numSources != 1)
+            throw std::runtime_error("Graph must have exactly one node without inputs, the source");
+
+        std::vector<size_t> order;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            if (inputCounts[i] == 0)
+                order.push_back(i);
+        }
+        for (size_t n = 0; n < order.size(); ++n)
+        {
+            for (size_t output : outputs[order[n]])
+            {
+                if (--inputCounts[output] == 0)
+                    order.push_back(output);
+            }
+        }
+        if (order.size() != nodes.size())
+            throw std::runtime_error("Graph has a cycle");
+
+        // Node instances are independent, their models are loaded concurrently
+        std::vector<std::vector<std::future<std::unique_ptr<Node>>>> futures(nodes.size());
+        for (size_t i : order)
+        {
+            if (nodes[i].inputs.empty())
+                nodes[i].workers = 1;
+            for (size_t worker = 0; worker < nodes[i].workers; ++worker)
+            {
+                futures[i].push_back(std::async(std::launch::async, [&node = nodes[i], &context]()
+                                                { return NodeRegistry::instance().create(node, context); }));
+            }
+        }
+
+        // Every instance is waited for before the first error is rethrown
+        std::vector<std::vector<std::unique_ptr<Node>>> instances(nodes.size());
+        std::exception_ptr error = nullptr;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            for (auto &future : futures[i])
+            {
+                try
+                {
+                    instances[i].push_back(future.get());
+                }
+                catch (...)
+                {
+                    if (!error)
+                        error = std::current_exception();
+                }
+            }
+        }
+        if (error)
+            std::rethrow_exception(error);
+
+        std::unordered_map<std::string, Stage *> stages;
+        for (size_t i : order)
+        {
+            auto stage = std::make_unique<Stage>();
+            stage->config = nodes[i];
+            stage->instances = std::move(instances[i]);
+
+            stage->ordered = stage->instances[0]->isOrdered();
+            if (stage->ordered && stage->config.workers > 1)
+                throw std::runtime_error("Graph node " + stage->config.name + " is ordered and runs on a single worker");
+
+            stage->queue = std::make_unique<trt::BoundedQueue<PacketPtr>>(stage->config.queueSize);
+            auto &registry = metrics::Registry::instance();
+            const metrics::Labels labels = {{"node", stage->config.name}, {"type", stage->config.type}};
+            stage->latency = &registry.latency("graph_node_seconds", labels);
+            stage->packetsTotal = &registry.counter("graph_node_packets_total", labels);
+            stage->queueDepth = &registry.gauge("graph_node_queue_depth", labels);
+            stage->traceName = metrics::Tracer::instance().intern(stage->config.name);
+            stage->traceType = metrics::Tracer::instance().intern(stage->config.type);
+            stage->openInputs = stage->config.inputs.size();
+            for (const auto &input : stage->config.inputs)
+                stages.at(input)->outputs.push_back(stage.get());
+
+            stages[stage->config.name] = stage.get();
+            m_stages.push_back(std::move(stage));
+        }
+    }
+
+    Graph::~Graph()
+    {
+        stop();
+        for (auto &stage : m_stages)
+        {
+            stage->queue->close();
+            for (auto &thread : stage->threads)
+            {
+                if (thread.joinable())
+                    thread.join();
+            }
+        }
+    }
+
+    void Graph::run()
+    {
+        m_running = true;
+        for (auto &stage : m_stages)
+        {
+            stage->activeWorkers = stage->instances.size();
+            for (size_t worker = 0; worker < stage->instances.size(); ++worker)
+                stage->threads.emplace_back(&Graph::work, this, std::ref(*stage), worker);
+        }
+
+        for (auto &stage : m_stages)
+        {
+            for (auto &thread : stage->threads)
+                thread.join();
+            stage->threads.clear();
+        }
+
+        if (m_error)
+            std::rethrow_exception(m_error);
+    }
+
+    void Graph::work(Stage &stage, size_t worker)
+    {
+        using Clock = std::chrono::steady_clock;
+        auto &node = *stage.instances[worker];
+        metrics::Tracer::setThreadName(stage.config.name + "/" + std::to_string(worker));
+        try
+        {
+            if (stage.config.inputs.empty())
+            {
+                for (uint64_t sequence = 0; m_running; ++sequence)
+                {
+                    auto packet = std::make_shared<Packet>();
+                    packet->sequence = sequence;
+
+                    metrics::Tracer::setFrame(static_cast<int64_t>(sequence));
+                    const auto start = Clock::now();
+                    {
+                        metrics::TraceSpan span(stage.traceName, stage.traceType);
+                        if (!node.read(*packet))
+                            break;
+                    }
+                    const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+                    stage.busyNs += elapsed;
+                    ++stage.packets;
+                    ++stage.calls;
+                    stage.latency->record(elapsed);
+                    stage.packetsTotal->add();
+
+                    emit(stage, std::move(packet));
+                }
+            }
+            else
+            {
+                // Whatever is already queued joins the batch, a batch is never waited for
+                std::vector<PacketPtr> batch;
+                while (auto packet = stage.queue->pop())
+                {
+                    batch.clear();
+                    batch.push_back(std::move(*packet));
+                    while (batch.size() < stage.config.batchSize)
+                    {
+                        auto next = stage.queue->tryPop();
+                        if (!next)
+                            break;
+                        batch.push_back(std::move(*next));
+                    }
+                    stage.queueDepth->set(static_cast<double>(stage.queue->size()));
+
+                    // Spans of a batch are attributed to its first frame
+                    metrics::Tracer::setFrame(static_cast<int64_t>(batch.front()->sequence));
+                    const auto start = Clock::now();
+                    {
+                        metrics::TraceSpan span(stage.traceName, stage.traceType);
+                        node.process(batch);
+                    }
+                    const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+                    stage.busyNs += elapsed;
+                    stage.packets += batch.size();
+                    ++stage.calls;
+                    stage.latency->record(elapsed);
+                    stage.packetsTotal->add(batch.size());
+
+                    for (auto &output : batch)
+                        emit(stage, std::move(output));
+                }
+            }
+            node.close();
+        }
+        catch (...)
+        {
+            fail(std::current_exception());
+        }
+
+        if (--stage.activeWorkers == 0)
+        {
+            for (auto *output : stage.outputs)
+                closeInput(*output);
+        }
+    }
+
+    void Graph::emit(Stage &stage, PacketPtr packet)
+    {
+        // The last branch takes the packet, the others get a copy of its detections
+        for (size_t i = 0; i < stage.outputs.size(); ++i)
+        {
+            deliver(*stage.outputs[i], i + 1 == stage.outputs.size() ? std::move(packet) : std::make_shared<Packet>(*packet));
+        }
+    }
+
+    void Graph::deliver(Stage &stage, PacketPtr packet)
+    {
+        if (stage.config.inputs.size() == 1 && !stage.ordered)
+        {
+            stage.queue->push(std::move(packet));
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(stage.mutex);
+        if (stage.config.inputs.size() > 1)
+        {
+            const uint64_t sequence = packet->sequence;
+            auto &[joined, count] = stage.pending[sequence];
+            if (joined)
+            {
+                mergeDetections(joined->detections, packet->detections);
+                joined->classifications.insert(packet->classifications.begin(), packet->classifications.end());
+            }
+            else
+                joined = std::move(packet);
+
+            if (++count < stage.config.inputs.size())
+                return;
+
+            packet = std::move(joined);
+            stage.pending.erase(sequence);
+        }
+
+        if (!stage.ordered)
+        {
+            lock.unlock();
+            stage.queue->push(std::move(packet));
+            return;
+        }
+
+        // Pushed under the lock so that concurrent upstream workers cannot interleave
+        stage.reorder.emplace(packet->sequence, std::move(packet));
+        for (auto it = stage.reorder.begin(); it != stage.reorder.end() && it->first == stage.nextSequence; it = stage.reorder.erase(it))
+        {
+            stage.queue->push(std::move(it->second));
+            ++stage.nextSequence;
+        }
+    }
+
+    void Graph::closeInput(Stage &stage)
+    {
+        if (--stage.openInputs == 0)
+            stage.queue->close();
+    }
+
+    void Graph::fail(std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            if (!m_error)
+                m_error = error;
+        }
+
+        // Unblock every worker, packets already queued are drained
+        m_running = false;
+        for (auto &stage : m_stages)
+            stage->queue->close();
+    }
+
+    nlohmann::json Graph::getStats() const
+    {
+        nlohmann::json stats = nlohmann::json::array();
+        for (const auto &stage : m_stages)
+        {
+            const uint64_t calls = stage->calls;
+            stats.push_back({
+                {"name", stage->config.name},
+                {"type", stage->config.type},
+                {"workers", stage->instances.size()},
+                {"packets", stage->packets.load()},
+                {"batch", calls > 0 ? static_cast<double>(stage->packets) / calls : 0.0},
+                {"busy_ms", stage->busyNs / 1e6},
+                {"queue", stage->queue->size()},
+            });
+        }
+        return stats;
+    }
+
+    void mergeDetections(std::vector<Detection> &detections, const std::vector<Detection> &other)
+    {
+        if (detections.size() != other.size())
+            throw std::runtime_error("Joined graph branches must not add or remove detections");
+
+        for (size_t i = 0; i < detections.size(); ++i)
+        {
+            auto &det = detections[i];
+            const auto &otherDet = other[i];
+            det.labels.insert(otherDet.labels.begin(), otherDet.labels.end());
+            if (det.features.empty())
+                det.features = otherDet.features;
+            if (det.mask.empty())
+                det.mask = otherDet.mask;
+            if (det.track_id < 0)
+                det.track_id = otherDet.track_id;
+        }
+    }
+
+} // namespace graph
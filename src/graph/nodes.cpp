@@ -0,0 +1,305 @@
+#include <chrono>
+#include <stdexcept>
+#include <types/frame.hpp>
+#include <video/capture.hpp>
+#include <io/result_writer.hpp>
+#include <models/reid/reid.hpp>
+#include <models/detection/factory.hpp>
+#include <models/segmentation/factory.hpp>
+#include <models/classification/cascade.hpp>
+#include <graph/node.hpp>
+
+namespace graph
+{
+    namespace
+    {
+        // Section of the config file a model node is loaded from, the node parameter `config` or the default one
+        std::string getSection(const NodeConfig &node, const GraphContext &context, const std::string &defaultSection)
+        {
+            const std::string section = node.params.value("config", defaultSection);
+            if (!context.config.contains(section))
+                throw std::runtime_error("Config file does not contain task: " + section);
+            return section;
+        }
+
+        // Video file or camera index, live sources drop stale frames
+        class SourceNode : public Node
+        {
+        public:
+            SourceNode(const NodeConfig &node)
+            {
+                const std::string input = node.params.value("input", "");
+                if (!video::openSource(m_capture, input))
+                    throw std::runtime_error("Could not open video source " + input);
+
+                if (node.params.value("live", false))
+                    m_liveCapture = std::make_unique<video::LatestFrameCapture>(m_capture);
+            }
+
+            bool read(Packet &packet) override
+            {
+                packet.frameIndex = m_frameIndex++;
+                if (m_liveCapture)
+                {
+                    packet.timestamp = std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+                    return m_liveCapture->read(packet.image);
+                }
+                if (!m_capture.read(packet.image) || packet.image.empty())
+                    return false;
+                packet.timestamp = m_capture.get(cv::CAP_PROP_POS_MSEC);
+                return true;
+            }
+
+            void process([[maybe_unused]] std::vector<PacketPtr> &packets) override {};
+
+            void close() override
+            {
+                if (m_liveCapture)
+                    m_liveCapture->release();
+                m_capture.release();
+            }
+
+        private:
+            cv::VideoCapture m_capture;
+            std::unique_ptr<video::LatestFrameCapture> m_liveCapture = nullptr;
+            int64_t m_frameIndex = 0;
+        };
+
+        // Detector or segmenter, the packets of a batch are detected in a single call
+        class DetectorNode : public Node
+        {
+        public:
+            DetectorNode(std::unique_ptr<trt::DetectionProcessor> detector, const NodeConfig &node, const GraphContext &context)
+                : m_detector(std::move(detector))
+            {
+                m_detector->setPreprocessCache(context.preprocessCache, node.name);
+            }
+
+            void process(std::vector<PacketPtr> &packets) override
+            {
+                std::vector<cv::Mat> images;
+                std::vector<uint64_t> sequences;
+                images.reserve(packets.size());
+                sequences.reserve(packets.size());
+                for (const auto &packet : packets)
+                {
+                    images.push_back(packet->image);
+                    sequences.push_back(packet->sequence);
+                }
+
+                auto detections = m_detector->process(images, sequences);
+                for (size_t i = 0; i < packets.size(); ++i)
+                    packets[i]->detections = std::move(detections[i]);
+            }
+
+        private:
+            std::unique_ptr<trt::DetectionProcessor> m_detector;
+        };
+
+        // Labels of the detections, the crops of a batch are classified together
+        class ClassifierNode : public Node
+        {
+        public:
+            ClassifierNode(const NodeConfig &node, const GraphContext &context)
+            {
+                const std::string section = getSection(node, context, "classifier");
+                m_config.loadFromJson(node.params);
+                m_classifier = cls::createClassifier(context.config[section], m_config.multiLabel);
+            }
+
+            void process(std::vector<PacketPtr> &packets) override
+            {
+                std::vector<cv::Mat> images;
+                std::vector<std::vector<Detection>> detections;
+                for (auto &packet : packets)
+                {
+                    images.push_back(packet->image);
+                    detections.push_back(std::move(packet->detections));
+                }
+
+                cls::classifyDetections(*m_classifier, m_config, images, detections);
+                for (size_t i = 0; i < packets.size(); ++i)
+                    packets[i]->detections = std::move(detections[i]);
+            }
+
+        private:
+            cls::CascadeConfig m_config{};
+            std::unique_ptr<trt::ClassificationProcessor> m_classifier = nullptr;
+        };
+
+        // Classes of the whole frame, the frames of a batch are classified together
+        class FrameClassifierNode : public Node
+        {
+        public:
+            FrameClassifierNode(const NodeConfig &node, const GraphContext &context)
+                : m_name(node.name)
+            {
+                const std::string section = getSection(node, context, "classifier");
+                m_classifier = cls::createClassifier(context.config[section], node.params.value("multi_label", false));
+                m_classifier->setPreprocessCache(context.preprocessCache, node.name);
+            }
+
+            void process(std::vector<PacketPtr> &packets) override
+            {
+                std::vector<cv::Mat> images;
+                std::vector<uint64_t> sequences;
+                images.reserve(packets.size());
+                sequences.reserve(packets.size());
+                for (const auto &packet : packets)
+                {
+                    images.push_back(packet->image);
+                    sequences.push_back(packet->sequence);
+                }
+
+                auto classes = m_classifier->process(images, sequences);
+                for (size_t i = 0; i < packets.size(); ++i)
+                    packets[i]->classifications[m_name] = std::move(classes[i]);
+            }
+
+        private:
+            const std::string m_name;
+            std::unique_ptr<trt::ClassificationProcessor> m_classifier = nullptr;
+        };
+
+        class ReIdNode : public Node
+        {
+        public:
+            ReIdNode(const NodeConfig &node, const GraphContext &context)
+                : m_reid(reid::ReIdConfig::load(context.configPath, node.params.value("config", "reid"))) {}
+
+            void process(std::vector<PacketPtr> &packets) override
+            {
+                for (auto &packet : packets)
+                    m_reid.extractFeatures(packet->image, packet->detections);
+            }
+
+        private:
+            reid::ReId m_reid;
+        };
+
+        // Structured results, see io::ResultFormat
+        class ResultsNode : public Node
+        {
+        public:
+            ResultsNode(const NodeConfig &node)
+            {
+                const std::string format = node.params.value("format", "json");
+                if (io::getResultFormat(format) == io::ResultFormat::UNKNOWN)
+                    throw std::runtime_error("Unknown result format " + format);
+
+                m_writer = std::make_unique<io::AsyncResultWriter>(node.params.value("path", "-"),
+                                                                   io::getResultFormat(format),
+                                                                   node.params.value("embeddings", false));
+            }
+
+            void process(std::vector<PacketPtr> &packets) override
+            {
+                for (auto &packet : packets)
+                    m_writer->write({packet->frameIndex, packet->timestamp, packet->detections, packet->classifications});
+            }
+
+            bool isOrdered() const override { return true; };
+
+            void close() override { m_writer->close(); };
+
+        private:
+            std::unique_ptr<io::AsyncResultWriter> m_writer = nullptr;
+        };
+
+        // Frames with their detections drawn, opened on the first frame
+        class VideoNode : public Node
+        {
+        public:
+            VideoNode(const NodeConfig &node)
+                : m_path(node.params.at("path").get<std::string>()), m_fps(node.params.value("fps", 25.0)) {}
+
+            void process(std::vector<PacketPtr> &packets) override
+            {
+                for (auto &packet : packets)
+                {
+                    Frame frame;
+                    frame.image = packet->image;
+                    cv::Mat output = frame.draw(packet->detections, true, true);
+
+                    if (!m_writer.isOpened())
+                    {
+                        m_writer.open(m_path, cv::VideoWriter::fourcc('m', 'p', '4', 'v'), m_fps, output.size());
+                        if (!m_writer.isOpened())
+                            throw std::runtime_error("Could not create output video " + m_path);
+                    }
+                    m_writer.write(output);
+                }
+            }
+
+            bool isOrdered() const override { return true; };
+
+            void close() override { m_writer.release(); };
+
+        private:
+            const std::string m_path;
+            const double m_fps;
+            cv::VideoWriter m_writer;
+        };
+    } // namespace
+
+    NodeRegistry::NodeRegistry()
+    {
+        m_factories["source"] = [](const NodeConfig &node, const GraphContext &)
+        { return std::make_unique<SourceNode>(node); };
+        m_factories["detector"] = [](const NodeConfig &node, const GraphContext &context)
+        { return std::make_unique<DetectorNode>(det::DetectorFactory::create(context.config, getSection(node, context, "detector")), node, context); };
+        m_factories["segmenter"] = [](const NodeConfig &node, const GraphContext &context)
+        { return std::make_unique<DetectorNode>(seg::SegmenterFactory::create(context.config, getSection(node, context, "segmenter")), node, context); };
+        m_factories["classifier"] = [](const NodeConfig &node, const GraphContext &context)
+        { return std::make_unique<ClassifierNode>(node, context); };
+        m_factories["frame_classifier"] = [](const NodeConfig &node, const GraphContext &context)
+        { return std::make_unique<FrameClassifierNode>(node, context); };
+        m_factories["reid"] = [](const NodeConfig &node, const GraphContext &context)
+        { return std::make_unique<ReIdNode>(node, context); };
+        m_factories["results"] = [](const NodeConfig &node, const GraphContext &)
+        { return std::make_unique<ResultsNode>(node); };
+        m_factories["video"] = [](const NodeConfig &node, const GraphContext &)
+        { return std::make_unique<VideoNode>(node); };
+    }
+
+    NodeRegistry &NodeRegistry::instance()
+    {
+        static NodeRegistry registry;
+        return registry;
+    }
+
+    void NodeRegistry::add(const std::string &type, NodeFactory factory)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_factories[type] = std::move(factory);
+    }
+
+    std::unique_ptr<Node> NodeRegistry::create(const NodeConfig &node, const GraphContext &context) const
+    {
+        NodeFactory factory;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_factories.find(node.type);
+            if (it == m_factories.end())
+                throw std::runtime_error("Unknown type " + node.type + " of graph node " + node.name);
+            factory = it->second;
+        }
+        return factory(node, context);
+    }
+
+    bool NodeRegistry::contains(const std::string &type) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_factories.count(type) > 0;
+    }
+
+    std::vector<std::string> NodeRegistry::getTypes() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::string> types;
+        for (const auto &[type, factory] : m_factories)
+            types.push_back(type);
+        return types;
+    }
+
+} // namespace graph
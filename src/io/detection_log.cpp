@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "io/detection_log.hpp"
+
+namespace io
+{
+    namespace
+    {
+        constexpr size_t ALIGNMENT = 8;
+
+        size_t aligned(size_t size)
+        {
+            return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+
+        template <typename T>
+        size_t columnSize(size_t rows)
+        {
+            return aligned(rows * sizeof(T));
+        }
+
+        template <typename T>
+        void writeBlock(std::ostream &stream, const T *data, size_t count)
+        {
+            static const char padding[ALIGNMENT] = {};
+            const size_t size = count * sizeof(T);
+            stream.write(reinterpret_cast<const char *>(data), size);
+            stream.write(padding, aligned(size) - size);
+        }
+
+        // The cursor is reset once a block would end past the chunk, and stays null for the next blocks
+        template <typename T>
+        const T *readBlock(const char *&cursor, const char *end, size_t count)
+        {
+            const size_t size = aligned(count * sizeof(T));
+            if (!cursor || size > static_cast<size_t>(end - cursor))
+            {
+                cursor = nullptr;
+                return nullptr;
+            }
+            const T *block = reinterpret_cast<const T *>(cursor);
+            cursor += size;
+            return block;
+        }
+    } // namespace
+
+    DetectionLogWriter::DetectionLogWriter(std::ostream &stream, size_t chunkRows)
+        : m_stream(stream), m_chunkRows(std::max<size_t>(1, chunkRows))
+    {
+        log::FileHeader header{};
+        std::memcpy(header.magic, log::FILE_MAGIC, sizeof(header.magic));
+        header.version = log::VERSION;
+        m_stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+
+    void DetectionLogWriter::write(const FrameResult &result)
+    {
+        if (!m_hasFrames)
+        {
+            m_firstFrame = result.frameIndex;
+            m_firstTimestamp = result.timestamp;
+            m_hasFrames = true;
+        }
+        m_lastFrame = result.frameIndex;
+        m_lastTimestamp = result.timestamp;
+
+        for (const auto &det : result.detections)
+        {
+            m_frames.push_back(result.frameIndex);
+            m_timestamps.push_back(result.timestamp);
+            m_x.push_back(static_cast<float>(det.bbox.x));
+            m_y.push_back(static_cast<float>(det.bbox.y));
+            m_width.push_back(static_cast<float>(det.bbox.width));
+            m_height.push_back(static_cast<float>(det.bbox.height));
+            m_confidences.push_back(det.confidence);
+            m_classIds.push_back(det.class_id);
+            m_trackIds.push_back(det.track_id);
+        }
+
+        if (m_frames.size() >= m_chunkRows)
+        {
+            writeChunk();
+        }
+    }
+
+    void DetectionLogWriter::close()
+    {
+        writeChunk();
+        flush();
+    }
+
+    void DetectionLogWriter::writeChunk()
+    {
+        const size_t rows = m_frames.size();
+        if (rows > 0)
+        {
+            // Class index block
+            std::map<int32_t, log::ClassIndexEntry> classIndex;
+            for (size_t i = 0; i < rows; ++i)
+            {
+                auto &entry = classIndex.try_emplace(m_classIds[i], log::ClassIndexEntry{m_classIds[i], 0, 0.f, 0}).first->second;
+                entry.count++;
+                entry.maxConfidence = std::max(entry.maxConfidence, m_confidences[i]);
+            }
+            std::vector<log::ClassIndexEntry> classes;
+            classes.reserve(classIndex.size());
+            for (const auto &[classId, entry] : classIndex)
+            {
+                classes.push_back(entry);
+            }
+
+            // Track index block, sorted for binary search
+            std::vector<int32_t> tracks;
+            std::copy_if(m_trackIds.begin(), m_trackIds.end(), std::back_inserter(tracks), [](int32_t id)
+                         { return id >= 0; });
+            std::sort(tracks.begin(), tracks.end());
+            tracks.erase(std::unique(tracks.begin(), tracks.end()), tracks.end());
+
+            log::ChunkHeader header{};
+            std::memcpy(header.magic, log::CHUNK_MAGIC, sizeof(header.magic));
+            header.rowCount = static_cast<uint32_t>(rows);
+            header.firstFrame = m_firstFrame;
+            header.lastFrame = m_lastFrame;
+            header.firstTimestamp = m_firstTimestamp;
+            header.lastTimestamp = m_lastTimestamp;
+            header.maxConfidence = *std::max_element(m_confidences.begin(), m_confidences.end());
+            header.numClasses = static_cast<uint32_t>(classes.size());
+            header.numTracks = static_cast<uint32_t>(tracks.size());
+            header.chunkSize = sizeof(header) +
+                               columnSize<log::ClassIndexEntry>(classes.size()) +
+                               columnSize<int32_t>(tracks.size()) +
+                               columnSize<int64_t>(rows) +
+                               columnSize<double>(rows) +
+                               5 * columnSize<float>(rows) +
+                               2 * columnSize<int32_t>(rows);
+
+            writeBlock(m_stream, &header, 1);
+            writeBlock(m_stream, classes.data(), classes.size());
+            writeBlock(m_stream, tracks.data(), tracks.size());
+            writeBlock(m_stream, m_frames.data(), rows);
+            writeBlock(m_stream, m_timestamps.data(), rows);
+            writeBlock(m_stream, m_x.data(), rows);
+            writeBlock(m_stream, m_y.data(), rows);
+            writeBlock(m_stream, m_width.data(), rows);
+            writeBlock(m_stream, m_height.data(), rows);
+            writeBlock(m_stream, m_confidences.data(), rows);
+            writeBlock(m_stream, m_classIds.data(), rows);
+            writeBlock(m_stream, m_trackIds.data(), rows);
+        }
+
+        m_hasFrames = false;
+        m_frames.clear();
+        m_timestamps.clear();
+        m_x.clear();
+        m_y.clear();
+        m_width.clear();
+        m_height.clear();
+        m_confidences.clear();
+        m_classIds.clear();
+        m_trackIds.clear();
+    }
+
+    DetectionLog::DetectionLog(const std::string &path)
+    {
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("Could not open detection log " + path);
+        }
+
+        struct stat info{};
+        if (::fstat(m_fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(log::FileHeader))
+        {
+            ::close(m_fd);
+            throw std::runtime_error("Invalid detection log " + path);
+        }
+
+        m_size = static_cast<size_t>(info.st_size);
+        void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(m_fd);
+            throw std::runtime_error("Could not map detection log " + path);
+        }
+        m_data = static_cast<const char *>(data);
+
+        const auto *header = reinterpret_cast<const log::FileHeader *>(m_data);
+        if (std::memcmp(header->magic, log::FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != log::VERSION)
+        {
+            ::munmap(const_cast<char *>(m_data), m_size);
+            ::close(m_fd);
+            throw std::runtime_error("Unsupported detection log " + path);
+        }
+
+        // Only chunk headers are touched here, a truncated or inconsistent trailing chunk is ignored
+        size_t offset = sizeof(log::FileHeader);
+        while (offset + sizeof(log::ChunkHeader) <= m_size)
+        {
+            const auto *chunkHeader = reinterpret_cast<const log::ChunkHeader *>(m_data + offset);
+            if (std::memcmp(chunkHeader->magic, log::CHUNK_MAGIC, sizeof(chunkHeader->magic)) != 0 ||
+                chunkHeader->chunkSize < sizeof(log::ChunkHeader) || chunkHeader->chunkSize > m_size - offset)
+            {
+                break;
+            }
+
+            const size_t rows = chunkHeader->rowCount;
+            const char *cursor = m_data + offset + sizeof(log::ChunkHeader);
+            const char *end = m_data + offset + chunkHeader->chunkSize;
+
+            Chunk chunk;
+            chunk.header = chunkHeader;
+            chunk.classes = readBlock<log::ClassIndexEntry>(cursor, end, chunkHeader->numClasses);
+            chunk.tracks = readBlock<int32_t>(cursor, end, chunkHeader->numTracks);
+            chunk.frames = readBlock<int64_t>(cursor, end, rows);
+            chunk.timestamps = readBlock<double>(cursor, end, rows);
+            chunk.x = readBlock<float>(cursor, end, rows);
+            chunk.y = readBlock<float>(cursor, end, rows);
+            chunk.width = readBlock<float>(cursor, end, rows);
+            chunk.height = readBlock<float>(cursor, end, rows);
+            chunk.confidences = readBlock<float>(cursor, end, rows);
+            chunk.classIds = readBlock<int32_t>(cursor, end, rows);
+            chunk.trackIds = readBlock<int32_t>(cursor, end, rows);
+            if (!cursor)
+            {
+                break;
+            }
+            m_chunks.push_back(chunk);
+
+            offset += chunkHeader->chunkSize;
+        }
+    }
+
+    DetectionLog::~DetectionLog()
+    {
+        if (m_data)
+            ::munmap(const_cast<char *>(m_data), m_size);
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+
+    uint64_t DetectionLog::getNumRows() const
+    {
+        uint64_t rows = 0;
+        for (const auto &chunk : m_chunks)
+        {
+            rows += chunk.header->rowCount;
+        }
+        return rows;
+    }
+
+    bool DetectionLog::mayMatch(const Chunk &chunk, const DetectionQuery &query) const
+    {
+        const auto &header = *chunk.header;
+
+        // Time range index
+        if (header.lastFrame < query.firstFrame || header.firstFrame > query.lastFrame)
+            return false;
+        if (header.lastTimestamp < query.fromTimestamp || header.firstTimestamp > query.toTimestamp)
+            return false;
+        if (header.maxConfidence < query.minConfidence)
+            return false;
+
+        // Class index
+        if (query.classId)
+        {
+            const auto *end = chunk.classes + header.numClasses;
+            const auto *entry = std::find_if(chunk.classes, end, [&query](const log::ClassIndexEntry &e)
+                                             { return e.classId == *query.classId; });
+            if (entry == end || entry->maxConfidence < query.minConfidence)
+                return false;
+        }
+
+        // Track index
+        if (query.trackId && !std::binary_search(chunk.tracks, chunk.tracks + header.numTracks, *query.trackId))
+            return false;
+
+        return true;
+    }
+
+    std::vector<DetectionRow> DetectionLog::query(const DetectionQuery &query) const
+    {
+        std::vector<DetectionRow> rows;
+        for (const auto &chunk : m_chunks)
+        {
+            if (!mayMatch(chunk, query))
+                continue;
+
+            for (size_t i = 0; i < chunk.header->rowCount; ++i)
+            {
+                if (chunk.confidences[i] < query.minConfidence ||
+                    (query.classId && chunk.classIds[i] != *query.classId) ||
+                    (query.trackId && chunk.trackIds[i] != *query.trackId) ||
+                    chunk.frames[i] < query.firstFrame || chunk.frames[i] > query.lastFrame ||
+                    chunk.timestamps[i] < query.fromTimestamp || chunk.timestamps[i] > query.toTimestamp)
+                {
+                    continue;
+                }
+
+                rows.push_back({chunk.frames[i],
+                                chunk.timestamps[i],
+                                cv::Rect2f(chunk.x[i], chunk.y[i], chunk.width[i], chunk.height[i]),
+                                chunk.confidences[i],
+                                chunk.classIds[i],
+                                chunk.trackIds[i]});
+            }
+        }
+        return rows;
+    }
+
+} // namespace io
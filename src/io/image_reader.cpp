@@ -0,0 +1,224 @@
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <boost/filesystem.hpp>
+#include <io/image_reader.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace io
+{
+    namespace
+    {
+        const std::vector<std::string> IMAGE_EXTENSIONS = {".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".webp"};
+        const std::vector<std::string> LIST_EXTENSIONS = {".txt", ".lst"};
+
+        std::string getExtension(const fs::path &path)
+        {
+            std::string extension = path.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                           { return static_cast<char>(std::tolower(c)); });
+            return extension;
+        }
+
+        bool contains(const std::vector<std::string> &values, const std::string &value)
+        {
+            return std::find(values.begin(), values.end(), value) != values.end();
+        }
+
+        void parallelFor(size_t count, size_t numThreads, const std::function<void(size_t)> &function)
+        {
+            if (numThreads == 0)
+                numThreads = std::max(1u, std::thread::hardware_concurrency());
+            numThreads = std::min(numThreads, count);
+
+            std::atomic<size_t> next{0};
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < numThreads; ++t)
+            {
+                threads.emplace_back([&]()
+                                     {
+                                         for (size_t i = next++; i < count; i = next++)
+                                             function(i); });
+            }
+            for (auto &thread : threads)
+                thread.join();
+        }
+    } // namespace
+
+    bool isImageList(const std::string &input)
+    {
+        return fs::is_directory(input) || contains(LIST_EXTENSIONS, getExtension(input));
+    }
+
+    std::vector<std::string> listImages(const std::string &input)
+    {
+        std::vector<std::string> paths;
+        if (fs::is_directory(input))
+        {
+            for (const auto &entry : fs::directory_iterator(input))
+            {
+                if (fs::is_regular_file(entry.status()) && contains(IMAGE_EXTENSIONS, getExtension(entry.path())))
+                    paths.push_back(entry.path().string());
+            }
+            std::sort(paths.begin(), paths.end());
+        }
+        else if (contains(LIST_EXTENSIONS, getExtension(input)))
+        {
+            std::ifstream file(input);
+            if (!file.is_open())
+                throw std::runtime_error("Could not open image list " + input);
+
+            // Relative paths are relative to the list file
+            const auto base = fs::path(input).parent_path();
+            for (std::string line; std::getline(file, line);)
+            {
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                if (line.empty() || line[0] == '#')
+                    continue;
+                fs::path path(line);
+                paths.push_back(path.is_absolute() ? line : (base / path).string());
+            }
+        }
+        else
+        {
+            paths.push_back(input);
+        }
+        return paths;
+    }
+
+    cv::Size readImageSize(const std::vector<uint8_t> &buffer)
+    {
+        const auto readBigEndian16 = [&buffer](size_t offset)
+        { return (buffer[offset] << 8) | buffer[offset + 1]; };
+        const auto readBigEndian32 = [&buffer](size_t offset)
+        { return static_cast<int>((buffer[offset] << 24) | (buffer[offset + 1] << 16) | (buffer[offset + 2] << 8) | buffer[offset + 3]); };
+
+        // PNG: signature, then the IHDR chunk with width and height
+        static const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        if (buffer.size() >= 24 && std::equal(PNG_SIGNATURE, PNG_SIGNATURE + 8, buffer.begin()))
+        {
+            return cv::Size(readBigEndian32(16), readBigEndian32(20));
+        }
+
+        // JPEG: walk the segments up to the start of frame
+        if (buffer.size() < 4 || buffer[0] != 0xff || buffer[1] != 0xd8)
+        {
+            return cv::Size();
+        }
+        size_t offset = 2;
+        while (offset + 4 <= buffer.size())
+        {
+            if (buffer[offset] != 0xff)
+                return cv::Size();
+
+            const uint8_t marker = buffer[offset + 1];
+            if (marker == 0xff)
+            {
+                // Fill byte
+                ++offset;
+                continue;
+            }
+            if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd8))
+            {
+                // Standalone markers have no length
+                offset += 2;
+                continue;
+            }
+            if (marker == 0xd9 || marker == 0xda)
+                return cv::Size();
+
+            // SOF0 to SOF15, except DHT, JPG and DAC
+            if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc)
+            {
+                if (offset + 9 > buffer.size())
+                    return cv::Size();
+                return cv::Size(readBigEndian16(offset + 7), readBigEndian16(offset + 5));
+            }
+            offset += 2 + readBigEndian16(offset + 2);
+        }
+        return cv::Size();
+    }
+
+    int getDecodeFlags(const std::vector<uint8_t> &buffer, const cv::Size &target)
+    {
+        // Only JPEG decoders scale while decoding, other formats would be decoded then resized
+        if (target.empty() || buffer.size() < 2 || buffer[0] != 0xff || buffer[1] != 0xd8)
+            return cv::IMREAD_COLOR;
+
+        const cv::Size size = readImageSize(buffer);
+        if (size.empty())
+            return cv::IMREAD_COLOR;
+
+        // The EXIF orientation may swap width and height, compare the smallest side to the largest target side
+        const int factor = std::min(size.width, size.height) / std::max(target.width, target.height);
+        if (factor >= 8)
+            return cv::IMREAD_REDUCED_COLOR_8;
+        if (factor >= 4)
+            return cv::IMREAD_REDUCED_COLOR_4;
+        if (factor >= 2)
+            return cv::IMREAD_REDUCED_COLOR_2;
+        return cv::IMREAD_COLOR;
+    }
+
+    cv::Mat readImage(const std::string &path, const cv::Size &target)
+    {
+        if (target.empty())
+            return cv::imread(path, cv::IMREAD_COLOR);
+
+        auto buffers = readFiles({path}, 1);
+        return decodeImages(buffers, 1, target)[0];
+    }
+
+    std::vector<std::vector<uint8_t>> readFiles(const std::vector<std::string> &paths, size_t numThreads)
+    {
+        std::vector<std::vector<uint8_t>> buffers(paths.size());
+        parallelFor(paths.size(), numThreads, [&](size_t i)
+                    {
+                        std::ifstream file(paths[i], std::ios::binary | std::ios::ate);
+                        if (!file.is_open())
+                            return;
+                        buffers[i].resize(static_cast<size_t>(file.tellg()));
+                        file.seekg(0);
+                        if (!file.read(reinterpret_cast<char *>(buffers[i].data()), static_cast<std::streamsize>(buffers[i].size())))
+                            buffers[i].clear(); });
+        return buffers;
+    }
+
+    std::vector<cv::Mat> decodeImages(const std::vector<std::vector<uint8_t>> &buffers, size_t numThreads, const cv::Size &target)
+    {
+        std::vector<cv::Mat> images(buffers.size());
+        parallelFor(buffers.size(), numThreads, [&](size_t i)
+                    {
+                        if (!buffers[i].empty())
+                            images[i] = cv::imdecode(buffers[i], getDecodeFlags(buffers[i], target)); });
+        return images;
+    }
+
+    std::vector<cv::Mat> readImages(const std::vector<std::string> &paths, size_t numThreads, const cv::Size &target)
+    {
+        if (!target.empty())
+            return decodeImages(readFiles(paths, numThreads), numThreads, target);
+
+        std::vector<cv::Mat> images(paths.size());
+        parallelFor(paths.size(), numThreads, [&](size_t i)
+                    { images[i] = cv::imread(paths[i], cv::IMREAD_COLOR); });
+        return images;
+    }
+
+    uint64_t hashBytes(const void *data, size_t size, uint64_t seed)
+    {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+} // namespace io
@@ -0,0 +1,244 @@
+#include <cstring>
+#include <iostream>
+#include "io/result_writer.hpp"
+#include "io/detection_log.hpp"
+#include "metrics/trace.hpp"
+
+namespace io
+{
+    namespace
+    {
+        template <typename T>
+        void append(std::string &buffer, const T &value)
+        {
+            buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        T extract(const std::string &buffer, size_t &offset)
+        {
+            if (offset + sizeof(T) > buffer.size())
+            {
+                throw std::runtime_error("Truncated binary result record");
+            }
+            T value;
+            std::memcpy(&value, buffer.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return value;
+        }
+
+        // A count of records of recordBytes each, checked against the rest of the buffer before anything is resized
+        uint32_t extractCount(const std::string &buffer, size_t &offset, size_t recordBytes)
+        {
+            const auto count = extract<uint32_t>(buffer, offset);
+            if (count > (buffer.size() - offset) / recordBytes)
+            {
+                throw std::runtime_error("Truncated binary result record");
+            }
+            return count;
+        }
+
+        // bbox, confidence, class_id, track_id and the feature count
+        constexpr size_t DETECTION_BYTES = 5 * sizeof(float) + 2 * sizeof(int32_t) + sizeof(uint32_t);
+    } // namespace
+
+    void JsonLinesWriter::write(const FrameResult &result)
+    {
+        auto data = toJson(result);
+        if (m_embeddings)
+        {
+            for (size_t i = 0; i < result.detections.size(); ++i)
+            {
+                data["detections"][i]["features"] = result.detections[i].features;
+            }
+        }
+        m_stream << data.dump() << '\n';
+    }
+
+    BinaryResultWriter::BinaryResultWriter(std::ostream &stream, bool embeddings) : m_stream(stream), m_embeddings(embeddings)
+    {
+        m_stream.write(MAGIC, sizeof(MAGIC));
+        m_stream.write(reinterpret_cast<const char *>(&VERSION), sizeof(VERSION));
+    }
+
+    void BinaryResultWriter::write(const FrameResult &result)
+    {
+        m_buffer.clear();
+        append(m_buffer, static_cast<int64_t>(result.frameIndex));
+        append(m_buffer, static_cast<double>(result.timestamp));
+        append(m_buffer, static_cast<uint32_t>(result.detections.size()));
+
+        for (const auto &det : result.detections)
+        {
+            append(m_buffer, static_cast<float>(det.bbox.x));
+            append(m_buffer, static_cast<float>(det.bbox.y));
+            append(m_buffer, static_cast<float>(det.bbox.width));
+            append(m_buffer, static_cast<float>(det.bbox.height));
+            append(m_buffer, static_cast<float>(det.confidence));
+            append(m_buffer, static_cast<int32_t>(det.class_id));
+            append(m_buffer, static_cast<int32_t>(det.track_id));
+
+            const auto numFeatures = m_embeddings ? static_cast<uint32_t>(det.features.size()) : 0u;
+            append(m_buffer, numFeatures);
+            m_buffer.append(reinterpret_cast<const char *>(det.features.data()), numFeatures * sizeof(float));
+        }
+
+        const auto size = static_cast<uint32_t>(m_buffer.size());
+        m_stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        m_stream.write(m_buffer.data(), m_buffer.size());
+    }
+
+    BinaryResultReader::BinaryResultReader(std::istream &stream) : m_stream(stream)
+    {
+        char magic[sizeof(BinaryResultWriter::MAGIC)];
+        uint32_t version = 0;
+        m_stream.read(magic, sizeof(magic));
+        m_stream.read(reinterpret_cast<char *>(&version), sizeof(version));
+
+        if (!m_stream || std::memcmp(magic, BinaryResultWriter::MAGIC, sizeof(magic)) != 0)
+        {
+            throw std::runtime_error("Not a binary result stream");
+        }
+        if (version != BinaryResultWriter::VERSION)
+        {
+            throw std::runtime_error("Unsupported binary result version " + std::to_string(version));
+        }
+    }
+
+    bool BinaryResultReader::read(FrameResult &result)
+    {
+        uint32_t size = 0;
+        if (!m_stream.read(reinterpret_cast<char *>(&size), sizeof(size)))
+        {
+            return false;
+        }
+
+        m_buffer.resize(size);
+        if (!m_stream.read(m_buffer.data(), size))
+        {
+            throw std::runtime_error("Truncated binary result record");
+        }
+
+        size_t offset = 0;
+        result.frameIndex = extract<int64_t>(m_buffer, offset);
+        result.timestamp = extract<double>(m_buffer, offset);
+        result.detections.resize(extractCount(m_buffer, offset, DETECTION_BYTES));
+
+        for (auto &det : result.detections)
+        {
+            det.bbox.x = extract<float>(m_buffer, offset);
+            det.bbox.y = extract<float>(m_buffer, offset);
+            det.bbox.width = extract<float>(m_buffer, offset);
+            det.bbox.height = extract<float>(m_buffer, offset);
+            det.confidence = extract<float>(m_buffer, offset);
+            det.class_id = extract<int32_t>(m_buffer, offset);
+            det.track_id = extract<int32_t>(m_buffer, offset);
+
+            det.features.resize(extractCount(m_buffer, offset, sizeof(float)));
+            for (auto &feature : det.features)
+            {
+                feature = extract<float>(m_buffer, offset);
+            }
+        }
+        return true;
+    }
+
+    AsyncResultWriter::AsyncResultWriter(const std::string &path, ResultFormat format, bool embeddings, size_t capacity)
+        : m_capacity(std::max<size_t>(1, capacity))
+    {
+        std::ostream *stream = &std::cout;
+        if (path != "-")
+        {
+            m_file.open(path, std::ios::binary);
+            if (!m_file.is_open())
+            {
+                throw std::runtime_error("Could not create result file " + path);
+            }
+            stream = &m_file;
+        }
+
+        switch (format)
+        {
+        case ResultFormat::JSONL:
+            m_writer = std::make_unique<JsonLinesWriter>(*stream, embeddings);
+            break;
+        case ResultFormat::BINARY:
+            m_writer = std::make_unique<BinaryResultWriter>(*stream, embeddings);
+            break;
+        case ResultFormat::COLUMNAR:
+            m_writer = std::make_unique<DetectionLogWriter>(*stream);
+            break;
+        default:
+            throw std::runtime_error("Unknown result format");
+        }
+
+        m_thread = std::thread(&AsyncResultWriter::writeLoop, this);
+    }
+
+    AsyncResultWriter::~AsyncResultWriter()
+    {
+        close();
+    }
+
+    void AsyncResultWriter::write(FrameResult &&result)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]
+                        { return m_queue.size() < m_capacity || m_closed; });
+            if (m_closed)
+            {
+                throw std::runtime_error("Result writer is closed");
+            }
+            m_queue.push_back(std::move(result));
+        }
+        m_cond.notify_all();
+    }
+
+    void AsyncResultWriter::close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_cond.notify_all();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    void AsyncResultWriter::writeLoop()
+    {
+        metrics::Tracer::setThreadName("writer");
+        std::deque<FrameResult> pending;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this]
+                            { return !m_queue.empty() || m_closed; });
+                if (m_queue.empty() && m_closed)
+                {
+                    break;
+                }
+                pending.swap(m_queue);
+            }
+            m_cond.notify_all();
+
+            // Write everything queued so far in one go, flushing once per wake-up
+            for (const auto &result : pending)
+            {
+                metrics::TraceSpan span("write", nullptr, result.frameIndex);
+                m_writer->write(result);
+            }
+            {
+                metrics::TraceSpan span("flush");
+                m_writer->flush();
+            }
+            pending.clear();
+        }
+        m_writer->close();
+    }
+
+} // namespace io
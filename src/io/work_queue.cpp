@@ -0,0 +1,163 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include <nlohmann/json.hpp>
+#include <io/image_reader.hpp>
+#include <io/work_queue.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace io
+{
+    namespace
+    {
+        // Write through a temporary file so that concurrent workers never read a partial file
+        void writeAtomically(const std::string &path, const std::string &content)
+        {
+            const std::string tmpPath = path + "." + std::to_string(::getpid()) + ".tmp";
+            {
+                std::ofstream file(tmpPath, std::ios::binary);
+                if (!file.write(content.data(), static_cast<std::streamsize>(content.size())))
+                    throw std::runtime_error("Could not write " + tmpPath);
+            }
+            fs::rename(tmpPath, path);
+        }
+    } // namespace
+
+    FileWorkQueue::FileWorkQueue(const std::string &directory, const std::vector<std::string> &items, size_t chunkSize)
+        : m_directory(directory),
+          m_numItems(items.size()),
+          m_chunkSize(std::max<size_t>(1, chunkSize)),
+          m_numChunks((items.size() + m_chunkSize - 1) / m_chunkSize)
+    {
+        fs::create_directories(m_directory);
+
+        std::string list;
+        for (const auto &item : items)
+        {
+            list += item;
+            list += '\n';
+        }
+        std::ostringstream hash;
+        hash << std::hex << std::setw(16) << std::setfill('0') << hashBytes(list.data(), list.size());
+
+        nlohmann::json description = {
+            {"items", m_numItems},
+            {"chunk_size", m_chunkSize},
+            {"hash", hash.str()}};
+
+        // Resuming requires the same items in the same chunks
+        const std::string descriptionPath = m_directory + "/queue.json";
+        if (fs::exists(descriptionPath))
+        {
+            std::ifstream file(descriptionPath);
+            if (nlohmann::json::parse(file) != description)
+                throw std::runtime_error("Work directory " + m_directory + " was created for other items or another chunk size");
+            return;
+        }
+
+        writeAtomically(m_directory + "/items.txt", list);
+        writeAtomically(descriptionPath, description.dump(4));
+    }
+
+    FileWorkQueue::~FileWorkQueue()
+    {
+        for (const auto &[chunk, fd] : m_locks)
+            ::close(fd);
+    }
+
+    std::optional<size_t> FileWorkQueue::claim()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t n = 0; n < m_numChunks; ++n)
+        {
+            const size_t chunk = (m_next + n) % m_numChunks;
+            if (m_locks.count(chunk) || isCompleted(chunk))
+                continue;
+
+            int fd = ::open(getPath(chunk, "lock").c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+            if (fd < 0)
+                throw std::runtime_error("Could not create lock file " + getPath(chunk, "lock"));
+
+            if (::flock(fd, LOCK_EX | LOCK_NB) != 0)
+            {
+                ::close(fd);
+                continue;
+            }
+
+            // Completed by another worker between the check and the lock
+            if (isCompleted(chunk))
+            {
+                ::close(fd);
+                continue;
+            }
+
+            m_locks[chunk] = fd;
+            m_next = chunk + 1;
+            return chunk;
+        }
+        return std::nullopt;
+    }
+
+    void FileWorkQueue::complete(size_t chunk)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_locks.find(chunk);
+        if (it == m_locks.end())
+            throw std::runtime_error("Chunk " + std::to_string(chunk) + " was not claimed");
+
+        std::ofstream(getPath(chunk, "done")).close();
+        if (!isCompleted(chunk))
+            throw std::runtime_error("Could not create " + getPath(chunk, "done"));
+
+        ::close(it->second);
+        m_locks.erase(it);
+    }
+
+    void FileWorkQueue::release(size_t chunk)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_locks.find(chunk);
+        if (it != m_locks.end())
+        {
+            ::close(it->second);
+            m_locks.erase(it);
+        }
+    }
+
+    std::pair<size_t, size_t> FileWorkQueue::getRange(size_t chunk) const
+    {
+        const size_t begin = std::min(m_numItems, chunk * m_chunkSize);
+        return {begin, std::min(m_numItems, begin + m_chunkSize)};
+    }
+
+    std::string FileWorkQueue::getPath(size_t chunk, const std::string &extension) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "chunk-%06zu.", chunk);
+        return m_directory + "/" + name + extension;
+    }
+
+    size_t FileWorkQueue::getNumCompleted() const
+    {
+        size_t completed = 0;
+        for (size_t chunk = 0; chunk < m_numChunks; ++chunk)
+        {
+            if (isCompleted(chunk))
+                ++completed;
+        }
+        return completed;
+    }
+
+    bool FileWorkQueue::isCompleted(size_t chunk) const
+    {
+        return ::access(getPath(chunk, "done").c_str(), F_OK) == 0;
+    }
+
+} // namespace io
@@ -0,0 +1,98 @@
+// Built with -mavx2 -mfma -mf16c, only called when the CPU supports AVX2, FMA and F16C
+#include <immintrin.h>
+#include "table.hpp"
+
+namespace kernels::detail
+{
+    namespace
+    {
+        float reduce(__m256 v)
+        {
+            __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+            return _mm_cvtss_f32(sum);
+        }
+
+        int32_t reduce(__m256i v)
+        {
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+            return _mm_cvtsi128_si32(sum);
+        }
+
+        void dotF32(const float *query, const float *rows, size_t stride, size_t count, size_t dims, float *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const float *row = rows + r * stride;
+                __m256 acc0 = _mm256_setzero_ps();
+                __m256 acc1 = _mm256_setzero_ps();
+                size_t i = 0;
+                for (; i + 16 <= dims; i += 16)
+                {
+                    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), _mm256_loadu_ps(row + i), acc0);
+                    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i + 8), _mm256_loadu_ps(row + i + 8), acc1);
+                }
+                for (; i + 8 <= dims; i += 8)
+                    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), _mm256_loadu_ps(row + i), acc0);
+
+                float sum = reduce(_mm256_add_ps(acc0, acc1));
+                for (; i < dims; ++i)
+                    sum += query[i] * row[i];
+                out[r] = sum;
+            }
+        }
+
+        void dotF16(const uint16_t *query, const uint16_t *rows, size_t stride, size_t count, size_t dims, float *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const uint16_t *row = rows + r * stride;
+                __m256 acc = _mm256_setzero_ps();
+                size_t i = 0;
+                for (; i + 8 <= dims; i += 8)
+                {
+                    __m256 q = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(query + i)));
+                    __m256 v = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i)));
+                    acc = _mm256_fmadd_ps(q, v, acc);
+                }
+
+                float sum = reduce(acc);
+                for (; i < dims; ++i)
+                    sum += halfToFloat(query[i]) * halfToFloat(row[i]);
+                out[r] = sum;
+            }
+        }
+
+        void dotI8(const int8_t *query, const int8_t *rows, size_t stride, size_t count, size_t dims, int32_t *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const int8_t *row = rows + r * stride;
+                __m256i acc = _mm256_setzero_si256();
+                size_t i = 0;
+                for (; i + 16 <= dims; i += 16)
+                {
+                    // Widen to int16, multiply and add pairs into int32
+                    __m256i q = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(query + i)));
+                    __m256i v = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i)));
+                    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(q, v));
+                }
+
+                int32_t sum = reduce(acc);
+                for (; i < dims; ++i)
+                    sum += static_cast<int32_t>(query[i]) * static_cast<int32_t>(row[i]);
+                out[r] = sum;
+            }
+        }
+    } // namespace
+
+    const KernelTable &avx2Table()
+    {
+        static const KernelTable table = {dotF32, dotF16, dotI8};
+        return table;
+    }
+
+} // namespace kernels::detail
@@ -0,0 +1,87 @@
+// Built with -mavx512f -mavx512bw, only called when the CPU supports both
+#include <immintrin.h>
+#include "table.hpp"
+
+namespace kernels::detail
+{
+    namespace
+    {
+        void dotF32(const float *query, const float *rows, size_t stride, size_t count, size_t dims, float *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const float *row = rows + r * stride;
+                __m512 acc0 = _mm512_setzero_ps();
+                __m512 acc1 = _mm512_setzero_ps();
+                size_t i = 0;
+                for (; i + 32 <= dims; i += 32)
+                {
+                    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(query + i), _mm512_loadu_ps(row + i), acc0);
+                    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(query + i + 16), _mm512_loadu_ps(row + i + 16), acc1);
+                }
+                if (i + 16 <= dims)
+                {
+                    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(query + i), _mm512_loadu_ps(row + i), acc0);
+                    i += 16;
+                }
+                if (i < dims)
+                {
+                    // Masked tail
+                    __mmask16 mask = static_cast<__mmask16>((1u << (dims - i)) - 1);
+                    acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, query + i), _mm512_maskz_loadu_ps(mask, row + i), acc1);
+                }
+                out[r] = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+            }
+        }
+
+        void dotF16(const uint16_t *query, const uint16_t *rows, size_t stride, size_t count, size_t dims, float *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const uint16_t *row = rows + r * stride;
+                __m512 acc = _mm512_setzero_ps();
+                size_t i = 0;
+                for (; i + 16 <= dims; i += 16)
+                {
+                    __m512 q = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(query + i)));
+                    __m512 v = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i)));
+                    acc = _mm512_fmadd_ps(q, v, acc);
+                }
+
+                float sum = _mm512_reduce_add_ps(acc);
+                for (; i < dims; ++i)
+                    sum += halfToFloat(query[i]) * halfToFloat(row[i]);
+                out[r] = sum;
+            }
+        }
+
+        void dotI8(const int8_t *query, const int8_t *rows, size_t stride, size_t count, size_t dims, int32_t *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const int8_t *row = rows + r * stride;
+                __m512i acc = _mm512_setzero_si512();
+                size_t i = 0;
+                for (; i + 32 <= dims; i += 32)
+                {
+                    // Widen to int16, multiply and add pairs into int32
+                    __m512i q = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(query + i)));
+                    __m512i v = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i)));
+                    acc = _mm512_add_epi32(acc, _mm512_madd_epi16(q, v));
+                }
+
+                int32_t sum = _mm512_reduce_add_epi32(acc);
+                for (; i < dims; ++i)
+                    sum += static_cast<int32_t>(query[i]) * static_cast<int32_t>(row[i]);
+                out[r] = sum;
+            }
+        }
+    } // namespace
+
+    const KernelTable &avx512Table()
+    {
+        static const KernelTable table = {dotF32, dotF16, dotI8};
+        return table;
+    }
+
+} // namespace kernels::detail
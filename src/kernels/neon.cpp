@@ -0,0 +1,77 @@
+// NEON is part of the aarch64 baseline, no extra flags needed
+#include <arm_neon.h>
+#include "table.hpp"
+
+namespace kernels::detail
+{
+    namespace
+    {
+        void dotF32(const float *query, const float *rows, size_t stride, size_t count, size_t dims, float *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const float *row = rows + r * stride;
+                float32x4_t acc0 = vdupq_n_f32(0.f);
+                float32x4_t acc1 = vdupq_n_f32(0.f);
+                size_t i = 0;
+                for (; i + 8 <= dims; i += 8)
+                {
+                    acc0 = vfmaq_f32(acc0, vld1q_f32(query + i), vld1q_f32(row + i));
+                    acc1 = vfmaq_f32(acc1, vld1q_f32(query + i + 4), vld1q_f32(row + i + 4));
+                }
+                float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+                for (; i < dims; ++i)
+                    sum += query[i] * row[i];
+                out[r] = sum;
+            }
+        }
+
+        void dotF16(const uint16_t *query, const uint16_t *rows, size_t stride, size_t count, size_t dims, float *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const uint16_t *row = rows + r * stride;
+                float32x4_t acc = vdupq_n_f32(0.f);
+                size_t i = 0;
+                for (; i + 4 <= dims; i += 4)
+                {
+                    float32x4_t q = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(query + i)));
+                    float32x4_t v = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(row + i)));
+                    acc = vfmaq_f32(acc, q, v);
+                }
+                float sum = vaddvq_f32(acc);
+                for (; i < dims; ++i)
+                    sum += halfToFloat(query[i]) * halfToFloat(row[i]);
+                out[r] = sum;
+            }
+        }
+
+        void dotI8(const int8_t *query, const int8_t *rows, size_t stride, size_t count, size_t dims, int32_t *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const int8_t *row = rows + r * stride;
+                int32x4_t acc = vdupq_n_s32(0);
+                size_t i = 0;
+                for (; i + 16 <= dims; i += 16)
+                {
+                    int8x16_t q = vld1q_s8(query + i);
+                    int8x16_t v = vld1q_s8(row + i);
+                    acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(q), vget_low_s8(v)));
+                    acc = vpadalq_s16(acc, vmull_high_s8(q, v));
+                }
+                int32_t sum = vaddvq_s32(acc);
+                for (; i < dims; ++i)
+                    sum += static_cast<int32_t>(query[i]) * static_cast<int32_t>(row[i]);
+                out[r] = sum;
+            }
+        }
+    } // namespace
+
+    const KernelTable &neonTable()
+    {
+        static const KernelTable table = {dotF32, dotF16, dotI8};
+        return table;
+    }
+
+} // namespace kernels::detail
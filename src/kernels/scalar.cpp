@@ -0,0 +1,50 @@
+#include "table.hpp"
+
+namespace kernels::detail
+{
+    namespace
+    {
+        void dotF32(const float *query, const float *rows, size_t stride, size_t count, size_t dims, float *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const float *row = rows + r * stride;
+                float sum = 0.f;
+                for (size_t i = 0; i < dims; ++i)
+                    sum += query[i] * row[i];
+                out[r] = sum;
+            }
+        }
+
+        void dotF16(const uint16_t *query, const uint16_t *rows, size_t stride, size_t count, size_t dims, float *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const uint16_t *row = rows + r * stride;
+                float sum = 0.f;
+                for (size_t i = 0; i < dims; ++i)
+                    sum += halfToFloat(query[i]) * halfToFloat(row[i]);
+                out[r] = sum;
+            }
+        }
+
+        void dotI8(const int8_t *query, const int8_t *rows, size_t stride, size_t count, size_t dims, int32_t *out)
+        {
+            for (size_t r = 0; r < count; ++r)
+            {
+                const int8_t *row = rows + r * stride;
+                int32_t sum = 0;
+                for (size_t i = 0; i < dims; ++i)
+                    sum += static_cast<int32_t>(query[i]) * static_cast<int32_t>(row[i]);
+                out[r] = sum;
+            }
+        }
+    } // namespace
+
+    const KernelTable &scalarTable()
+    {
+        static const KernelTable table = {dotF32, dotF16, dotI8};
+        return table;
+    }
+
+} // namespace kernels::detail
@@ -0,0 +1,327 @@
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <kernels/similarity.hpp>
+#include "table.hpp"
+
+namespace kernels
+{
+    namespace
+    {
+        // Gallery rows scored per block, small enough to stay in cache while every query visits them
+        constexpr int BLOCK_ROWS = 256;
+
+        const detail::KernelTable *getTable(Isa isa)
+        {
+            switch (isa)
+            {
+            case Isa::SCALAR:
+                return &detail::scalarTable();
+#if defined(__x86_64__)
+            case Isa::AVX2:
+                // The fp16 kernels need F16C, hypervisors may mask it independently of AVX2
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c") ? &detail::avx2Table() : nullptr;
+            case Isa::AVX512:
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") ? &detail::avx512Table() : nullptr;
+#endif
+#if defined(__aarch64__)
+            case Isa::NEON:
+                return &detail::neonTable();
+#endif
+            default:
+                return nullptr;
+            }
+        }
+
+        Isa getBestIsa()
+        {
+            for (auto isa : {Isa::AVX512, Isa::AVX2, Isa::NEON})
+            {
+                if (getTable(isa))
+                    return isa;
+            }
+            return Isa::SCALAR;
+        }
+
+        std::atomic<Isa> activeIsa{getBestIsa()};
+        std::atomic<const detail::KernelTable *> activeTable{getTable(activeIsa)};
+
+        void checkEmbeddings(const Embeddings &embeddings)
+        {
+            const int depth = embeddings.data.depth();
+            if (embeddings.data.channels() != 1 || (depth != CV_32F && depth != CV_16F && depth != CV_8S))
+                throw std::runtime_error("Embeddings must be single channel fp32, fp16 or int8");
+            if (depth == CV_8S && (embeddings.scales.type() != CV_32F || embeddings.scales.total() != static_cast<size_t>(embeddings.rows())))
+                throw std::runtime_error("Int8 embeddings need one fp32 scale per row");
+        }
+
+        void checkEmbeddings(const Embeddings &a, const Embeddings &b)
+        {
+            checkEmbeddings(a);
+            checkEmbeddings(b);
+            if (a.data.depth() != b.data.depth() || a.dims() != b.dims())
+                throw std::runtime_error("Embeddings must have the same type and dimension");
+        }
+
+        // Dot products of row q of a against rows [begin, begin + count) of b
+        void dots(const detail::KernelTable &table, const Embeddings &a, int q, const Embeddings &b, int begin, int count,
+                  float *out, std::vector<int32_t> &buffer)
+        {
+            const size_t dims = static_cast<size_t>(a.dims());
+            switch (a.data.depth())
+            {
+            case CV_32F:
+                table.dotF32(a.data.ptr<float>(q), b.data.ptr<float>(begin), b.data.step1(), count, dims, out);
+                break;
+            case CV_16F:
+                table.dotF16(a.data.ptr<uint16_t>(q), b.data.ptr<uint16_t>(begin), b.data.step1(), count, dims, out);
+                break;
+            default:
+            {
+                buffer.resize(count);
+                table.dotI8(a.data.ptr<int8_t>(q), b.data.ptr<int8_t>(begin), b.data.step1(), count, dims, buffer.data());
+                // Scales may be strided, e.g. interleaved with the embeddings
+                const float scale = a.scales.at<float>(q);
+                for (int i = 0; i < count; ++i)
+                    out[i] = static_cast<float>(buffer[i]) * scale * b.scales.at<float>(begin + i);
+                break;
+            }
+            }
+        }
+
+        std::vector<float> squaredNorms(const detail::KernelTable &table, const Embeddings &embeddings)
+        {
+            std::vector<float> norms(embeddings.rows());
+            std::vector<int32_t> buffer;
+            for (int i = 0; i < embeddings.rows(); ++i)
+                dots(table, embeddings, i, embeddings, i, 1, &norms[i], buffer);
+            return norms;
+        }
+
+        // Visit the cosine similarities of every query against blocks of gallery rows
+        template <typename Visitor>
+        void forEachBlock(const Embeddings &queries, const Embeddings &gallery, Visitor &&visit)
+        {
+            checkEmbeddings(queries, gallery);
+            const auto &table = *activeTable.load();
+            const auto queryNorms = squaredNorms(table, queries);
+            const auto galleryNorms = squaredNorms(table, gallery);
+
+            std::vector<float> scores(BLOCK_ROWS);
+            std::vector<int32_t> buffer;
+            for (int begin = 0; begin < gallery.rows(); begin += BLOCK_ROWS)
+            {
+                const int count = std::min(BLOCK_ROWS, gallery.rows() - begin);
+                for (int q = 0; q < queries.rows(); ++q)
+                {
+                    dots(table, queries, q, gallery, begin, count, scores.data(), buffer);
+                    for (int i = 0; i < count; ++i)
+                    {
+                        const float norm = std::sqrt(queryNorms[q] * galleryNorms[begin + i]);
+                        scores[i] = norm > 0.f ? scores[i] / norm : 0.f;
+                    }
+                    visit(q, begin, scores.data(), count);
+                }
+            }
+        }
+    } // namespace
+
+    bool isSupported(Isa isa)
+    {
+        return getTable(isa) != nullptr;
+    }
+
+    Isa getActiveIsa()
+    {
+        return activeIsa;
+    }
+
+    bool setActiveIsa(Isa isa)
+    {
+        const auto *table = getTable(isa);
+        if (!table)
+            return false;
+
+        activeTable = table;
+        activeIsa = isa;
+        return true;
+    }
+
+    Embeddings Embeddings::quantize(const cv::Mat &embeddings, int depth)
+    {
+        if (embeddings.type() != CV_32F)
+            throw std::runtime_error("Only fp32 embeddings can be quantized");
+
+        Embeddings result;
+        switch (depth)
+        {
+        case CV_32F:
+            result.data = embeddings.clone();
+            break;
+        case CV_16F:
+            embeddings.convertTo(result.data, CV_16F);
+            break;
+        case CV_8S:
+            result.data.create(embeddings.rows, embeddings.cols, CV_8S);
+            result.scales.create(embeddings.rows, 1, CV_32F);
+            for (int i = 0; i < embeddings.rows; ++i)
+            {
+                const float *row = embeddings.ptr<float>(i);
+                float maxValue = 0.f;
+                for (int j = 0; j < embeddings.cols; ++j)
+                    maxValue = std::max(maxValue, std::abs(row[j]));
+
+                const float scale = maxValue > 0.f ? maxValue / 127.f : 1.f;
+                int8_t *quantized = result.data.ptr<int8_t>(i);
+                for (int j = 0; j < embeddings.cols; ++j)
+                    quantized[j] = cv::saturate_cast<int8_t>(std::round(row[j] / scale));
+                result.scales.at<float>(i) = scale;
+            }
+            break;
+        default:
+            throw std::runtime_error("Embeddings can only be quantized to fp32, fp16 or int8");
+        }
+        return result;
+    }
+
+    void normalize(cv::Mat &embeddings)
+    {
+        if (embeddings.type() != CV_32F)
+            throw std::runtime_error("Only fp32 embeddings can be normalized");
+
+        const auto &table = *activeTable.load();
+        const size_t dims = static_cast<size_t>(embeddings.cols);
+        for (int i = 0; i < embeddings.rows; ++i)
+        {
+            float *row = embeddings.ptr<float>(i);
+            float norm = 0.f;
+            table.dotF32(row, row, 0, 1, dims, &norm);
+            if (norm <= 0.f)
+                continue;
+
+            const float scale = 1.f / std::sqrt(norm);
+            for (size_t j = 0; j < dims; ++j)
+                row[j] *= scale;
+        }
+    }
+
+    void normalize(std::vector<float> &embedding)
+    {
+        cv::Mat row(1, static_cast<int>(embedding.size()), CV_32F, embedding.data());
+        normalize(row);
+    }
+
+    float cosine(const std::vector<float> &a, const std::vector<float> &b)
+    {
+        if (a.size() != b.size())
+            throw std::runtime_error("Embeddings must have the same dimension");
+
+        const auto &table = *activeTable.load();
+        float ab = 0.f, aa = 0.f, bb = 0.f;
+        table.dotF32(a.data(), b.data(), 0, 1, a.size(), &ab);
+        table.dotF32(a.data(), a.data(), 0, 1, a.size(), &aa);
+        table.dotF32(b.data(), b.data(), 0, 1, b.size(), &bb);
+
+        const float norm = std::sqrt(aa * bb);
+        return norm > 0.f ? ab / norm : 0.f;
+    }
+
+    cv::Mat cosine(const Embeddings &a, const Embeddings &b)
+    {
+        cv::Mat similarities(a.rows(), b.rows(), CV_32F);
+        forEachBlock(a, b, [&](int q, int begin, const float *scores, int count)
+                     { std::copy(scores, scores + count, similarities.ptr<float>(q) + begin); });
+        return similarities;
+    }
+
+    cv::Mat l2(const Embeddings &a, const Embeddings &b)
+    {
+        checkEmbeddings(a, b);
+        const auto &table = *activeTable.load();
+        const auto normsA = squaredNorms(table, a);
+        const auto normsB = squaredNorms(table, b);
+
+        cv::Mat distances(a.rows(), b.rows(), CV_32F);
+        std::vector<int32_t> buffer;
+        for (int begin = 0; begin < b.rows(); begin += BLOCK_ROWS)
+        {
+            const int count = std::min(BLOCK_ROWS, b.rows() - begin);
+            for (int q = 0; q < a.rows(); ++q)
+            {
+                float *row = distances.ptr<float>(q) + begin;
+                dots(table, a, q, b, begin, count, row, buffer);
+                for (int i = 0; i < count; ++i)
+                    row[i] = std::sqrt(std::max(0.f, normsA[q] + normsB[begin + i] - 2.f * row[i]));
+            }
+        }
+        return distances;
+    }
+
+    void dot(const Embeddings &queries, int q, const Embeddings &gallery, const int32_t *indices, size_t count, float *out)
+    {
+        const auto &table = *activeTable.load();
+        std::vector<int32_t> buffer;
+        // Rows are scattered, fetch them a few rows ahead
+        constexpr size_t PREFETCH_DISTANCE = 4;
+        for (size_t i = 0; i < std::min(count, PREFETCH_DISTANCE); ++i)
+            __builtin_prefetch(gallery.data.ptr(indices[i]));
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i + PREFETCH_DISTANCE < count)
+                __builtin_prefetch(gallery.data.ptr(indices[i + PREFETCH_DISTANCE]));
+            dots(table, queries, q, gallery, indices[i], 1, out + i, buffer);
+        }
+    }
+
+    std::vector<Match> argmax(const Embeddings &queries, const Embeddings &gallery)
+    {
+        std::vector<Match> matches(queries.rows(), Match{-1, -std::numeric_limits<float>::infinity()});
+        forEachBlock(queries, gallery, [&](int q, int begin, const float *scores, int count)
+                     {
+                         auto &match = matches[q];
+                         for (int i = 0; i < count; ++i)
+                         {
+                             if (scores[i] > match.score)
+                                 match = {begin + i, scores[i]};
+                         } });
+        return matches;
+    }
+
+    std::vector<std::vector<Match>> topK(const Embeddings &queries, const Embeddings &gallery, size_t k)
+    {
+        // One min-heap of the k best matches per query
+        const auto greater = [](const Match &a, const Match &b)
+        { return a.score > b.score; };
+
+        std::vector<std::vector<Match>> matches(queries.rows());
+        for (auto &heap : matches)
+            heap.reserve(k);
+
+        if (k > 0)
+        {
+            forEachBlock(queries, gallery, [&](int q, int begin, const float *scores, int count)
+                         {
+                             auto &heap = matches[q];
+                             for (int i = 0; i < count; ++i)
+                             {
+                                 if (heap.size() < k)
+                                 {
+                                     heap.push_back({begin + i, scores[i]});
+                                     std::push_heap(heap.begin(), heap.end(), greater);
+                                 }
+                                 else if (scores[i] > heap.front().score)
+                                 {
+                                     std::pop_heap(heap.begin(), heap.end(), greater);
+                                     heap.back() = {begin + i, scores[i]};
+                                     std::push_heap(heap.begin(), heap.end(), greater);
+                                 }
+                             } });
+        }
+
+        for (auto &heap : matches)
+            std::sort_heap(heap.begin(), heap.end(), greater);
+        return matches;
+    }
+
+} // namespace kernels
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace kernels::detail
+{
+
+    // Dot products of one query against count rows spaced by stride elements
+    struct KernelTable
+    {
+        void (*dotF32)(const float *query, const float *rows, size_t stride, size_t count, size_t dims, float *out);
+        void (*dotF16)(const uint16_t *query, const uint16_t *rows, size_t stride, size_t count, size_t dims, float *out);
+        void (*dotI8)(const int8_t *query, const int8_t *rows, size_t stride, size_t count, size_t dims, int32_t *out);
+    };
+
+    const KernelTable &scalarTable();
+#if defined(__x86_64__)
+    const KernelTable &avx2Table();
+    const KernelTable &avx512Table();
+#endif
+#if defined(__aarch64__)
+    const KernelTable &neonTable();
+#endif
+
+    // Internal linkage: each kernel is built with its own instruction set flags, a shared inline copy could be
+    // taken from an AVX translation unit by the linker and then run on the scalar path
+    static inline float halfToFloat(uint16_t h)
+    {
+        uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+        uint32_t exponent = (h >> 10) & 0x1fu;
+        uint32_t mantissa = h & 0x3ffu;
+        uint32_t bits;
+
+        if (exponent == 0 && mantissa == 0)
+        {
+            bits = sign;
+        }
+        else if (exponent == 0)
+        {
+            // Subnormal, renormalize the mantissa
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400u))
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+        else if (exponent == 31)
+        {
+            bits = sign | 0x7f800000u | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+} // namespace kernels::detail
@@ -0,0 +1,124 @@
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <opencv2/opencv.hpp>
+#include <metrics/allocations.hpp>
+
+namespace metrics
+{
+    namespace
+    {
+        // Plain thread locals, usable from operator new without any initialization
+        thread_local uint64_t t_allocations = 0;
+        thread_local uint64_t t_allocatedBytes = 0;
+    } // namespace
+
+    AllocationStats getThreadAllocations()
+    {
+        return {t_allocations, t_allocatedBytes};
+    }
+
+    AllocationMetrics getAllocationMetrics(const Labels &labels)
+    {
+        if constexpr (!ALLOCATION_TRACKING)
+            return {};
+
+        auto &registry = Registry::instance();
+        return {&registry.histogram("trt_allocations", labels), &registry.counter("trt_allocated_bytes_total", labels)};
+    }
+
+#ifdef TRT_ALLOC_TRACKING
+    namespace
+    {
+        void *allocate(std::size_t size, std::size_t alignment = 0)
+        {
+            ++t_allocations;
+            t_allocatedBytes += size;
+
+            if (size == 0)
+                size = 1;
+            void *pointer = nullptr;
+            if (alignment > alignof(std::max_align_t))
+            {
+                if (posix_memalign(&pointer, alignment, size) != 0)
+                    pointer = nullptr;
+            }
+            else
+            {
+                pointer = std::malloc(size);
+            }
+            return pointer;
+        }
+
+        void *allocateOrThrow(std::size_t size, std::size_t alignment = 0)
+        {
+            void *pointer = allocate(size, alignment);
+            if (!pointer)
+                throw std::bad_alloc();
+            return pointer;
+        }
+
+        // OpenCV allocates pixel buffers with malloc, only their UMatData goes through operator new.
+        // Buffers are allocated and released by the standard allocator, they are counted on the way.
+        class CountingMatAllocator : public cv::MatAllocator
+        {
+        public:
+            cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                                   cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+            {
+                cv::UMatData *u = cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+                if (u && !data)
+                {
+                    ++t_allocations;
+                    t_allocatedBytes += u->size;
+                }
+                return u;
+            }
+
+            bool allocate(cv::UMatData *u, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override
+            {
+                return cv::Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+            }
+
+            void deallocate(cv::UMatData *u) const override
+            {
+                cv::Mat::getStdAllocator()->deallocate(u);
+            }
+        };
+
+        [[maybe_unused]] const bool matAllocatorInstalled = []()
+        {
+            static CountingMatAllocator allocator;
+            cv::Mat::setDefaultAllocator(&allocator);
+            return true;
+        }();
+    } // namespace
+#endif
+
+} // namespace metrics
+
+#ifdef TRT_ALLOC_TRACKING
+// Replacements of the global allocation functions, every form is replaced so that allocations and
+// deallocations always pair malloc with free
+void *operator new(std::size_t size) { return metrics::allocateOrThrow(size); }
+void *operator new[](std::size_t size) { return metrics::allocateOrThrow(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return metrics::allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return metrics::allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return metrics::allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return metrics::allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return metrics::allocate(size, static_cast<std::size_t>(alignment)); }
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return metrics::allocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t &) noexcept { std::free(pointer); }
+#endif
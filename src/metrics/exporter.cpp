@@ -0,0 +1,161 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <metrics/exporter.hpp>
+
+namespace metrics
+{
+    Exporter::Exporter(const ExporterConfig &config) : m_config(config)
+    {
+        if (!m_config.socketPath.empty())
+        {
+            int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, m_config.socketPath.c_str(), sizeof(address.sun_path) - 1);
+            ::unlink(m_config.socketPath.c_str());
+            if (listener < 0 ||
+                ::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+                ::listen(listener, SOMAXCONN) != 0)
+            {
+                if (listener >= 0)
+                    ::close(listener);
+                throw std::runtime_error("Could not listen on " + m_config.socketPath);
+            }
+            m_serveThread = std::thread(&Exporter::serveLoop, this, listener);
+        }
+
+        if (!m_config.prometheusPath.empty() || !m_config.jsonPath.empty())
+            m_writeThread = std::thread(&Exporter::writeLoop, this);
+    }
+
+    Exporter::~Exporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_cond.notify_all();
+
+        if (m_writeThread.joinable())
+            m_writeThread.join();
+        if (m_serveThread.joinable())
+            m_serveThread.join();
+
+        // Last snapshot, so that short runs are exported too
+        if (!m_config.prometheusPath.empty() || !m_config.jsonPath.empty())
+            write();
+    }
+
+    void Exporter::writeLoop()
+    {
+        const auto interval = std::chrono::duration<double>(std::max(0.1, m_config.interval));
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_cond.wait_for(lock, interval, [this]
+                                { return !m_running; }))
+        {
+            lock.unlock();
+            write();
+            lock.lock();
+        }
+    }
+
+    void Exporter::write()
+    {
+        auto &registry = Registry::instance();
+
+        // Written next to the target and renamed, the collector never reads a partial file
+        if (!m_config.prometheusPath.empty())
+        {
+            const std::string tmpPath = m_config.prometheusPath + ".tmp";
+            {
+                std::ofstream file(tmpPath, std::ios::trunc);
+                file << registry.toPrometheus();
+            }
+            std::rename(tmpPath.c_str(), m_config.prometheusPath.c_str());
+        }
+
+        if (m_config.jsonPath.empty())
+            return;
+
+        // Per second rates of the counters since the previous line
+        auto snapshot = registry.toJson();
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - m_previousTime).count();
+        if (!m_previous.empty() && elapsed > 0.0)
+        {
+            for (auto &metric : snapshot)
+            {
+                if (!metric.contains("value") || !metric["value"].is_number_unsigned())
+                    continue;
+                for (const auto &previous : m_previous)
+                {
+                    if (previous["name"] == metric["name"] && previous["labels"] == metric["labels"])
+                    {
+                        metric["rate"] = (metric["value"].get<double>() - previous["value"].get<double>()) / elapsed;
+                        break;
+                    }
+                }
+            }
+        }
+        m_previous = snapshot;
+        m_previousTime = now;
+
+        const nlohmann::json line = {
+            {"timestamp", std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count()},
+            {"metrics", snapshot}};
+        if (m_config.jsonPath == "-")
+        {
+            std::cerr << line.dump() << std::endl;
+        }
+        else
+        {
+            std::ofstream file(m_config.jsonPath, std::ios::app);
+            file << line.dump() << '\n';
+        }
+    }
+
+    void Exporter::serveLoop(int listener)
+    {
+        while (m_running)
+        {
+            pollfd fd{listener, POLLIN, 0};
+            if (::poll(&fd, 1, 100) <= 0)
+                continue;
+
+            int client = ::accept(listener, nullptr, nullptr);
+            if (client < 0)
+                continue;
+
+            // The request is not parsed, any connection gets the metrics
+            char request[1024];
+            pollfd clientFd{client, POLLIN, 0};
+            if (::poll(&clientFd, 1, 100) > 0)
+                [[maybe_unused]] auto received = ::recv(client, request, sizeof(request), MSG_DONTWAIT);
+
+            const std::string body = Registry::instance().toPrometheus();
+            const std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                                         std::to_string(body.size()) + "\r\n\r\n" + body;
+            size_t sent = 0;
+            while (sent < response.size())
+            {
+                const auto count = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (count <= 0)
+                    break;
+                sent += static_cast<size_t>(count);
+            }
+            ::close(client);
+        }
+
+        ::close(listener);
+        ::unlink(m_config.socketPath.c_str());
+    }
+
+} // namespace metrics
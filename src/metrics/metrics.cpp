@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <metrics/metrics.hpp>
+
+namespace metrics
+{
+    size_t Histogram::getBucket(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+            return static_cast<size_t>(value);
+
+        const size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(value));
+        const size_t sub = static_cast<size_t>(value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return SUB_BUCKETS + (exponent - SUB_BITS) * SUB_BUCKETS + sub;
+    }
+
+    uint64_t Histogram::getBucketUpperBound(size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+            return bucket;
+
+        const size_t shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+        const uint64_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub) << shift) + ((uint64_t(1) << shift) - 1);
+    }
+
+    void Histogram::record(uint64_t value)
+    {
+        m_buckets[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    double Histogram::getQuantile(double quantile) const
+    {
+        // Buckets are read one by one while being recorded, the count is taken from the buckets themselves
+        std::array<uint64_t, NUM_BUCKETS> counts;
+        uint64_t total = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; ++i)
+        {
+            counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        if (total == 0)
+            return 0.0;
+
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * total)));
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; ++i)
+        {
+            cumulative += counts[i];
+            if (cumulative >= rank)
+                return std::min(getBucketUpperBound(i), m_max.load(std::memory_order_relaxed)) * m_scale;
+        }
+        return getMax();
+    }
+
+    Registry &Registry::instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    Counter &Registry::counter(const std::string &name, const Labels &labels)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &metric = m_counters[{name, labels}];
+        if (!metric)
+            metric = std::make_unique<Counter>();
+        return *metric;
+    }
+
+    Gauge &Registry::gauge(const std::string &name, const Labels &labels)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &metric = m_gauges[{name, labels}];
+        if (!metric)
+            metric = std::make_unique<Gauge>();
+        return *metric;
+    }
+
+    Histogram &Registry::latency(const std::string &name, const Labels &labels)
+    {
+        return histogram(name, labels, 1e-9);
+    }
+
+    Histogram &Registry::histogram(const std::string &name, const Labels &labels, double scale)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &metric = m_histograms[{name, labels}];
+        if (!metric)
+            metric = std::make_unique<Histogram>(scale);
+        return *metric;
+    }
+
+    namespace
+    {
+        std::string formatLabels(const Labels &labels, const std::string &le = "")
+        {
+            if (labels.empty() && le.empty())
+                return "";
+
+            std::string text = "{";
+            for (const auto &[name, value] : labels)
+            {
+                if (text.size() > 1)
+                    text += ',';
+                text += name + "=\"";
+                for (char c : value)
+                {
+                    if (c == '\\' || c == '"')
+                        text += '\\';
+                    text += c == '\n' ? 'n' : c;
+                }
+                text += '"';
+            }
+            if (!le.empty())
+                text += std::string(text.size() > 1 ? "," : "") + "le=\"" + le + "\"";
+            return text + "}";
+        }
+
+        nlohmann::json labelsToJson(const Labels &labels)
+        {
+            nlohmann::json json = nlohmann::json::object();
+            for (const auto &[name, value] : labels)
+                json[name] = value;
+            return json;
+        }
+
+        // One TYPE line per metric family, the maps are sorted by name
+        void writeType(std::ostringstream &out, std::string &family, const std::string &name, const char *type)
+        {
+            if (family == name)
+                return;
+            family = name;
+            out << "# TYPE " << name << ' ' << type << '\n';
+        }
+    } // namespace
+
+    std::string Registry::toPrometheus() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ostringstream out;
+        out.precision(9);
+
+        std::string family;
+        for (const auto &[key, metric] : m_counters)
+        {
+            writeType(out, family, key.first, "counter");
+            out << key.first << formatLabels(key.second) << ' ' << metric->get() << '\n';
+        }
+        for (const auto &[key, metric] : m_gauges)
+        {
+            writeType(out, family, key.first, "gauge");
+            out << key.first << formatLabels(key.second) << ' ' << metric->get() << '\n';
+        }
+
+        // Cumulative buckets at powers of two, up to the largest value recorded
+        for (const auto &[key, metric] : m_histograms)
+        {
+            writeType(out, family, key.first, "histogram");
+            const size_t last = Histogram::getBucket(static_cast<uint64_t>(metric->getMax() / metric->getScale() + 0.5));
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i <= last; ++i)
+            {
+                cumulative += metric->getBucketCount(i);
+                if ((i + 1) % Histogram::SUB_BUCKETS != 0 && i != last)
+                    continue;
+
+                std::ostringstream le;
+                le.precision(9);
+                le << Histogram::getBucketUpperBound(i) * metric->getScale();
+                out << key.first << "_bucket" << formatLabels(key.second, le.str()) << ' ' << cumulative << '\n';
+            }
+            // Values may be recorded while exporting, the buckets must stay cumulative
+            const uint64_t count = std::max(cumulative, metric->getCount());
+            out << key.first << "_bucket" << formatLabels(key.second, "+Inf") << ' ' << count << '\n';
+            out << key.first << "_sum" << formatLabels(key.second) << ' ' << metric->getSum() << '\n';
+            out << key.first << "_count" << formatLabels(key.second) << ' ' << count << '\n';
+        }
+        return out.str();
+    }
+
+    nlohmann::json Registry::toJson() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        nlohmann::json json = nlohmann::json::array();
+        for (const auto &[key, metric] : m_counters)
+            json.push_back({{"name", key.first}, {"labels", labelsToJson(key.second)}, {"value", metric->get()}});
+        for (const auto &[key, metric] : m_gauges)
+            json.push_back({{"name", key.first}, {"labels", labelsToJson(key.second)}, {"value", metric->get()}});
+        for (const auto &[key, metric] : m_histograms)
+        {
+            json.push_back({
+                {"name", key.first},
+                {"labels", labelsToJson(key.second)},
+                {"count", metric->getCount()},
+                {"sum", metric->getSum()},
+                {"max", metric->getMax()},
+                {"p50", metric->getQuantile(0.5)},
+                {"p95", metric->getQuantile(0.95)},
+                {"p99", metric->getQuantile(0.99)},
+            });
+        }
+        return json;
+    }
+
+} // namespace metrics
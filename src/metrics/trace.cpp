@@ -0,0 +1,214 @@
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include <metrics/trace.hpp>
+
+namespace metrics
+{
+    namespace
+    {
+        thread_local int64_t t_frame = -1;
+        thread_local std::string t_threadName{};
+
+        int64_t toNs(std::chrono::steady_clock::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+    } // namespace
+
+    Tracer &Tracer::instance()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void Tracer::start()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Threads still holding a buffer of the previous trace keep it alive until they pick a new one
+        m_buffers.clear();
+        m_epoch = toNs(std::chrono::steady_clock::now());
+        m_generation.fetch_add(1, std::memory_order_release);
+        m_enabled = true;
+    }
+
+    void Tracer::stop()
+    {
+        m_enabled = false;
+    }
+
+    void Tracer::setFrame(int64_t frame)
+    {
+        t_frame = frame;
+    }
+
+    int64_t Tracer::getFrame()
+    {
+        return t_frame;
+    }
+
+    void Tracer::setThreadName(const std::string &name)
+    {
+        t_threadName = name;
+    }
+
+    const char *Tracer::intern(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_names.insert(name).first->c_str();
+    }
+
+    Tracer::Buffer &Tracer::getBuffer()
+    {
+        thread_local std::shared_ptr<Buffer> t_buffer = nullptr;
+
+        const uint64_t generation = m_generation.load(std::memory_order_acquire);
+        if (!t_buffer || t_buffer->generation != generation)
+        {
+            auto buffer = std::make_shared<Buffer>();
+            buffer->generation = generation;
+            buffer->threadName = t_threadName;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            buffer->threadId = ++m_nextThreadId;
+            m_buffers.push_back(buffer);
+            t_buffer = std::move(buffer);
+        }
+        return *t_buffer;
+    }
+
+    void Tracer::record(const char *name, const char *detail, int64_t frame, std::chrono::steady_clock::time_point begin)
+    {
+        const int64_t epoch = m_epoch.load(std::memory_order_relaxed);
+        const int64_t beginNs = toNs(begin);
+        // Started before the current trace
+        if (beginNs < epoch)
+            return;
+        const int64_t endNs = toNs(std::chrono::steady_clock::now());
+
+        auto &buffer = getBuffer();
+        const size_t size = buffer.size.load(std::memory_order_relaxed);
+        if (size >= BUFFER_CAPACITY)
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.events[size] = {name, detail, frame, static_cast<uint64_t>(beginNs - epoch), static_cast<uint64_t>(endNs - epoch)};
+        // Published after the event is written, the dump never reads a partial event
+        buffer.size.store(size + 1, std::memory_order_release);
+    }
+
+    uint64_t Tracer::getDroppedEvents() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t dropped = 0;
+        for (const auto &buffer : m_buffers)
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        return dropped;
+    }
+
+    bool Tracer::dump(const std::string &path) const
+    {
+        std::vector<std::shared_ptr<Buffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            buffers = m_buffers;
+        }
+
+        const auto pid = static_cast<int>(::getpid());
+        nlohmann::json events = nlohmann::json::array();
+        for (const auto &buffer : buffers)
+        {
+            if (!buffer->threadName.empty())
+            {
+                events.push_back({{"ph", "M"}, {"name", "thread_name"}, {"pid", pid}, {"tid", buffer->threadId}, {"args", {{"name", buffer->threadName}}}});
+            }
+
+            const size_t size = buffer->size.load(std::memory_order_acquire);
+            for (size_t i = 0; i < size; ++i)
+            {
+                const auto &event = buffer->events[i];
+                nlohmann::json args = nlohmann::json::object();
+                if (event.frame >= 0)
+                    args["frame"] = event.frame;
+                if (event.detail)
+                    args["detail"] = event.detail;
+
+                // Chrome trace timestamps are in microseconds
+                events.push_back({
+                    {"ph", "X"},
+                    {"name", event.name},
+                    {"cat", "trt"},
+                    {"pid", pid},
+                    {"tid", buffer->threadId},
+                    {"ts", event.begin / 1e3},
+                    {"dur", (event.end - event.begin) / 1e3},
+                    {"args", std::move(args)},
+                });
+            }
+        }
+
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open())
+            return false;
+        file << nlohmann::json{{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}}.dump();
+        return file.good();
+    }
+
+    namespace
+    {
+        std::atomic<bool> s_traceRequested{false};
+
+        void traceSignalHandler([[maybe_unused]] int signum)
+        {
+            s_traceRequested = true;
+        }
+    } // namespace
+
+    TraceTrigger::TraceTrigger(int signum, const std::string &path, double seconds)
+        : m_signum(signum), m_path(path), m_seconds(seconds)
+    {
+        s_traceRequested = false;
+        std::signal(m_signum, traceSignalHandler);
+        m_thread = std::thread(&TraceTrigger::watchLoop, this);
+    }
+
+    TraceTrigger::~TraceTrigger()
+    {
+        std::signal(m_signum, SIG_DFL);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_cond.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    void TraceTrigger::watchLoop()
+    {
+        auto &tracer = Tracer::instance();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_running)
+        {
+            // Signal handlers cannot lock, the request is polled
+            m_cond.wait_for(lock, std::chrono::milliseconds(100), [this]
+                            { return !m_running; });
+            if (!s_traceRequested.exchange(false))
+                continue;
+
+            tracer.start();
+            m_cond.wait_for(lock, std::chrono::duration<double>(m_seconds), [this]
+                            { return !m_running; });
+            tracer.stop();
+
+            if (tracer.dump(m_path))
+                std::cerr << "Trace written to " << m_path << std::endl;
+            else
+                std::cerr << "Error: Could not write trace " << m_path << std::endl;
+        }
+    }
+
+} // namespace metrics
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <utils/tensorrt_utils.hpp>
+#include <models/classification/cascade.hpp>
+
+namespace cls
+{
+    void classifyDetections(trt::ClassificationProcessor &classifier, const CascadeConfig &config,
+                            const std::vector<cv::Mat> &frames, std::vector<std::vector<Detection>> &detections)
+    {
+        // Crops are views on the frames, they are only copied once preprocessed into the classifier batch
+        std::vector<cv::Mat> crops;
+        std::vector<Detection *> targets;
+        for (size_t i = 0; i < frames.size() && i < detections.size(); ++i)
+        {
+            for (auto &det : detections[i])
+            {
+                if (!config.classNames.empty() &&
+                    std::find(config.classNames.begin(), config.classNames.end(), det.class_name) == config.classNames.end())
+                {
+                    continue;
+                }
+
+                cv::Rect2d roi(det.bbox.x - det.bbox.width * config.padding,
+                               det.bbox.y - det.bbox.height * config.padding,
+                               det.bbox.width * (1.0 + 2.0 * config.padding),
+                               det.bbox.height * (1.0 + 2.0 * config.padding));
+                cv::Rect rect = trt::toPixelRect(roi, frames[i].size());
+                if (rect.width < config.minSize || rect.height < config.minSize)
+                    continue;
+
+                crops.push_back(frames[i](rect));
+                targets.push_back(&det);
+            }
+        }
+
+        if (crops.empty())
+            return;
+
+        // Batched in chunks of the classifier engine batch size
+        auto results = classifier.process(crops);
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            for (const auto &[classId, className] : results[i].labels)
+            {
+                targets[i]->labels[classId] = className;
+            }
+        }
+    }
+
+    std::unique_ptr<trt::ClassificationProcessor> createClassifier(const nlohmann::json &data, bool multiLabel)
+    {
+        ClassifierConfig config;
+        config.loadFromJson(data);
+        if (multiLabel)
+            return std::make_unique<MultiLabelClassifier>(config);
+        return std::make_unique<SingleLabelClassifier>(config);
+    }
+
+    Cascade::Cascade(std::unique_ptr<trt::DetectionProcessor> detector,
+                     std::unique_ptr<trt::ClassificationProcessor> classifier,
+                     const CascadeConfig &config)
+        : m_detector(std::move(detector)), m_classifier(std::move(classifier)), m_config(config)
+    {
+        if (!m_detector || !m_classifier)
+        {
+            throw std::invalid_argument("Cascade requires a detector and a classifier");
+        }
+    }
+
+    std::vector<Detection> Cascade::process(const cv::Mat &frame)
+    {
+        return process(std::vector<cv::Mat>{frame})[0];
+    }
+
+    std::vector<std::vector<Detection>> Cascade::process(const std::vector<cv::Mat> &frames)
+    {
+        auto detections = m_detector->process(frames);
+        classify(frames, detections);
+        return detections;
+    }
+
+    std::vector<std::vector<Detection>> Cascade::process(const std::vector<cv::Mat> &frames, const std::vector<uint64_t> &frameIds)
+    {
+        auto detections = m_detector->process(frames, frameIds);
+        classify(frames, detections);
+        return detections;
+    }
+
+    void Cascade::setPreprocessCache(std::shared_ptr<trt::PreprocessCache> cache, const std::string &consumer)
+    {
+        m_detector->setPreprocessCache(std::move(cache), consumer);
+    }
+
+    void Cascade::classify(const std::vector<cv::Mat> &frames, std::vector<std::vector<Detection>> &detections)
+    {
+        classifyDetections(*m_classifier, m_config, frames, detections);
+    }
+
+    std::unique_ptr<trt::DetectionProcessor> Cascade::create(std::unique_ptr<trt::DetectionProcessor> detector, const nlohmann::json &data)
+    {
+        if (!data.contains("cascade"))
+            return detector;
+
+        if (!data.contains("classifier"))
+            throw std::runtime_error("Config file does not contain task: classifier");
+
+        CascadeConfig config;
+        config.loadFromJson(data["cascade"]);
+
+        return std::make_unique<Cascade>(std::move(detector), createClassifier(data["classifier"], config.multiLabel), config);
+    }
+
+} // namespace cls
@@ -3,56 +3,53 @@
 
 namespace cls
 {
-    bool BaseClassifier::preprocess(const cv::Mat &srcImg, cv::Mat &dstImg)
-    {
-        const auto &inputDims = engine->getInputDims();
-        assert(inputDims.size() == 1);
-
-        cv::Size size(inputDims[0].d[2], inputDims[0].d[1]);
-
-        cv::cvtColor(srcImg, dstImg, cv::COLOR_BGR2RGB);
-        dstImg = letterbox(dstImg, size, cv::Scalar(114, 114, 114), false, true, false, 32);
-        dstImg.convertTo(dstImg, CV_32FC3, 1.f / 255.f);
-        return !dstImg.empty();
-    }
-
-    Detection SingleLabelClassifier::postprocess(const trt::SingleOutput &featureVector)
+    Detection decodeSingleLabel(const std::vector<float> &scores, const ClassifierConfig &config)
     {
         Detection det;
-        auto maxElement = std::max_element(featureVector.begin(), featureVector.end());
-        if (*maxElement >= config.confidenceThreshold)
+        auto maxElement = std::max_element(scores.begin(), scores.end());
+        if (maxElement != scores.end() && *maxElement >= config.confidenceThreshold)
         {
-            det.class_id = std::distance(featureVector.begin(), maxElement);
+            det.class_id = std::distance(scores.begin(), maxElement);
             det.confidence = *maxElement;
-            det.class_name = getClassName(det.class_id);
+            det.class_name = getClassName(config, det.class_id);
             det.labels[det.class_id] = det.class_name;
         }
         return det;
     }
 
-    Detection MultiLabelClassifier::postprocess(const trt::SingleOutput &featureVector)
+    Detection decodeMultiLabel(const std::vector<float> &scores, const ClassifierConfig &config)
     {
         Detection det;
         float maxConfidence = 0.0f;
 
-        for (size_t i = 0; i < featureVector.size(); ++i)
+        for (size_t i = 0; i < scores.size(); ++i)
         {
-            if (featureVector[i] < config.confidenceThreshold)
+            if (scores[i] < config.confidenceThreshold)
                 continue;
 
             int class_id = static_cast<int>(i);
-            det.labels[det.class_id] = det.class_name;
+            det.labels[class_id] = getClassName(config, class_id);
 
             // Keep track of the highest confidence for the main detection fields
-            if (featureVector[i] > maxConfidence)
+            if (scores[i] > maxConfidence)
             {
-                maxConfidence = featureVector[i];
+                maxConfidence = scores[i];
                 det.class_id = class_id;
-                det.class_name = getClassName(class_id);
-                det.confidence = featureVector[i];
+                det.class_name = det.labels[class_id];
+                det.confidence = scores[i];
             }
         }
 
         return det;
     }
-} // cls
\ No newline at end of file
+
+    Detection SingleLabelClassifier::postprocess(const trt::SingleOutput &featureVector)
+    {
+        return decodeSingleLabel(featureVector, config);
+    }
+
+    Detection MultiLabelClassifier::postprocess(const trt::SingleOutput &featureVector)
+    {
+        return decodeMultiLabel(featureVector, config);
+    }
+} // cls
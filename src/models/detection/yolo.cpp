@@ -1,123 +1,117 @@
-#include <opencv2/dnn.hpp>
+#include <utils/nms.hpp>
 #include <utils/detection_utils.hpp>
 #include <models/detection/yolo.hpp>
 
 namespace det
 {
-
-    bool Yolo::preprocess(const cv::Mat &srcImg, cv::Mat &dstImg)
+    namespace
     {
-        const auto &inputDims = engine->getInputDims();
-        assert(inputDims.size() == 1);
-
-        cv::Size size(inputDims[0].d[2], inputDims[0].d[1]);
-
-        cv::cvtColor(srcImg, dstImg, cv::COLOR_BGR2RGB);
-        dstImg = letterbox(dstImg, size, cv::Scalar(114, 114, 114), false, true, false, 32);
-        dstImg.convertTo(dstImg, CV_32FC3, 1.f / 255.f);
-        return !dstImg.empty();
-    }
+        // Normalized box of a center, size prediction in input pixels
+        cv::Rect2d toBox(float xn, float yn, float wn, float hn, const cv::Size2f &size)
+        {
+            float x = std::clamp((xn - 0.5f * wn) / size.width, 0.f, 1.f);
+            float y = std::clamp((yn - 0.5f * hn) / size.height, 0.f, 1.f);
+            float w = std::clamp(wn / size.width, 0.f, 1.f);
+            float h = std::clamp(hn / size.height, 0.f, 1.f);
+            return cv::Rect2d(x, y, w, h);
+        }
 
-    std::vector<Detection> Yolo::postprocess(const trt::SingleOutput &featureVector)
-    {
-        const auto &inputDims = engine->getInputDims();
-        const auto &outputDims = engine->getOutputDims();
-        assert(outputDims.size() == 1);
+        void clearCandidates(YoloBuffers &buffers, int numAnchors)
+        {
+            buffers.bboxes.clear();
+            buffers.bboxes.reserve(numAnchors);
+            buffers.scores.clear();
+            buffers.scores.reserve(numAnchors);
+            buffers.classIds.clear();
+            buffers.classIds.reserve(numAnchors);
+        }
 
-        cv::Size2f size(inputDims[0].d[2], inputDims[0].d[1]);
+        void suppress(YoloBuffers &buffers, const YoloConfig &config, std::vector<Detection> &detections)
+        {
+            // Non Maximum Suppression
+            trt::nmsBoxes(buffers.bboxes, buffers.scores, config.confidenceThreshold, config.nmsThreshold,
+                          buffers.indices, buffers.candidates, config.nmsEta, config.topK);
 
-        auto numChannels = outputDims[0].d[1];
-        auto numAnchors = outputDims[0].d[2];
-        auto numClasses = numChannels - 4; // 4 bbox
+            // Fill output detections
+            detections.clear();
+            detections.reserve(buffers.indices.size());
 
-        std::vector<cv::Rect2d> bboxes;
-        bboxes.reserve(numAnchors);
+            for (auto &idx : buffers.indices)
+            {
+                detections.emplace_back(Detection{
+                    buffers.classIds[idx],
+                    buffers.scores[idx],
+                    buffers.bboxes[idx],
+                    getClassName(config, buffers.classIds[idx])});
+            }
+        }
+    } // namespace
 
-        std::vector<float> scores;
-        scores.reserve(numAnchors);
+    std::vector<Detection> decodeYolo(const float *output, int numChannels, int numAnchors, const cv::Size2f &inputSize, const YoloConfig &config)
+    {
+        YoloBuffers buffers;
+        std::vector<Detection> detections;
+        decodeYolo(output, numChannels, numAnchors, inputSize, config, buffers, detections);
+        return detections;
+    }
 
-        std::vector<int> class_ids;
-        class_ids.reserve(numAnchors);
+    void decodeYolo(const float *output, int numChannels, int numAnchors, const cv::Size2f &inputSize, const YoloConfig &config,
+                    YoloBuffers &buffers, std::vector<Detection> &detections)
+    {
+        auto numClasses = numChannels - 4; // 4 bbox
+        const size_t stride = numAnchors;
 
-        cv::Mat output = cv::Mat(numChannels, numAnchors, CV_32F, const_cast<float *>(featureVector.data()));
-        output = output.t();
+        // Best class of every anchor, channel after channel so that reads stay contiguous.
+        // Ties keep the first class, like std::max_element.
+        buffers.maxScores.assign(output + 4 * stride, output + 5 * stride);
+        buffers.maxClasses.assign(numAnchors, 0);
+        for (int c = 1; c < numClasses; ++c)
+        {
+            const float *classScores = output + (4 + c) * stride;
+            for (int i = 0; i < numAnchors; ++i)
+            {
+                if (classScores[i] > buffers.maxScores[i])
+                {
+                    buffers.maxScores[i] = classScores[i];
+                    buffers.maxClasses[i] = c;
+                }
+            }
+        }
 
+        clearCandidates(buffers, numAnchors);
         for (int i = 0; i < numAnchors; i++)
         {
-            auto rowPtr = output.row(i).ptr<float>();
-            auto bboxesPtr = rowPtr;
-            auto scoresPtr = rowPtr + 4;
-            auto maxClsPtr = std::max_element(scoresPtr, scoresPtr + numClasses);
-            float score = *maxClsPtr;
-            int class_id = maxClsPtr - scoresPtr;
-
+            float score = buffers.maxScores[i];
             if (score < config.confidenceThreshold)
             {
                 continue;
             }
 
-            float xn = *bboxesPtr++;
-            float yn = *bboxesPtr++;
-            float wn = *bboxesPtr++;
-            float hn = *bboxesPtr++;
-
-            float x = std::clamp((xn - 0.5f * wn) / size.width, 0.f, 1.f);
-            float y = std::clamp((yn - 0.5f * hn) / size.height, 0.f, 1.f);
-            float w = std::clamp(wn / size.width, 0.f, 1.f);
-            float h = std::clamp(hn / size.height, 0.f, 1.f);
-
-            bboxes.emplace_back(x, y, w, h);
-            class_ids.emplace_back(class_id);
-            scores.emplace_back(score);
+            buffers.bboxes.emplace_back(toBox(output[i], output[stride + i], output[2 * stride + i], output[3 * stride + i], inputSize));
+            buffers.classIds.emplace_back(buffers.maxClasses[i]);
+            buffers.scores.emplace_back(score);
         }
 
-        // Non Maximum Suppression
-        std::vector<int> indices;
-        cv::dnn::NMSBoxes(bboxes, scores, config.confidenceThreshold, config.nmsThreshold, indices, config.nmsEta, config.topK);
+        suppress(buffers, config, detections);
+    }
 
-        // Fill output detections
+    std::vector<Detection> decodeYolov7(const float *output, int numAnchors, int numChannels, const cv::Size2f &inputSize, const YoloConfig &config)
+    {
+        YoloBuffers buffers;
         std::vector<Detection> detections;
-        detections.reserve(indices.size());
-
-        for (auto &idx : indices)
-        {
-            detections.emplace_back(Detection{
-                class_ids[idx],
-                scores[idx],
-                bboxes[idx],
-                getClassName(class_ids[idx])});
-        }
-
+        decodeYolov7(output, numAnchors, numChannels, inputSize, config, buffers, detections);
         return detections;
     }
 
-    std::vector<Detection> Yolov7::postprocess(const trt::SingleOutput &featureVector)
+    void decodeYolov7(const float *output, int numAnchors, int numChannels, const cv::Size2f &inputSize, const YoloConfig &config,
+                      YoloBuffers &buffers, std::vector<Detection> &detections)
     {
-        const auto &inputDims = engine->getInputDims();
-        const auto &outputDims = engine->getOutputDims();
-        assert(outputDims.size() == 1);
-
-        cv::Size2f size(inputDims[0].d[2], inputDims[0].d[1]);
-
-        auto numAnchors = outputDims[0].d[1];
-        auto numChannels = outputDims[0].d[2];
         auto numClasses = numChannels - 5;
 
-        std::vector<cv::Rect2d> bboxes;
-        bboxes.reserve(numAnchors);
-
-        std::vector<float> scores;
-        scores.reserve(numAnchors);
-
-        std::vector<int> class_ids;
-        class_ids.reserve(numAnchors);
-
-        cv::Mat output = cv::Mat(numAnchors, numChannels, CV_32F, const_cast<float *>(featureVector.data()));
-
+        clearCandidates(buffers, numAnchors);
         for (int i = 0; i < numAnchors; i++)
         {
-            auto rowPtr = output.row(i).ptr<float>();
-            auto bboxesPtr = rowPtr;
+            auto rowPtr = output + static_cast<size_t>(i) * numChannels;
             auto objScorePtr = rowPtr + 4;
             auto clsScoresPtr = rowPtr + 5;
             auto maxClsPtr = std::max_element(clsScoresPtr, clsScoresPtr + numClasses);
@@ -129,38 +123,39 @@ namespace det
                 continue;
             }
 
-            float xn = *bboxesPtr++;
-            float yn = *bboxesPtr++;
-            float wn = *bboxesPtr++;
-            float hn = *bboxesPtr++;
+            buffers.bboxes.emplace_back(toBox(rowPtr[0], rowPtr[1], rowPtr[2], rowPtr[3], inputSize));
+            buffers.classIds.emplace_back(class_id);
+            buffers.scores.emplace_back(score);
+        }
 
-            float x = std::clamp((xn - 0.5f * wn) / size.width, 0.f, 1.f);
-            float y = std::clamp((yn - 0.5f * hn) / size.height, 0.f, 1.f);
-            float w = std::clamp(wn / size.width, 0.f, 1.f);
-            float h = std::clamp(hn / size.height, 0.f, 1.f);
+        suppress(buffers, config, detections);
+    }
 
-            bboxes.emplace_back(x, y, w, h);
-            class_ids.emplace_back(class_id);
-            scores.emplace_back(score);
-        }
+    Yolo::Yolo(const YoloConfig &t_config)
+        : Detector<trt::SingleOutput>(t_config.engine), config(t_config)
+    {
+        const auto &outputDims = engine->getOutputDims();
+        assert(outputDims.size() == 1);
+        outputRows = outputDims[0].d[1];
+        outputCols = outputDims[0].d[2];
+    }
 
-        // Non Maximum Suppression
-        std::vector<int> indices;
-        cv::dnn::NMSBoxes(bboxes, scores, config.confidenceThreshold, config.nmsThreshold, indices, config.nmsEta, config.topK);
+    Yolo::Yolo(const std::string &name, const YoloConfig &t_config, const cv::Size &inputSize, int t_outputRows, int t_outputCols)
+        : Detector<trt::SingleOutput>(name, inputSize), config(t_config), outputRows(t_outputRows), outputCols(t_outputCols)
+    {
+    }
 
-        // Fill output detections
+    std::vector<Detection> Yolo::postprocess(const trt::SingleOutput &featureVector)
+    {
         std::vector<Detection> detections;
-        detections.reserve(indices.size());
-
-        for (auto &idx : indices)
-        {
-            detections.emplace_back(Detection{
-                class_ids[idx],
-                scores[idx],
-                bboxes[idx],
-                getClassName(class_ids[idx])});
-        }
+        decodeYolo(featureVector.data(), outputRows, outputCols, cv::Size2f(getInputSize()), config, buffers, detections);
+        return detections;
+    }
 
+    std::vector<Detection> Yolov7::postprocess(const trt::SingleOutput &featureVector)
+    {
+        std::vector<Detection> detections;
+        decodeYolov7(featureVector.data(), outputRows, outputCols, cv::Size2f(getInputSize()), config, buffers, detections);
         return detections;
     }
-} // det
\ No newline at end of file
+} // det
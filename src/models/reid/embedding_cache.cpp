@@ -0,0 +1,47 @@
+#include <boost/filesystem.hpp>
+#include <models/reid/embedding_cache.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace reid
+{
+
+    EmbeddingCache::EmbeddingCache(const std::string &path) : m_path(path)
+    {
+        if (!fs::exists(path))
+            return;
+
+        m_gallery = std::make_unique<Gallery>(path);
+        if (m_gallery->getDepth() != CV_32F)
+            throw std::runtime_error("Embedding cache " + path + " must store fp32 embeddings");
+
+        for (size_t i = 0; i < m_gallery->size(); ++i)
+            m_index[static_cast<uint64_t>(m_gallery->getId(i))] = i;
+    }
+
+    std::optional<std::vector<float>> EmbeddingCache::get(uint64_t key) const
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+            return std::nullopt;
+
+        auto embeddings = m_gallery->getEmbeddings(it->second, it->second + 1);
+        const float *row = embeddings.data.ptr<float>(0);
+        return std::vector<float>(row, row + embeddings.dims());
+    }
+
+    void EmbeddingCache::put(const std::vector<uint64_t> &keys, const cv::Mat &embeddings)
+    {
+        if (keys.empty())
+            return;
+        if (!m_gallery)
+            m_gallery = std::make_unique<Gallery>(m_path, embeddings.cols, CV_32F);
+
+        std::vector<int64_t> ids(keys.begin(), keys.end());
+        const size_t first = m_gallery->size();
+        m_gallery->add(ids, embeddings);
+        for (size_t i = 0; i < keys.size(); ++i)
+            m_index[keys[i]] = first + i;
+    }
+
+} // namespace reid
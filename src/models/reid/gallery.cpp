@@ -0,0 +1,314 @@
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <models/reid/gallery.hpp>
+
+namespace reid
+{
+    namespace
+    {
+        // The file grows by this many records at a time
+        constexpr size_t GROWTH_RECORDS = 4096;
+        // Smallest number of entries worth a search thread
+        constexpr size_t MIN_SHARD_ENTRIES = 4096;
+
+        size_t getElementSize(int depth)
+        {
+            switch (depth)
+            {
+            case CV_32F:
+                return sizeof(float);
+            case CV_16F:
+                return sizeof(uint16_t);
+            case CV_8S:
+                return sizeof(int8_t);
+            default:
+                throw std::runtime_error("Gallery embeddings must be fp32, fp16 or int8");
+            }
+        }
+
+        // Bytes of a record aligned to 8, 0 when the embeddings cannot be stored
+        uint64_t getRecordSize(int dims, int depth)
+        {
+            if (dims <= 0 || (depth != CV_32F && depth != CV_16F && depth != CV_8S))
+                return 0;
+            return (sizeof(gallery::RecordHeader) + static_cast<uint64_t>(dims) * getElementSize(depth) + 7) / 8 * 8;
+        }
+    } // namespace
+
+    Gallery::Gallery(const std::string &path, size_t maxEntries)
+    {
+        open(path, 0, CV_32F, false, maxEntries);
+    }
+
+    Gallery::Gallery(const std::string &path, int dims, int depth, size_t maxEntries)
+    {
+        open(path, dims, depth, true, maxEntries);
+    }
+
+    Gallery::~Gallery()
+    {
+        if (m_data)
+            flush();
+        close();
+    }
+
+    void Gallery::close()
+    {
+        if (m_data)
+            ::munmap(m_data, m_mappedSize);
+        if (m_fd >= 0)
+            ::close(m_fd);
+        if (m_metadataFd >= 0)
+            ::close(m_metadataFd);
+        m_data = nullptr;
+        m_fd = -1;
+        m_metadataFd = -1;
+    }
+
+    void Gallery::open(const std::string &path, int dims, int depth, bool create, size_t maxEntries)
+    {
+        m_fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+        m_metadataFd = ::open((path + ".meta").c_str(), O_RDWR | O_APPEND | (create ? O_CREAT : 0), 0644);
+        if (m_fd < 0 || m_metadataFd < 0)
+        {
+            close();
+            throw std::runtime_error("Could not open gallery " + path);
+        }
+
+        struct stat info{};
+        struct stat metadataInfo{};
+        if (::fstat(m_fd, &info) != 0 || ::fstat(m_metadataFd, &metadataInfo) != 0)
+        {
+            close();
+            throw std::runtime_error("Could not open gallery " + path);
+        }
+        m_fileSize = static_cast<size_t>(info.st_size);
+        m_metadataSize = static_cast<uint64_t>(metadataInfo.st_size);
+
+        gallery::FileHeader header{};
+        if (m_fileSize == 0 && create)
+        {
+            const uint64_t recordSize = getRecordSize(dims, depth);
+            if (recordSize == 0 || recordSize > std::numeric_limits<uint32_t>::max())
+            {
+                close();
+                throw std::runtime_error("Gallery embeddings must be positive fp32, fp16 or int8 vectors");
+            }
+            std::memcpy(header.magic, gallery::FILE_MAGIC, sizeof(header.magic));
+            header.version = gallery::VERSION;
+            header.dims = dims;
+            header.depth = depth;
+            header.recordSize = static_cast<uint32_t>(recordSize);
+            if (::pwrite(m_fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+            {
+                close();
+                throw std::runtime_error("Could not create gallery " + path);
+            }
+            m_fileSize = sizeof(header);
+        }
+        else if (m_fileSize < sizeof(header) || ::pread(m_fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+                 std::memcmp(header.magic, gallery::FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != gallery::VERSION ||
+                 header.recordSize == 0 || header.recordSize != getRecordSize(header.dims, header.depth))
+        {
+            close();
+            throw std::runtime_error("Unsupported gallery " + path);
+        }
+        else if (create && (header.dims != dims || header.depth != depth))
+        {
+            close();
+            throw std::runtime_error("Gallery " + path + " does not match the requested embeddings");
+        }
+
+        m_dims = header.dims;
+        m_depth = header.depth;
+        m_recordSize = header.recordSize;
+        m_maxEntries = std::max<size_t>(maxEntries, header.count);
+
+        // Map the largest gallery up front so that the mapping never moves while it grows
+        m_mappedSize = std::max(m_fileSize, sizeof(header) + m_maxEntries * m_recordSize);
+        void *data = ::mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close();
+            throw std::runtime_error("Could not map gallery " + path);
+        }
+        m_data = static_cast<char *>(data);
+
+        // Records past the end of the file were not completely written
+        const size_t written = (m_fileSize - sizeof(header)) / m_recordSize;
+        m_count = std::min<size_t>(header.count, written);
+    }
+
+    void Gallery::reserve(size_t count)
+    {
+        if (count > m_maxEntries)
+            throw std::runtime_error("Gallery is full");
+
+        const size_t required = sizeof(gallery::FileHeader) + count * m_recordSize;
+        if (required <= m_fileSize)
+            return;
+
+        const size_t records = std::min(m_maxEntries, (count + GROWTH_RECORDS - 1) / GROWTH_RECORDS * GROWTH_RECORDS);
+        const size_t size = sizeof(gallery::FileHeader) + records * m_recordSize;
+        if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+            throw std::runtime_error("Could not grow gallery");
+        m_fileSize = size;
+    }
+
+    gallery::RecordHeader *Gallery::getRecord(size_t index) const
+    {
+        return reinterpret_cast<gallery::RecordHeader *>(m_data + sizeof(gallery::FileHeader) + index * m_recordSize);
+    }
+
+    size_t Gallery::add(int64_t id, const std::vector<float> &embedding, const std::string &metadata)
+    {
+        cv::Mat row(1, static_cast<int>(embedding.size()), CV_32F, const_cast<float *>(embedding.data()));
+        add({id}, row, {metadata});
+        return size() - 1;
+    }
+
+    void Gallery::add(const std::vector<int64_t> &ids, const cv::Mat &embeddings, const std::vector<std::string> &metadata)
+    {
+        if (embeddings.type() != CV_32F || embeddings.cols != m_dims || static_cast<size_t>(embeddings.rows) != ids.size())
+            throw std::runtime_error("Gallery expects one fp32 embedding of " + std::to_string(m_dims) + " values per id");
+        if (!metadata.empty() && metadata.size() != ids.size())
+            throw std::runtime_error("Gallery expects one metadata per id");
+
+        cv::Mat normalized = embeddings.clone();
+        kernels::normalize(normalized);
+        auto quantized = kernels::Embeddings::quantize(normalized, m_depth);
+        const size_t embeddingSize = m_dims * getElementSize(m_depth);
+
+        std::lock_guard<std::mutex> lock(m_appendMutex);
+        const size_t first = m_count.load(std::memory_order_relaxed);
+        reserve(first + ids.size());
+
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            auto *record = getRecord(first + i);
+            record->id = ids[i];
+            record->metadataOffset = m_metadataSize;
+            record->metadataSize = 0;
+            record->scale = m_depth == CV_8S ? quantized.scales.at<float>(static_cast<int>(i)) : 1.f;
+            std::memcpy(reinterpret_cast<char *>(record) + sizeof(gallery::RecordHeader), quantized.data.ptr(static_cast<int>(i)), embeddingSize);
+
+            if (!metadata.empty() && !metadata[i].empty())
+            {
+                if (::write(m_metadataFd, metadata[i].data(), metadata[i].size()) != static_cast<ssize_t>(metadata[i].size()))
+                    throw std::runtime_error("Could not write gallery metadata");
+                record->metadataSize = static_cast<uint32_t>(metadata[i].size());
+                m_metadataSize += metadata[i].size();
+            }
+        }
+
+        // Publish the new records to readers, then to the file header
+        m_count.store(first + ids.size(), std::memory_order_release);
+        reinterpret_cast<gallery::FileHeader *>(m_data)->count = first + ids.size();
+    }
+
+    kernels::Embeddings Gallery::getEmbeddings(size_t begin, size_t end) const
+    {
+        const int rows = static_cast<int>(end - begin);
+        char *record = reinterpret_cast<char *>(getRecord(begin));
+
+        kernels::Embeddings embeddings(cv::Mat(rows, m_dims, m_depth, record + sizeof(gallery::RecordHeader), m_recordSize));
+        if (m_depth == CV_8S)
+            embeddings.scales = cv::Mat(rows, 1, CV_32F, record + offsetof(gallery::RecordHeader, scale), m_recordSize);
+        return embeddings;
+    }
+
+    int64_t Gallery::getId(size_t index) const
+    {
+        return getRecord(index)->id;
+    }
+
+    std::string Gallery::getMetadata(size_t index) const
+    {
+        const auto *record = getRecord(index);
+        std::string metadata(record->metadataSize, '\0');
+        if (record->metadataSize > 0 &&
+            ::pread(m_metadataFd, metadata.data(), metadata.size(), static_cast<off_t>(record->metadataOffset)) != static_cast<ssize_t>(metadata.size()))
+        {
+            throw std::runtime_error("Could not read gallery metadata");
+        }
+        return metadata;
+    }
+
+    std::vector<std::vector<GalleryMatch>> Gallery::search(const cv::Mat &queries, size_t k, size_t numThreads) const
+    {
+        if (queries.type() != CV_32F || queries.cols != m_dims)
+            throw std::runtime_error("Gallery expects fp32 queries of " + std::to_string(m_dims) + " values");
+
+        cv::Mat normalized = queries.clone();
+        kernels::normalize(normalized);
+        const auto quantized = kernels::Embeddings::quantize(normalized, m_depth);
+
+        // Entries appended during the search are not visited
+        const size_t count = size();
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        const size_t numShards = std::max<size_t>(1, std::min(numThreads, count / MIN_SHARD_ENTRIES));
+        const size_t shardSize = (count + numShards - 1) / numShards;
+
+        // Per shard top k, then merged
+        std::vector<std::vector<std::vector<kernels::Match>>> shardMatches(numShards);
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(numShards);
+        for (size_t s = 0; s < numShards; ++s)
+        {
+            threads.emplace_back([&, s]()
+                                 {
+                                     const size_t begin = std::min(count, s * shardSize);
+                                     const size_t end = std::min(count, begin + shardSize);
+                                     try
+                                     {
+                                         shardMatches[s] = kernels::topK(quantized, getEmbeddings(begin, end), k);
+                                         for (auto &matches : shardMatches[s])
+                                             for (auto &match : matches)
+                                                 match.index += static_cast<int>(begin);
+                                     }
+                                     catch (...)
+                                     {
+                                         errors[s] = std::current_exception();
+                                     } });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        for (auto &error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        std::vector<std::vector<GalleryMatch>> results(queries.rows);
+        for (int q = 0; q < queries.rows; ++q)
+        {
+            std::vector<kernels::Match> merged;
+            for (const auto &matches : shardMatches)
+                merged.insert(merged.end(), matches[q].begin(), matches[q].end());
+
+            const size_t n = std::min(k, merged.size());
+            std::partial_sort(merged.begin(), merged.begin() + n, merged.end(), [](const kernels::Match &a, const kernels::Match &b)
+                              { return a.score > b.score; });
+
+            for (size_t i = 0; i < n; ++i)
+                results[q].push_back({getId(merged[i].index), merged[i].score, getMetadata(merged[i].index)});
+        }
+        return results;
+    }
+
+    void Gallery::flush()
+    {
+        std::lock_guard<std::mutex> lock(m_appendMutex);
+        ::msync(m_data, std::min(m_fileSize, m_mappedSize), MS_SYNC);
+        ::fsync(m_metadataFd);
+    }
+
+} // namespace reid
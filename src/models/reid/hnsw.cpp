@@ -0,0 +1,541 @@
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <models/reid/hnsw.hpp>
+
+namespace reid
+{
+    namespace
+    {
+        constexpr int MAX_LEVEL = 16;
+
+        size_t align8(size_t size)
+        {
+            return (size + 7) / 8 * 8;
+        }
+
+        uint64_t splitmix64(uint64_t x)
+        {
+            x += 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return x ^ (x >> 31);
+        }
+
+        kernels::Embeddings prepareQueries(const cv::Mat &queries, int dims, int depth)
+        {
+            if (queries.type() != CV_32F || queries.cols != dims)
+                throw std::runtime_error("Index expects fp32 queries of " + std::to_string(dims) + " values");
+
+            cv::Mat normalized = queries.clone();
+            kernels::normalize(normalized);
+            return kernels::Embeddings::quantize(normalized, depth);
+        }
+    } // namespace
+
+    HnswIndex::HnswIndex(const Gallery &gallery, const HnswParams &params)
+        : m_gallery(gallery), m_params(params), m_maxLinks0(2 * params.m)
+    {
+        if (params.m < 2)
+            throw std::runtime_error("Index needs at least 2 neighbors per node");
+    }
+
+    HnswIndex::HnswIndex(const Gallery &gallery, const std::string &path, size_t efSearch)
+        : m_gallery(gallery)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Could not open index " + path);
+
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(hnsw::FileHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error("Invalid index " + path);
+        }
+
+        // Private mapping: links of loaded nodes are updated copy-on-write by later inserts
+        m_mappedSize = static_cast<size_t>(info.st_size);
+        m_mapped = ::mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (m_mapped == MAP_FAILED)
+        {
+            m_mapped = nullptr;
+            throw std::runtime_error("Could not map index " + path);
+        }
+
+        char *data = static_cast<char *>(m_mapped);
+        const auto *header = reinterpret_cast<const hnsw::FileHeader *>(data);
+        if (std::memcmp(header->magic, hnsw::FILE_MAGIC, sizeof(header->magic)) != 0 || header->version != hnsw::VERSION)
+        {
+            ::munmap(m_mapped, m_mappedSize);
+            throw std::runtime_error("Unsupported index " + path);
+        }
+        if (header->count > gallery.size())
+        {
+            ::munmap(m_mapped, m_mappedSize);
+            throw std::runtime_error("Index " + path + " does not belong to this gallery");
+        }
+
+        m_params.m = header->m;
+        m_params.efConstruction = header->efConstruction;
+        m_params.efSearch = efSearch;
+        m_maxLinks0 = 2 * m_params.m;
+        m_count = header->count;
+        m_capacity = header->count;
+        m_entryPoint = header->entryPoint;
+        m_maxLevel = header->maxLevel;
+
+        size_t offset = sizeof(hnsw::FileHeader);
+        m_links0 = reinterpret_cast<int32_t *>(data + offset);
+        offset += align8(m_count * (1 + m_maxLinks0) * sizeof(int32_t));
+        m_levels = reinterpret_cast<int32_t *>(data + offset);
+        offset += align8(m_count * sizeof(int32_t));
+        const auto *upperOffsets = reinterpret_cast<const uint64_t *>(data + offset);
+        offset += m_count * sizeof(uint64_t);
+        auto *upper = reinterpret_cast<int32_t *>(data + offset);
+        if (offset + header->upperSize * sizeof(int32_t) > m_mappedSize)
+        {
+            ::munmap(m_mapped, m_mappedSize);
+            throw std::runtime_error("Truncated index " + path);
+        }
+
+        m_upperLinks.assign(m_count, nullptr);
+        m_ownedUpperLinks.resize(m_count);
+        for (size_t node = 0; node < m_count; ++node)
+        {
+            if (m_levels[node] > 0)
+                m_upperLinks[node] = upper + upperOffsets[node];
+        }
+    }
+
+    HnswIndex::~HnswIndex()
+    {
+        if (m_mapped)
+            ::munmap(m_mapped, m_mappedSize);
+    }
+
+    int32_t *HnswIndex::getLinks(int32_t node, int level) const
+    {
+        if (level == 0)
+            return m_links0 + static_cast<size_t>(node) * (1 + m_maxLinks0);
+        return m_upperLinks[node] + static_cast<size_t>(level - 1) * (1 + m_params.m);
+    }
+
+    std::vector<int32_t> HnswIndex::getNeighbors(int32_t node, int level) const
+    {
+        std::lock_guard<std::mutex> lock(m_nodeMutexes[node % m_nodeMutexes.size()]);
+        const int32_t *links = getLinks(node, level);
+        return std::vector<int32_t>(links + 1, links + 1 + links[0]);
+    }
+
+    int HnswIndex::drawLevel(int32_t node) const
+    {
+        // Deterministic per node, so that parallel builds give the same layers
+        const uint64_t hash = splitmix64(m_params.seed ^ (static_cast<uint64_t>(node) << 16));
+        const double uniform = static_cast<double>((hash >> 11) + 1) * 0x1.0p-53;
+        return std::min(MAX_LEVEL, static_cast<int>(-std::log(uniform) / std::log(static_cast<double>(m_params.m))));
+    }
+
+    void HnswIndex::reserve(size_t capacity)
+    {
+        if (capacity <= m_capacity)
+            return;
+
+        std::vector<int32_t> links0(capacity * (1 + m_maxLinks0), 0);
+        std::copy(m_links0, m_links0 + m_count * (1 + m_maxLinks0), links0.begin());
+        std::vector<int32_t> levels(capacity, 0);
+        std::copy(m_levels, m_levels + m_count, levels.begin());
+
+        m_upperLinks.resize(capacity, nullptr);
+        m_ownedUpperLinks.resize(capacity);
+        for (size_t node = 0; node < m_count; ++node)
+        {
+            if (m_upperLinks[node] && !m_ownedUpperLinks[node])
+            {
+                const size_t size = levels[node] * (1 + m_params.m);
+                m_ownedUpperLinks[node] = std::make_unique<int32_t[]>(size);
+                std::copy(m_upperLinks[node], m_upperLinks[node] + size, m_ownedUpperLinks[node].get());
+                m_upperLinks[node] = m_ownedUpperLinks[node].get();
+            }
+        }
+
+        m_ownedLinks0 = std::move(links0);
+        m_ownedLevels = std::move(levels);
+        m_links0 = m_ownedLinks0.data();
+        m_levels = m_ownedLevels.data();
+        m_capacity = capacity;
+
+        if (m_mapped)
+        {
+            ::munmap(m_mapped, m_mappedSize);
+            m_mapped = nullptr;
+        }
+    }
+
+    void HnswIndex::update(size_t numThreads)
+    {
+        const size_t begin = m_count;
+        const size_t end = m_gallery.size();
+        if (end <= begin)
+            return;
+
+        {
+            std::unique_lock<std::shared_mutex> lock(m_resizeMutex);
+            reserve(std::max(end, 2 * m_capacity));
+        }
+
+        std::shared_lock<std::shared_mutex> lock(m_resizeMutex);
+        const auto embeddings = m_gallery.getEmbeddings(0, end);
+
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        numThreads = std::min(numThreads, end - begin);
+
+        std::atomic<size_t> next{begin};
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(numThreads);
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back([&, t]()
+                                 {
+                                     try
+                                     {
+                                         for (size_t node = next++; node < end; node = next++)
+                                             insert(static_cast<int32_t>(node), embeddings);
+                                     }
+                                     catch (...)
+                                     {
+                                         errors[t] = std::current_exception();
+                                     } });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        for (auto &error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        m_count = end;
+    }
+
+    void HnswIndex::insert(int32_t node, const kernels::Embeddings &embeddings)
+    {
+        const int level = drawLevel(node);
+        m_levels[node] = level;
+        if (level > 0)
+        {
+            m_ownedUpperLinks[node] = std::make_unique<int32_t[]>(level * (1 + m_params.m));
+            m_upperLinks[node] = m_ownedUpperLinks[node].get();
+        }
+
+        // Nodes raising the top level keep the entry point locked until they are linked
+        std::unique_lock<std::mutex> entryLock(m_entryMutex);
+        int32_t entry = m_entryPoint;
+        const int maxLevel = m_maxLevel;
+        if (entry < 0)
+        {
+            m_entryPoint = node;
+            m_maxLevel = level;
+            return;
+        }
+        if (level <= maxLevel)
+            entryLock.unlock();
+
+        // Greedy descent through the layers above the node
+        float best;
+        kernels::dot(embeddings, node, embeddings, &entry, 1, &best);
+        std::vector<float> similarities;
+        for (int l = maxLevel; l > level; --l)
+        {
+            for (bool changed = true; changed;)
+            {
+                changed = false;
+                auto neighbors = getNeighbors(entry, l);
+                similarities.resize(neighbors.size());
+                kernels::dot(embeddings, node, embeddings, neighbors.data(), neighbors.size(), similarities.data());
+                for (size_t i = 0; i < neighbors.size(); ++i)
+                {
+                    if (similarities[i] > best)
+                    {
+                        best = similarities[i];
+                        entry = neighbors[i];
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        for (int l = std::min(level, maxLevel); l >= 0; --l)
+        {
+            auto candidates = searchLayer(embeddings, node, embeddings, entry, m_params.efConstruction, l);
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [node](const Candidate &c)
+                                            { return c.node == node; }),
+                             candidates.end());
+            if (candidates.empty())
+                continue;
+
+            auto neighbors = selectNeighbors(candidates, m_params.m, embeddings);
+            {
+                std::lock_guard<std::mutex> lock(m_nodeMutexes[node % m_nodeMutexes.size()]);
+                int32_t *links = getLinks(node, l);
+                links[0] = static_cast<int32_t>(neighbors.size());
+                std::copy(neighbors.begin(), neighbors.end(), links + 1);
+            }
+            for (int32_t neighbor : neighbors)
+                connect(neighbor, node, l, embeddings);
+
+            entry = candidates.front().node;
+        }
+
+        if (level > maxLevel)
+        {
+            m_entryPoint = node;
+            m_maxLevel = level;
+        }
+    }
+
+    std::vector<HnswIndex::Candidate> HnswIndex::searchLayer(const kernels::Embeddings &queries, int q, const kernels::Embeddings &embeddings,
+                                                             int32_t entry, size_t ef, int level) const
+    {
+        // Visited nodes are tagged with an epoch, so that the buffer is never cleared
+        thread_local std::vector<uint32_t> visited;
+        thread_local uint32_t epoch = 0;
+        if (visited.size() < static_cast<size_t>(embeddings.rows()))
+            visited.resize(embeddings.rows(), 0);
+        if (++epoch == 0)
+        {
+            std::fill(visited.begin(), visited.end(), 0);
+            epoch = 1;
+        }
+
+        const auto closer = [](const Candidate &a, const Candidate &b)
+        { return a.similarity < b.similarity; };
+        const auto further = [](const Candidate &a, const Candidate &b)
+        { return a.similarity > b.similarity; };
+
+        // Candidates to expand, best on top, and results found so far, worst on top
+        std::vector<Candidate> candidates;
+        std::vector<Candidate> results;
+        float similarity;
+        kernels::dot(queries, q, embeddings, &entry, 1, &similarity);
+        candidates.push_back({similarity, entry});
+        results.push_back({similarity, entry});
+        visited[entry] = epoch;
+
+        std::vector<int32_t> unvisited;
+        std::vector<float> similarities;
+        while (!candidates.empty())
+        {
+            std::pop_heap(candidates.begin(), candidates.end(), closer);
+            const Candidate current = candidates.back();
+            candidates.pop_back();
+            if (results.size() >= ef && current.similarity < results.front().similarity)
+                break;
+
+            unvisited.clear();
+            for (int32_t neighbor : getNeighbors(current.node, level))
+            {
+                if (visited[neighbor] != epoch)
+                {
+                    visited[neighbor] = epoch;
+                    unvisited.push_back(neighbor);
+                }
+            }
+
+            similarities.resize(unvisited.size());
+            kernels::dot(queries, q, embeddings, unvisited.data(), unvisited.size(), similarities.data());
+            for (size_t i = 0; i < unvisited.size(); ++i)
+            {
+                if (results.size() < ef || similarities[i] > results.front().similarity)
+                {
+                    candidates.push_back({similarities[i], unvisited[i]});
+                    std::push_heap(candidates.begin(), candidates.end(), closer);
+                    results.push_back({similarities[i], unvisited[i]});
+                    std::push_heap(results.begin(), results.end(), further);
+                    if (results.size() > ef)
+                    {
+                        std::pop_heap(results.begin(), results.end(), further);
+                        results.pop_back();
+                    }
+                }
+            }
+        }
+
+        std::sort_heap(results.begin(), results.end(), further);
+        return results;
+    }
+
+    std::vector<int32_t> HnswIndex::selectNeighbors(std::vector<Candidate> candidates, size_t max, const kernels::Embeddings &embeddings) const
+    {
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                  { return a.similarity > b.similarity; });
+
+        // Keep a candidate only if it is closer to the base than to every kept neighbor,
+        // so that links spread in different directions
+        std::vector<int32_t> selected;
+        std::vector<float> similarities;
+        for (const auto &candidate : candidates)
+        {
+            if (selected.size() >= max)
+                break;
+
+            similarities.resize(selected.size());
+            kernels::dot(embeddings, candidate.node, embeddings, selected.data(), selected.size(), similarities.data());
+            if (std::all_of(similarities.begin(), similarities.end(), [&](float s)
+                            { return s < candidate.similarity; }))
+            {
+                selected.push_back(candidate.node);
+            }
+        }
+        return selected;
+    }
+
+    void HnswIndex::connect(int32_t node, int32_t neighbor, int level, const kernels::Embeddings &embeddings)
+    {
+        const size_t maxLinks = level == 0 ? m_maxLinks0 : m_params.m;
+
+        std::lock_guard<std::mutex> lock(m_nodeMutexes[node % m_nodeMutexes.size()]);
+        int32_t *links = getLinks(node, level);
+        const size_t size = static_cast<size_t>(links[0]);
+        if (std::find(links + 1, links + 1 + size, neighbor) != links + 1 + size)
+            return;
+
+        if (size < maxLinks)
+        {
+            links[1 + size] = neighbor;
+            links[0] = static_cast<int32_t>(size + 1);
+            return;
+        }
+
+        // Full, prune the existing links and the new one
+        std::vector<int32_t> ids(links + 1, links + 1 + size);
+        ids.push_back(neighbor);
+        std::vector<float> similarities(ids.size());
+        kernels::dot(embeddings, node, embeddings, ids.data(), ids.size(), similarities.data());
+
+        std::vector<Candidate> candidates;
+        for (size_t i = 0; i < ids.size(); ++i)
+            candidates.push_back({similarities[i], ids[i]});
+
+        auto selected = selectNeighbors(std::move(candidates), maxLinks, embeddings);
+        links[0] = static_cast<int32_t>(selected.size());
+        std::copy(selected.begin(), selected.end(), links + 1);
+    }
+
+    std::vector<std::vector<GalleryMatch>> HnswIndex::search(const cv::Mat &queries, size_t k, size_t ef) const
+    {
+        const auto quantized = prepareQueries(queries, m_gallery.getDims(), m_gallery.getDepth());
+        ef = std::max(k, ef > 0 ? ef : m_params.efSearch);
+
+        std::shared_lock<std::shared_mutex> lock(m_resizeMutex);
+        const auto embeddings = m_gallery.getEmbeddings(0, m_gallery.size());
+
+        int32_t entryPoint;
+        int maxLevel;
+        {
+            std::lock_guard<std::mutex> entryLock(m_entryMutex);
+            entryPoint = m_entryPoint;
+            maxLevel = m_maxLevel;
+        }
+
+        std::vector<std::vector<GalleryMatch>> results(queries.rows);
+        if (entryPoint < 0)
+            return results;
+
+        std::vector<float> similarities;
+        for (int q = 0; q < queries.rows; ++q)
+        {
+            // Greedy descent to layer 0, then a best-first search of ef candidates
+            int32_t entry = entryPoint;
+            float best;
+            kernels::dot(quantized, q, embeddings, &entry, 1, &best);
+            for (int l = maxLevel; l > 0; --l)
+            {
+                for (bool changed = true; changed;)
+                {
+                    changed = false;
+                    auto neighbors = getNeighbors(entry, l);
+                    similarities.resize(neighbors.size());
+                    kernels::dot(quantized, q, embeddings, neighbors.data(), neighbors.size(), similarities.data());
+                    for (size_t i = 0; i < neighbors.size(); ++i)
+                    {
+                        if (similarities[i] > best)
+                        {
+                            best = similarities[i];
+                            entry = neighbors[i];
+                            changed = true;
+                        }
+                    }
+                }
+            }
+
+            auto candidates = searchLayer(quantized, q, embeddings, entry, ef, 0);
+            for (size_t i = 0; i < std::min(k, candidates.size()); ++i)
+            {
+                const auto node = candidates[i].node;
+                results[q].push_back({m_gallery.getId(node), candidates[i].similarity, m_gallery.getMetadata(node)});
+            }
+        }
+        return results;
+    }
+
+    void HnswIndex::save(const std::string &path) const
+    {
+        std::unique_lock<std::shared_mutex> lock(m_resizeMutex);
+
+        std::vector<uint64_t> upperOffsets(m_count, 0);
+        uint64_t upperSize = 0;
+        for (size_t node = 0; node < m_count; ++node)
+        {
+            upperOffsets[node] = upperSize;
+            upperSize += static_cast<uint64_t>(m_levels[node]) * (1 + m_params.m);
+        }
+
+        hnsw::FileHeader header{};
+        std::memcpy(header.magic, hnsw::FILE_MAGIC, sizeof(header.magic));
+        header.version = hnsw::VERSION;
+        header.m = static_cast<uint32_t>(m_params.m);
+        header.efConstruction = static_cast<uint32_t>(m_params.efConstruction);
+        header.count = m_count;
+        header.entryPoint = m_entryPoint;
+        header.maxLevel = m_maxLevel;
+        header.upperSize = upperSize;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Could not create index " + path);
+
+        const auto pad = [&file](size_t size)
+        {
+            static const char zeros[8] = {};
+            file.write(zeros, static_cast<std::streamsize>(align8(size) - size));
+        };
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        const size_t links0Size = m_count * (1 + m_maxLinks0) * sizeof(int32_t);
+        file.write(reinterpret_cast<const char *>(m_links0), static_cast<std::streamsize>(links0Size));
+        pad(links0Size);
+        file.write(reinterpret_cast<const char *>(m_levels), static_cast<std::streamsize>(m_count * sizeof(int32_t)));
+        pad(m_count * sizeof(int32_t));
+        file.write(reinterpret_cast<const char *>(upperOffsets.data()), static_cast<std::streamsize>(m_count * sizeof(uint64_t)));
+        for (size_t node = 0; node < m_count; ++node)
+        {
+            if (m_levels[node] > 0)
+                file.write(reinterpret_cast<const char *>(m_upperLinks[node]), static_cast<std::streamsize>(m_levels[node] * (1 + m_params.m) * sizeof(int32_t)));
+        }
+
+        if (!file.good())
+            throw std::runtime_error("Could not write index " + path);
+    }
+
+} // namespace reid
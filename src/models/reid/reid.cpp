@@ -1,26 +1,60 @@
+#include <numeric>
+#include <kernels/similarity.hpp>
 #include <models/reid/reid.hpp>
-#include <utils/vector_utils.hpp>
 #include <utils/detection_utils.hpp>
 
 namespace reid
 {
 
-    bool ReId::preprocess(const cv::Mat &srcImg, cv::Mat &dstImg)
+    cv::Mat ReId::embed(const cv::Mat &image, const std::vector<cv::Rect2d> &rois)
     {
-        const auto &inputDims = engine->getInputDims();
-        assert(inputDims.size() == 1);
+        auto features = process(image, rois);
+        if (features.empty())
+        {
+            return cv::Mat();
+        }
 
-        cv::Size size(inputDims[0].d[2], inputDims[0].d[1]);
+        cv::Mat embeddings(static_cast<int>(features.size()), static_cast<int>(features[0].size()), CV_32F);
+        for (size_t i = 0; i < features.size(); ++i)
+        {
+            std::copy(features[i].begin(), features[i].end(), embeddings.ptr<float>(static_cast<int>(i)));
+        }
+        return embeddings;
+    }
+
+    void ReId::extractFeatures(const cv::Mat &image, std::vector<Detection> &detections)
+    {
+        std::vector<size_t> indices(detections.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        extractFeatures(image, detections, indices);
+    }
+
+    void ReId::extractFeatures(const cv::Mat &image, std::vector<Detection> &detections, const std::vector<size_t> &indices)
+    {
+        if (indices.empty())
+        {
+            return;
+        }
+
+        std::vector<cv::Rect2d> rois;
+        rois.reserve(indices.size());
+        for (size_t index : indices)
+        {
+            rois.push_back(detections[index].bbox);
+        }
 
-        cv::cvtColor(srcImg, dstImg, cv::COLOR_BGR2RGB);
-        dstImg = letterbox(dstImg, size, cv::Scalar(114, 114, 114), false, true, false, 32);
-        dstImg.convertTo(dstImg, CV_32FC3, 1.f / 255.f);
-        return !dstImg.empty();
+        auto features = process(image, rois);
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            detections[indices[i]].features = std::move(features[i]);
+        }
     }
 
     std::vector<float> ReId::postprocess(const trt::SingleOutput &featureVector)
     {
-        return vector_ops::normalize(featureVector);
+        std::vector<float> features(featureVector);
+        kernels::normalize(features);
+        return features;
     }
 
 } // namespace reid
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <models/reid/track_cache.hpp>
+
+namespace reid
+{
+    namespace
+    {
+        double iou(const cv::Rect2d &a, const cv::Rect2d &b)
+        {
+            const double intersection = (a & b).area();
+            const double unionArea = a.area() + b.area() - intersection;
+            return unionArea > 0.0 ? intersection / unionArea : 0.0;
+        }
+    } // namespace
+
+    std::vector<size_t> TrackCache::lookup(std::vector<Detection> &detections)
+    {
+        std::vector<size_t> misses;
+        m_sources.assign(detections.size(), -1);
+
+        for (size_t i = 0; i < detections.size(); ++i)
+        {
+            auto &det = detections[i];
+
+            // Best and second best track continued by this detection
+            int bestTrack = -1;
+            double bestIou = 0.0;
+            double secondIou = 0.0;
+            for (const auto &[trackId, entry] : m_entries)
+            {
+                if (entry.lastSeen != m_frame)
+                    continue;
+
+                double overlap = iou(det.bbox, entry.lastBox);
+                if (overlap > bestIou)
+                {
+                    secondIou = bestIou;
+                    bestIou = overlap;
+                    bestTrack = trackId;
+                }
+                else if (overlap > secondIou)
+                {
+                    secondIou = overlap;
+                }
+            }
+
+            bool reuse = bestTrack >= 0 &&
+                         bestIou >= m_config.matchThreshold &&
+                         secondIou < m_config.ambiguityThreshold;
+
+            // Crowded detections are ambiguous, their appearance may mix several objects
+            for (size_t j = 0; reuse && j < detections.size(); ++j)
+            {
+                reuse = j == i || iou(det.bbox, detections[j].bbox) < m_config.ambiguityThreshold;
+            }
+
+            if (reuse)
+            {
+                const auto &entry = m_entries.at(bestTrack);
+                const double scale = det.bbox.area() / std::max(entry.refreshBox.area(), 1e-12);
+                reuse = std::abs(scale - 1.0) <= m_config.maxScaleChange &&
+                        m_frame - entry.refreshedAt < m_config.refreshInterval;
+            }
+
+            if (reuse)
+            {
+                const auto &entry = m_entries.at(bestTrack);
+                det.features = entry.features;
+                det.labels = entry.labels;
+                m_sources[i] = bestTrack;
+                ++m_hits;
+            }
+            else
+            {
+                misses.push_back(i);
+                ++m_misses;
+            }
+        }
+        return misses;
+    }
+
+    void TrackCache::update(const std::vector<Detection> &detections)
+    {
+        ++m_frame;
+
+        for (size_t i = 0; i < detections.size(); ++i)
+        {
+            const auto &det = detections[i];
+            if (det.track_id < 0)
+                continue;
+
+            auto [it, inserted] = m_entries.try_emplace(det.track_id);
+            auto &entry = it->second;
+            entry.lastBox = det.bbox;
+            entry.lastSeen = m_frame;
+
+            const int source = i < m_sources.size() ? m_sources[i] : -1;
+
+            // Outputs reused from this very track, nothing new to record
+            if (!inserted && source == det.track_id)
+                continue;
+
+            // Outputs reused from another track the tracker did not associate it with
+            if (source >= 0 && source != det.track_id)
+            {
+                // Force a refresh on the next frame
+                entry.refreshedAt = m_frame - m_config.refreshInterval;
+                entry.refreshBox = det.bbox;
+                continue;
+            }
+
+            entry.features = det.features;
+            entry.labels = det.labels;
+            entry.refreshBox = det.bbox;
+            entry.refreshedAt = m_frame;
+        }
+
+        m_sources.clear();
+
+        // Forget lost tracks
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            if (m_frame - it->second.lastSeen > m_config.maxAge)
+                it = m_entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+} // namespace reid
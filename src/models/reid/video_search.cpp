@@ -0,0 +1,162 @@
+#include <thread>
+#include <kernels/similarity.hpp>
+#include <utils/bounded_queue.hpp>
+#include <utils/tensorrt_utils.hpp>
+#include <models/reid/video_search.hpp>
+
+namespace reid
+{
+    namespace
+    {
+        struct FrameBatch
+        {
+            std::vector<int64_t> indices{};
+            std::vector<double> timestamps{};
+            std::vector<cv::Mat> images{};
+        };
+
+        struct DetectionBatch
+        {
+            FrameBatch frames{};
+            std::vector<std::vector<Detection>> detections{};
+        };
+    } // namespace
+
+    VideoSearch::VideoSearch(trt::DetectionProcessor &detector, ReId &reid, const VideoSearchConfig &config)
+        : m_detector(detector), m_reid(reid), m_config(config)
+    {
+    }
+
+    void VideoSearch::run(cv::VideoCapture &capture, const cv::Mat &queries, const std::function<void(const VideoMatch &)> &callback)
+    {
+        m_running = true;
+        m_searchedFrames = 0;
+        m_detections = 0;
+
+        trt::BoundedQueue<FrameBatch> frameQueue(m_config.queueSize);
+        trt::BoundedQueue<DetectionBatch> detectionQueue(m_config.queueSize);
+        std::exception_ptr decodeError = nullptr;
+        std::exception_ptr detectError = nullptr;
+
+        // Decode: skipped frames are only grabbed, not converted
+        std::thread decoder([&]()
+                            {
+                                try
+                                {
+                                    const size_t stride = std::max<size_t>(1, m_config.frameStride);
+                                    FrameBatch batch;
+                                    for (int64_t index = 0; m_running; ++index)
+                                    {
+                                        if (index % static_cast<int64_t>(stride) != 0)
+                                        {
+                                            if (!capture.grab())
+                                                break;
+                                            continue;
+                                        }
+
+                                        cv::Mat image;
+                                        if (!capture.read(image) || image.empty())
+                                            break;
+
+                                        batch.indices.push_back(index);
+                                        batch.timestamps.push_back(capture.get(cv::CAP_PROP_POS_MSEC));
+                                        batch.images.push_back(std::move(image));
+                                        if (batch.images.size() >= m_config.frameBatch)
+                                        {
+                                            if (!frameQueue.push(std::move(batch)))
+                                                break;
+                                            batch = FrameBatch();
+                                        }
+                                    }
+                                    if (!batch.images.empty())
+                                        frameQueue.push(std::move(batch));
+                                }
+                                catch (...)
+                                {
+                                    decodeError = std::current_exception();
+                                }
+                                frameQueue.close(); });
+
+        // Detect
+        std::thread detector([&]()
+                             {
+                                 try
+                                 {
+                                     while (auto batch = frameQueue.pop())
+                                     {
+                                         DetectionBatch result;
+                                         result.detections = m_detector.process(batch->images);
+                                         result.frames = std::move(*batch);
+                                         if (!detectionQueue.push(std::move(result)))
+                                             break;
+                                     }
+                                 }
+                                 catch (...)
+                                 {
+                                     detectError = std::current_exception();
+                                 }
+                                 frameQueue.close();
+                                 detectionQueue.close(); });
+
+        // Embed every crop of a frame batch at once, then match them against the queries
+        std::exception_ptr embedError = nullptr;
+        try
+        {
+            while (auto batch = detectionQueue.pop())
+            {
+                std::vector<cv::Mat> crops;
+                std::vector<std::pair<size_t, const Detection *>> sources;
+                for (size_t f = 0; f < batch->frames.images.size(); ++f)
+                {
+                    const auto &image = batch->frames.images[f];
+                    for (const auto &det : batch->detections[f])
+                    {
+                        if (!m_config.className.empty() && det.class_name != m_config.className)
+                            continue;
+                        crops.push_back(image(trt::toPixelRect(det.bbox, image.size())));
+                        sources.emplace_back(f, &det);
+                    }
+                }
+                m_searchedFrames += batch->frames.images.size();
+                m_detections += crops.size();
+                if (crops.empty())
+                    continue;
+
+                auto features = m_reid.process(crops);
+                cv::Mat embeddings(static_cast<int>(features.size()), static_cast<int>(features[0].size()), CV_32F);
+                for (size_t i = 0; i < features.size(); ++i)
+                    std::copy(features[i].begin(), features[i].end(), embeddings.ptr<float>(static_cast<int>(i)));
+
+                auto matches = kernels::argmax(embeddings, queries);
+                for (size_t i = 0; i < matches.size(); ++i)
+                {
+                    if (matches[i].score < m_config.minSimilarity)
+                        continue;
+
+                    const auto [frame, det] = sources[i];
+                    callback({batch->frames.indices[frame], batch->frames.timestamps[frame], det->bbox, matches[i].index, matches[i].score});
+                }
+
+                if (!m_running)
+                    break;
+            }
+        }
+        catch (...)
+        {
+            embedError = std::current_exception();
+        }
+
+        m_running = false;
+        frameQueue.close();
+        detectionQueue.close();
+        decoder.join();
+        detector.join();
+
+        for (auto error : {embedError, detectError, decodeError})
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    }
+
+} // namespace reid
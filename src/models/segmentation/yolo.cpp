@@ -1,37 +1,12 @@
-#include <opencv2/dnn.hpp>
+#include <utils/nms.hpp>
 #include <utils/detection_utils.hpp>
 #include <models/segmentation/yolo.hpp>
 
 namespace seg
 {
-    bool Yolo::preprocess(const cv::Mat &srcImg, cv::Mat &dstImg)
+    std::vector<Detection> decodeYolo(const float *output0, const float *protos, int numChannels, int numAnchors,
+                                      int numMasks, int maskHeight, int maskWidth, const cv::Size2f &inputSize, const YoloConfig &config)
     {
-        const auto &inputDims = engine->getInputDims();
-        assert(inputDims.size() == 1);
-
-        cv::Size size(inputDims[0].d[2], inputDims[0].d[1]);
-
-        cv::cvtColor(srcImg, dstImg, cv::COLOR_BGR2RGB);
-        cv::resize(dstImg, dstImg, size, 0, 0, cv::INTER_LINEAR);
-        dstImg.convertTo(dstImg, CV_32FC3, 1.f / 255.f);
-        return !dstImg.empty();
-    }
-
-    std::vector<Detection> Yolo::postprocess(const trt::MultiOutput &engineOutputs)
-    {
-        const auto &inputDims = engine->getInputDims();
-        const auto &outputDims = engine->getOutputDims();
-        assert(outputDims.size() == 2);
-
-        cv::Size2f size(inputDims[0].d[2], inputDims[0].d[1]);
-
-        auto numChannels = outputDims[0].d[1];
-        auto numAnchors = outputDims[0].d[2];
-
-        auto numMasks = outputDims[1].d[1];
-        auto maskHeight = outputDims[1].d[2];
-        auto maskWidth = outputDims[1].d[3];
-
         auto numClasses = numChannels - numMasks - 4; // 4 bbox
 
         std::vector<cv::Rect2d> bboxes;
@@ -46,12 +21,12 @@ namespace seg
         std::vector<cv::Mat> maskWeights;
         maskWeights.reserve(numAnchors);
 
-        cv::Mat output0 = cv::Mat(numChannels, numAnchors, CV_32F, const_cast<float *>(engineOutputs[0].data())).t();
-        cv::Mat output1 = cv::Mat(numMasks, maskHeight * maskWidth, CV_32F, const_cast<float *>(engineOutputs[1].data()));
+        cv::Mat predictions = cv::Mat(numChannels, numAnchors, CV_32F, const_cast<float *>(output0)).t();
+        cv::Mat prototypes = cv::Mat(numMasks, maskHeight * maskWidth, CV_32F, const_cast<float *>(protos));
 
         for (auto i = 0; i < numAnchors; i++)
         {
-            auto rowPtr = output0.row(i).ptr<float>();
+            auto rowPtr = predictions.row(i).ptr<float>();
             auto bboxesPtr = rowPtr;
             auto scoresPtr = rowPtr + 4;
             auto maskWeightsPtr = scoresPtr + numClasses;
@@ -68,10 +43,10 @@ namespace seg
             float wn = *bboxesPtr++;
             float hn = *bboxesPtr++;
 
-            float x = std::clamp((xn - 0.5f * wn) / size.width, 0.f, 1.f);
-            float y = std::clamp((yn - 0.5f * hn) / size.height, 0.f, 1.f);
-            float w = std::clamp(wn / size.width, 0.f, 1.f);
-            float h = std::clamp(hn / size.height, 0.f, 1.f);
+            float x = std::clamp((xn - 0.5f * wn) / inputSize.width, 0.f, 1.f);
+            float y = std::clamp((yn - 0.5f * hn) / inputSize.height, 0.f, 1.f);
+            float w = std::clamp(wn / inputSize.width, 0.f, 1.f);
+            float h = std::clamp(hn / inputSize.height, 0.f, 1.f);
 
             cv::Mat maskWeight = cv::Mat(1, numMasks, CV_32F, maskWeightsPtr);
 
@@ -83,7 +58,8 @@ namespace seg
 
         // Non Maximum Suppression
         std::vector<int> indices;
-        cv::dnn::NMSBoxes(bboxes, scores, config.confidenceThreshold, config.nmsThreshold, indices, config.nmsEta, config.topK);
+        std::vector<int> candidates;
+        trt::nmsBoxes(bboxes, scores, config.confidenceThreshold, config.nmsThreshold, indices, candidates, config.nmsEta, config.topK);
 
         // Fill output detections
         std::vector<Detection> detections;
@@ -95,7 +71,7 @@ namespace seg
         for (auto &idx : indices)
         {
             maskWeightsToKeep.push_back(maskWeights[idx]);
-            detections.emplace_back(Detection{class_ids[idx], scores[idx], bboxes[idx], getClassName(class_ids[idx])});
+            detections.emplace_back(Detection{class_ids[idx], scores[idx], bboxes[idx], getClassName(config, class_ids[idx])});
         }
 
         // Process masks
@@ -103,7 +79,7 @@ namespace seg
         {
             cv::Mat masks;
             cv::vconcat(maskWeightsToKeep, masks);
-            cv::Mat maskWeightMap = (masks * output1).t();
+            cv::Mat maskWeightMap = (masks * prototypes).t();
 
             cv::Mat maskScoreMap;
             cv::exp(-maskWeightMap, maskScoreMap);
@@ -133,4 +109,15 @@ namespace seg
         return detections;
     }
 
+    std::vector<Detection> Yolo::postprocess(const trt::MultiOutput &engineOutputs)
+    {
+        const auto &inputDims = engine->getInputDims();
+        const auto &outputDims = engine->getOutputDims();
+        assert(outputDims.size() == 2);
+
+        cv::Size2f size(inputDims[0].d[2], inputDims[0].d[1]);
+        return decodeYolo(engineOutputs[0].data(), engineOutputs[1].data(), outputDims[0].d[1], outputDims[0].d[2],
+                          outputDims[1].d[1], outputDims[1].d[2], outputDims[1].d[3], size, config);
+    }
+
 }
\ No newline at end of file
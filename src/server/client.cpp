@@ -0,0 +1,188 @@
+#include <atomic>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server/client.hpp"
+
+namespace server
+{
+
+    RemoteDetector::RemoteDetector(const RemoteConfig &config) : m_config(config)
+    {
+        if (m_config.slots <= 0 || m_config.slotSize == 0)
+        {
+            throw std::invalid_argument("Invalid shared memory ring size");
+        }
+
+        // Connect to the server
+        m_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, m_config.socketPath.c_str(), sizeof(address.sun_path) - 1);
+        if (m_socket < 0 || ::connect(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            if (m_socket >= 0)
+                ::close(m_socket);
+            throw std::runtime_error("Could not connect to inference server " + m_config.socketPath);
+        }
+
+        // Frame ring, owned by the client
+        static std::atomic<int> counter{0};
+        std::string name = "/tensorrt-vision-" + std::to_string(::getpid()) + "-" + std::to_string(counter++);
+        m_memory = std::make_unique<SharedMemory>(name, m_config.slots * m_config.slotSize, true);
+
+        Hello hello{};
+        std::strncpy(hello.shmName, name.c_str(), sizeof(hello.shmName) - 1);
+        hello.slots = static_cast<uint32_t>(m_config.slots);
+        hello.slotSize = m_config.slotSize;
+
+        MessageHeader header{};
+        std::string payload;
+        if (!sendMessage(m_socket, MessageType::HELLO, &hello, sizeof(hello)) ||
+            !receiveMessage(m_socket, header, payload) ||
+            header.type != MessageType::WELCOME)
+        {
+            ::close(m_socket);
+            throw std::runtime_error("Inference server refused connection: " + payload);
+        }
+
+        // The server holds its own mapping now
+        m_memory->unlink();
+
+        auto welcome = nlohmann::json::parse(payload);
+        if (welcome.contains("class_names"))
+            m_classNames = welcome["class_names"].get<std::vector<std::string>>();
+    }
+
+    RemoteDetector::~RemoteDetector()
+    {
+        if (m_socket >= 0)
+            ::close(m_socket);
+    }
+
+    std::vector<Detection> RemoteDetector::process(const cv::Mat &frame)
+    {
+        if (frame.empty())
+        {
+            throw std::invalid_argument("Input image is empty");
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sendFrame(frame, 0);
+        return receiveDetections(m_sequence - 1);
+    }
+
+    std::vector<std::vector<Detection>> RemoteDetector::process(const std::vector<cv::Mat> &frames)
+    {
+        std::vector<std::vector<Detection>> detections;
+        detections.reserve(frames.size());
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const size_t slots = static_cast<size_t>(m_config.slots);
+        for (size_t i = 0; i < frames.size(); i += slots)
+        {
+            // Fill the ring, then collect the results, so that the server can batch the frames together
+            const size_t count = std::min(slots, frames.size() - i);
+            const uint64_t first = m_sequence;
+            for (size_t j = 0; j < count; ++j)
+            {
+                if (frames[i + j].empty())
+                {
+                    throw std::invalid_argument("Input image is empty");
+                }
+                sendFrame(frames[i + j], static_cast<uint32_t>(j));
+            }
+            // Always drain every response, so that a failed frame does not desynchronize the next call
+            std::exception_ptr error = nullptr;
+            for (size_t j = 0; j < count; ++j)
+            {
+                try
+                {
+                    detections.push_back(receiveDetections(first + j));
+                }
+                catch (...)
+                {
+                    error = error ? error : std::current_exception();
+                }
+            }
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+        return detections;
+    }
+
+    void RemoteDetector::sendFrame(const cv::Mat &frame, uint32_t slot)
+    {
+        const size_t rowSize = frame.cols * frame.elemSize();
+        if (rowSize * frame.rows > m_config.slotSize)
+        {
+            throw std::runtime_error("Frame does not fit in a shared memory slot, increase slot_size");
+        }
+
+        // Pack the frame rows into the slot
+        uint8_t *dst = m_memory->data() + slot * m_config.slotSize;
+        if (frame.isContinuous())
+        {
+            std::memcpy(dst, frame.data, rowSize * frame.rows);
+        }
+        else
+        {
+            for (int row = 0; row < frame.rows; ++row)
+            {
+                std::memcpy(dst + row * rowSize, frame.ptr(row), rowSize);
+            }
+        }
+
+        FrameRequest request{m_sequence++, slot, frame.rows, frame.cols, frame.type(), rowSize};
+        if (!sendMessage(m_socket, MessageType::REQUEST, &request, sizeof(request)))
+        {
+            throw std::runtime_error("Lost connection to inference server");
+        }
+    }
+
+    std::vector<Detection> RemoteDetector::receiveDetections(uint64_t sequence)
+    {
+        MessageHeader header{};
+        std::string payload;
+        if (!receiveMessage(m_socket, header, payload))
+        {
+            throw std::runtime_error("Lost connection to inference server");
+        }
+        if (header.type == MessageType::ERROR)
+        {
+            throw std::runtime_error("Inference server error: " + payload);
+        }
+
+        FrameResponse response{};
+        if (header.type != MessageType::RESPONSE || payload.size() < sizeof(response))
+        {
+            throw std::runtime_error("Unexpected message from inference server");
+        }
+        std::memcpy(&response, payload.data(), sizeof(response));
+        if (response.sequence != sequence || payload.size() != sizeof(response) + response.count * sizeof(CompactDetection))
+        {
+            throw std::runtime_error("Out of sequence response from inference server");
+        }
+
+        std::vector<Detection> detections;
+        detections.reserve(response.count);
+        const char *data = payload.data() + sizeof(response);
+        for (uint32_t i = 0; i < response.count; ++i)
+        {
+            CompactDetection compact{};
+            std::memcpy(&compact, data + i * sizeof(compact), sizeof(compact));
+
+            Detection det;
+            det.class_id = compact.classId;
+            det.confidence = compact.confidence;
+            det.bbox = cv::Rect2d(compact.x, compact.y, compact.width, compact.height);
+            det.class_name = getClassName(compact.classId);
+            detections.push_back(std::move(det));
+        }
+        return detections;
+    }
+
+} // namespace server
@@ -0,0 +1,138 @@
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "server/protocol.hpp"
+
+namespace server
+{
+    namespace
+    {
+        bool sendAll(int fd, const void *data, size_t size)
+        {
+            const auto *bytes = static_cast<const char *>(data);
+            while (size > 0)
+            {
+                ssize_t sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+                if (sent < 0 && errno == EINTR)
+                    continue;
+                if (sent <= 0)
+                    return false;
+                bytes += sent;
+                size -= static_cast<size_t>(sent);
+            }
+            return true;
+        }
+
+        bool receiveAll(int fd, void *data, size_t size)
+        {
+            auto *bytes = static_cast<char *>(data);
+            while (size > 0)
+            {
+                ssize_t received = ::recv(fd, bytes, size, 0);
+                if (received < 0 && errno == EINTR)
+                    continue;
+                if (received <= 0)
+                    return false;
+                bytes += received;
+                size -= static_cast<size_t>(received);
+            }
+            return true;
+        }
+
+        size_t maxPayloadSize(MessageType type)
+        {
+            switch (type)
+            {
+            case MessageType::HELLO:
+                return sizeof(Hello);
+            case MessageType::WELCOME:
+                return MAX_WELCOME_SIZE;
+            case MessageType::REQUEST:
+                return sizeof(FrameRequest);
+            case MessageType::RESPONSE:
+                return sizeof(FrameResponse) + MAX_RESPONSE_DETECTIONS * sizeof(CompactDetection);
+            case MessageType::ERROR:
+                return MAX_ERROR_SIZE;
+            }
+            return 0;
+        }
+    } // namespace
+
+    bool sendMessage(int fd, MessageType type, const void *payload, size_t size)
+    {
+        MessageHeader header{type, static_cast<uint32_t>(size)};
+        return sendAll(fd, &header, sizeof(header)) && sendAll(fd, payload, size);
+    }
+
+    bool receiveMessage(int fd, MessageHeader &header, std::string &payload)
+    {
+        if (!receiveAll(fd, &header, sizeof(header)))
+        {
+            return false;
+        }
+        if (header.size > maxPayloadSize(header.type))
+        {
+            return false;
+        }
+        payload.resize(header.size);
+        return receiveAll(fd, payload.data(), payload.size());
+    }
+
+    SharedMemory::SharedMemory(const std::string &name, size_t size, bool create)
+        : m_name(name), m_size(size), m_owner(create)
+    {
+        int flags = create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR;
+        int fd = ::shm_open(name.c_str(), flags, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Could not open shared memory " + name);
+        }
+
+        if (create && ::ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("Could not allocate shared memory " + name);
+        }
+
+        // Pages past the end of an existing object would fault on access
+        struct stat info{};
+        if (!create && (::fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < size))
+        {
+            ::close(fd);
+            throw std::runtime_error("Shared memory " + name + " is smaller than requested");
+        }
+
+        void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            if (create)
+                ::shm_unlink(name.c_str());
+            throw std::runtime_error("Could not map shared memory " + name);
+        }
+        m_data = static_cast<uint8_t *>(data);
+    }
+
+    SharedMemory::~SharedMemory()
+    {
+        if (m_data)
+            ::munmap(m_data, m_size);
+        if (m_owner)
+            unlink();
+    }
+
+    void SharedMemory::unlink()
+    {
+        if (m_owner)
+        {
+            ::shm_unlink(m_name.c_str());
+            m_owner = false;
+        }
+    }
+
+} // namespace server
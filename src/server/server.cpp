@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "engine/logger.hpp"
+#include "server/server.hpp"
+
+namespace server
+{
+
+    struct InferenceServer::Client
+    {
+        int fd = -1;
+        std::unique_ptr<SharedMemory> memory = nullptr;
+        uint32_t slots = 0;
+        uint64_t slotSize = 0;
+        std::mutex writeMutex;
+
+        ~Client()
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+
+        bool send(MessageType type, const void *payload, size_t size)
+        {
+            std::lock_guard<std::mutex> lock(writeMutex);
+            return sendMessage(fd, type, payload, size);
+        }
+
+        bool sendError(const std::string &message)
+        {
+            return send(MessageType::ERROR, message.data(), std::min<size_t>(message.size(), MAX_ERROR_SIZE));
+        }
+    };
+
+    InferenceServer::InferenceServer(std::unique_ptr<trt::DetectionProcessor> processor,
+                                     std::vector<std::string> classNames,
+                                     size_t maxBatchSize,
+                                     std::chrono::microseconds batchTimeout)
+        : m_processor(std::move(processor)),
+          m_classNames(std::move(classNames)),
+          m_maxBatchSize(std::max<size_t>(1, maxBatchSize)),
+          m_batchTimeout(batchTimeout)
+    {
+    }
+
+    InferenceServer::~InferenceServer() = default;
+
+    void InferenceServer::serve(const std::string &socketPath, const std::atomic<bool> &running)
+    {
+        auto logger = trt::NvLogger::getLogger();
+
+        int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        ::unlink(socketPath.c_str());
+        if (listener < 0 ||
+            ::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listener, SOMAXCONN) != 0)
+        {
+            if (listener >= 0)
+                ::close(listener);
+            throw std::runtime_error("Could not listen on " + socketPath);
+        }
+        logger->info("Inference server listening on {}", socketPath);
+
+        m_stopped = false;
+        std::thread inferenceThread(&InferenceServer::inferenceLoop, this);
+
+        // I/O loop: accept clients and queue their requests
+        std::vector<std::shared_ptr<Client>> clients;
+        std::vector<pollfd> fds;
+        while (running)
+        {
+            fds.clear();
+            fds.push_back({listener, POLLIN, 0});
+            for (const auto &client : clients)
+            {
+                fds.push_back({client->fd, POLLIN, 0});
+            }
+
+            if (::poll(fds.data(), fds.size(), 100) <= 0)
+                continue;
+
+            if (fds[0].revents & POLLIN)
+            {
+                int fd = ::accept(listener, nullptr, nullptr);
+                if (fd >= 0)
+                {
+                    auto client = std::make_shared<Client>();
+                    client->fd = fd;
+                    clients.push_back(client);
+                }
+            }
+
+            for (size_t i = 1; i < fds.size(); ++i)
+            {
+                if (!fds[i].revents)
+                    continue;
+                handleMessage(clients[i - 1]);
+            }
+
+            // Forget disconnected clients, pending requests keep their shared memory alive
+            clients.erase(std::remove_if(clients.begin(), clients.end(), [](const auto &client)
+                                         { return client->fd < 0; }),
+                          clients.end());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cond.notify_all();
+        inferenceThread.join();
+
+        ::close(listener);
+        ::unlink(socketPath.c_str());
+    }
+
+    void InferenceServer::handleMessage(const std::shared_ptr<Client> &client)
+    {
+        MessageHeader header{};
+        std::string payload;
+        if (!receiveMessage(client->fd, header, payload))
+        {
+            std::lock_guard<std::mutex> lock(client->writeMutex);
+            ::close(client->fd);
+            client->fd = -1;
+            return;
+        }
+
+        switch (header.type)
+        {
+        case MessageType::HELLO:
+        {
+            Hello hello{};
+            if (payload.size() != sizeof(hello))
+                break;
+            std::memcpy(&hello, payload.data(), sizeof(hello));
+            hello.shmName[sizeof(hello.shmName) - 1] = '\0';
+            if (hello.slots == 0 || hello.slotSize == 0 || hello.slotSize > SIZE_MAX / hello.slots)
+                break;
+
+            try
+            {
+                client->memory = std::make_unique<SharedMemory>(hello.shmName, hello.slots * hello.slotSize, false);
+                client->slots = hello.slots;
+                client->slotSize = hello.slotSize;
+            }
+            catch (const std::exception &e)
+            {
+                client->sendError(e.what());
+                return;
+            }
+
+            nlohmann::json welcome = {{"class_names", m_classNames}, {"max_batch_size", m_maxBatchSize}};
+            std::string data = welcome.dump();
+            client->send(MessageType::WELCOME, data.data(), data.size());
+            return;
+        }
+        case MessageType::REQUEST:
+        {
+            FrameRequest request{};
+            if (payload.size() != sizeof(request) || !client->memory)
+                break;
+            std::memcpy(&request, payload.data(), sizeof(request));
+
+            // BGR frames only, with rows that hold the pixels and all fit in the slot
+            if (request.slot >= client->slots || request.type != CV_8UC3 || request.rows <= 0 || request.cols <= 0 ||
+                request.step < static_cast<uint64_t>(request.cols) * CV_ELEM_SIZE(CV_8UC3) ||
+                request.step > client->slotSize / static_cast<uint64_t>(request.rows))
+                break;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_requests.push_back({client, request});
+            }
+            m_cond.notify_one();
+            return;
+        }
+        default:
+            break;
+        }
+
+        client->sendError("Invalid request");
+    }
+
+    void InferenceServer::inferenceLoop()
+    {
+        std::vector<Request> batch;
+        std::vector<cv::Mat> frames;
+        std::vector<CompactDetection> compact;
+        std::string payload;
+
+        while (true)
+        {
+            batch.clear();
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this]
+                            { return !m_requests.empty() || m_stopped; });
+                if (m_stopped)
+                    break;
+
+                // Give other clients a short window to fill the batch
+                m_cond.wait_for(lock, m_batchTimeout, [this]
+                                { return m_requests.size() >= m_maxBatchSize || m_stopped; });
+
+                while (!m_requests.empty() && batch.size() < m_maxBatchSize)
+                {
+                    batch.push_back(std::move(m_requests.front()));
+                    m_requests.pop_front();
+                }
+            }
+
+            // Zero-copy views over the client rings, a request whose frame cannot be viewed is answered alone
+            frames.clear();
+            size_t valid = 0;
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                const auto &frame = batch[i].frame;
+                try
+                {
+                    uint8_t *data = batch[i].client->memory->data() + frame.slot * batch[i].client->slotSize;
+                    frames.emplace_back(frame.rows, frame.cols, frame.type, data, frame.step);
+                }
+                catch (const std::exception &e)
+                {
+                    batch[i].client->sendError(e.what());
+                    continue;
+                }
+                if (valid != i)
+                    batch[valid] = std::move(batch[i]);
+                ++valid;
+            }
+            batch.resize(valid);
+            if (batch.empty())
+                continue;
+
+            std::vector<std::vector<Detection>> detections;
+            try
+            {
+                detections = m_processor->process(frames);
+            }
+            catch (const std::exception &e)
+            {
+                for (const auto &request : batch)
+                {
+                    request.client->sendError(e.what());
+                }
+                continue;
+            }
+
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                // Detections past the response limit are dropped
+                compact.clear();
+                for (const auto &det : detections[i])
+                {
+                    if (compact.size() == MAX_RESPONSE_DETECTIONS)
+                        break;
+                    compact.push_back({static_cast<float>(det.bbox.x),
+                                       static_cast<float>(det.bbox.y),
+                                       static_cast<float>(det.bbox.width),
+                                       static_cast<float>(det.bbox.height),
+                                       det.confidence,
+                                       det.class_id});
+                }
+
+                FrameResponse response{batch[i].frame.sequence, static_cast<uint32_t>(compact.size()), 0};
+                payload.assign(reinterpret_cast<const char *>(&response), sizeof(response));
+                payload.append(reinterpret_cast<const char *>(compact.data()), compact.size() * sizeof(CompactDetection));
+                batch[i].client->send(MessageType::RESPONSE, payload.data(), payload.size());
+            }
+        }
+    }
+
+} // namespace server
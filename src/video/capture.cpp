@@ -0,0 +1,116 @@
+#include "video/capture.hpp"
+#include "metrics/trace.hpp"
+
+namespace video
+{
+
+    bool openSource(cv::VideoCapture &capture, const std::string &source)
+    {
+        if (source.size() == 1 && std::isdigit(source[0]))
+        {
+            return capture.open(std::stoi(source));
+        }
+        return capture.open(source);
+    }
+
+    LatestFrameCapture::LatestFrameCapture(cv::VideoCapture &capture) : m_capture(capture)
+    {
+        if (!m_capture.isOpened())
+        {
+            throw std::invalid_argument("Video capture is not opened");
+        }
+
+        // Hint the backend to keep its own queue as short as possible
+        m_capture.set(cv::CAP_PROP_BUFFERSIZE, 1);
+        m_thread = std::thread(&LatestFrameCapture::grabLoop, this);
+    }
+
+    LatestFrameCapture::~LatestFrameCapture()
+    {
+        release();
+    }
+
+    void LatestFrameCapture::release()
+    {
+        m_running = false;
+        m_cond.notify_all();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    bool LatestFrameCapture::read(cv::Mat &image)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this]
+                    { return m_hasFrame || m_finished || !m_running; });
+
+        if (!m_hasFrame)
+        {
+            return false;
+        }
+
+        image = std::move(m_latest);
+        m_latest = cv::Mat();
+        m_hasFrame = false;
+        return true;
+    }
+
+    bool LatestFrameCapture::tryRead(cv::Mat &image)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_hasFrame)
+        {
+            return false;
+        }
+
+        image = std::move(m_latest);
+        m_latest = cv::Mat();
+        m_hasFrame = false;
+        return true;
+    }
+
+    bool LatestFrameCapture::isFinished()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_finished && !m_hasFrame;
+    }
+
+    void LatestFrameCapture::grabLoop()
+    {
+        metrics::Tracer::setThreadName("capture");
+        while (m_running)
+        {
+            // Decode into a fresh buffer, the previous one may still be in use by the reader
+            cv::Mat image;
+            {
+                metrics::TraceSpan span("decode", nullptr, static_cast<int64_t>(m_grabbed));
+                if (!m_capture.read(image) || image.empty())
+                {
+                    break;
+                }
+            }
+            ++m_grabbed;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_hasFrame)
+                {
+                    // The reader did not pick up the previous frame in time
+                    ++m_dropped;
+                }
+                m_latest = std::move(image);
+                m_hasFrame = true;
+            }
+            m_cond.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished = true;
+        }
+        m_cond.notify_all();
+    }
+
+} // namespace video
@@ -0,0 +1,97 @@
+#include <thread>
+#include "video/multi_source.hpp"
+
+namespace video
+{
+
+    MultiSourceCapture::MultiSourceCapture(const std::vector<std::string> &sources) : m_sources(sources)
+    {
+        if (sources.empty())
+        {
+            throw std::invalid_argument("No video source provided");
+        }
+
+        m_processed.resize(sources.size(), 0);
+        for (const auto &source : sources)
+        {
+            auto capture = std::make_unique<cv::VideoCapture>();
+            if (!openSource(*capture, source))
+            {
+                throw std::runtime_error("Could not open video source " + source);
+            }
+
+            // Query the stream properties before the grab thread takes over the capture
+            m_fps.push_back(capture->get(cv::CAP_PROP_FPS));
+            m_frameSizes.emplace_back(capture->get(cv::CAP_PROP_FRAME_WIDTH),
+                                      capture->get(cv::CAP_PROP_FRAME_HEIGHT));
+            m_captures.push_back(std::move(capture));
+        }
+
+        for (auto &capture : m_captures)
+        {
+            m_grabbers.push_back(std::make_unique<LatestFrameCapture>(*capture));
+        }
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    MultiSourceCapture::~MultiSourceCapture()
+    {
+        release();
+    }
+
+    void MultiSourceCapture::release()
+    {
+        for (auto &grabber : m_grabbers)
+        {
+            grabber->release();
+        }
+        for (auto &capture : m_captures)
+        {
+            if (capture->isOpened())
+                capture->release();
+        }
+    }
+
+    bool MultiSourceCapture::gather(std::vector<SourceFrame> &batch)
+    {
+        batch.clear();
+        while (true)
+        {
+            // Every source contributes at most one frame per batch, which keeps streams fair
+            bool finished = true;
+            for (size_t i = 0; i < m_grabbers.size(); ++i)
+            {
+                cv::Mat image;
+                if (m_grabbers[i]->tryRead(image))
+                {
+                    batch.push_back({i, std::move(image)});
+                    ++m_processed[i];
+                }
+                finished = finished && m_grabbers[i]->isFinished();
+            }
+
+            if (!batch.empty())
+                return true;
+            if (finished)
+                return false;
+
+            // Sources run at camera rate, polling at 1 ms keeps the added latency negligible
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::vector<SourceStats> MultiSourceCapture::getStats() const
+    {
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+
+        std::vector<SourceStats> stats(m_sources.size());
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            stats[i].processed = m_processed[i];
+            stats[i].dropped = m_grabbers[i]->getDroppedFrames();
+            stats[i].fps = elapsed > 0.0 ? static_cast<double>(m_processed[i]) / elapsed : 0.0;
+        }
+        return stats;
+    }
+
+} // namespace video
@@ -0,0 +1,192 @@
+#include <thread>
+#include "video/segmented.hpp"
+#include "utils/bounded_queue.hpp"
+
+namespace video
+{
+
+    struct SegmentedVideoProcessor::Worker
+    {
+        explicit Worker(size_t queueSize) : results(queueSize) {};
+
+        size_t index = 0;
+        VideoSegment segment{};
+        cv::VideoCapture *capture = nullptr;
+
+        // Closed by the worker once its segment is done, the error is set before
+        trt::BoundedQueue<io::FrameResult> results;
+        std::exception_ptr error = nullptr;
+    };
+
+    SegmentedVideoProcessor::SegmentedVideoProcessor(const std::string &path, size_t numSegments, size_t batchSize, size_t queueSize)
+        : m_batchSize(std::max<size_t>(1, batchSize)), m_queueSize(std::max<size_t>(1, queueSize))
+    {
+        auto capture = std::make_unique<cv::VideoCapture>(path);
+        if (!capture->isOpened())
+        {
+            throw std::runtime_error("Could not open video source " + path);
+        }
+
+        const auto frameCount = static_cast<int64_t>(capture->get(cv::CAP_PROP_FRAME_COUNT));
+        m_segments.push_back({0, -1});
+        m_captures.push_back(std::move(capture));
+
+        // The frame count is unknown for streams, those are processed as a single segment
+        for (size_t i = 1; i < numSegments && frameCount > 0; ++i)
+        {
+            capture = std::make_unique<cv::VideoCapture>(path);
+            if (!capture->isOpened())
+            {
+                throw std::runtime_error("Could not open video source " + path);
+            }
+
+            // The backend seeks to the closest keyframe and decodes up to the requested frame,
+            // the position it reports back is where this segment actually starts
+            const auto target = frameCount * static_cast<int64_t>(i) / static_cast<int64_t>(numSegments);
+            capture->set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(target));
+            const auto begin = static_cast<int64_t>(capture->get(cv::CAP_PROP_POS_FRAMES));
+            if (begin <= m_segments.back().begin || begin >= frameCount)
+            {
+                continue;
+            }
+
+            m_segments.back().end = begin;
+            m_segments.push_back({begin, -1});
+            m_captures.push_back(std::move(capture));
+        }
+    }
+
+    SegmentedVideoProcessor::~SegmentedVideoProcessor()
+    {
+        for (auto &capture : m_captures)
+        {
+            if (capture->isOpened())
+                capture->release();
+        }
+    }
+
+    void SegmentedVideoProcessor::run(const BatchProcessorFactory &factory, const ResultCallback &callback)
+    {
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < m_segments.size(); ++i)
+        {
+            auto worker = std::make_unique<Worker>(m_queueSize);
+            worker->index = i;
+            worker->segment = m_segments[i];
+            worker->capture = m_captures[i].get();
+            workers.push_back(std::move(worker));
+        }
+        for (auto &worker : workers)
+        {
+            threads.emplace_back(&SegmentedVideoProcessor::processSegment, this, std::ref(*worker), std::cref(factory));
+        }
+
+        // Merge: drain segments one after the other, which restores the frame order.
+        // Once stopped, the queues are closed so that blocked workers exit.
+        std::exception_ptr error = nullptr;
+        auto closeAll = [&workers]()
+        {
+            for (auto &worker : workers)
+                worker->results.close();
+        };
+        for (auto &worker : workers)
+        {
+            while (auto result = worker->results.pop())
+            {
+                if (!m_running)
+                {
+                    closeAll();
+                    continue;
+                }
+
+                try
+                {
+                    callback(std::move(*result));
+                }
+                catch (...)
+                {
+                    error = error ? error : std::current_exception();
+                    stop();
+                }
+            }
+            error = error ? error : worker->error;
+            if (error)
+            {
+                stop();
+            }
+            if (!m_running)
+            {
+                closeAll();
+            }
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void SegmentedVideoProcessor::processSegment(Worker &worker, const BatchProcessorFactory &factory)
+    {
+        try
+        {
+            // Each worker owns its backend instance
+            auto processor = factory(worker.index);
+
+            std::vector<cv::Mat> frames(m_batchSize);
+            std::vector<cv::Mat> batch;
+            std::vector<double> timestamps;
+            batch.reserve(m_batchSize);
+            timestamps.reserve(m_batchSize);
+
+            int64_t frameIndex = worker.segment.begin;
+            bool finished = false;
+            while (m_running && !finished)
+            {
+                batch.clear();
+                timestamps.clear();
+                while (batch.size() < m_batchSize)
+                {
+                    const int64_t index = frameIndex + static_cast<int64_t>(batch.size());
+                    if (worker.segment.end >= 0 && index >= worker.segment.end)
+                    {
+                        finished = true;
+                        break;
+                    }
+
+                    cv::Mat &frame = frames[batch.size()];
+                    if (!worker.capture->read(frame) || frame.empty())
+                    {
+                        finished = true;
+                        break;
+                    }
+                    timestamps.push_back(worker.capture->get(cv::CAP_PROP_POS_MSEC));
+                    batch.push_back(frame);
+                }
+                if (batch.empty())
+                    break;
+
+                auto batchDetections = processor(batch);
+
+                // Blocks while the merge is behind, fails once the processor is stopped
+                for (size_t i = 0; i < batch.size() && !finished; ++i)
+                {
+                    finished = !worker.results.push({frameIndex++, timestamps[i], std::move(batchDetections[i])});
+                }
+            }
+        }
+        catch (...)
+        {
+            worker.error = std::current_exception();
+        }
+
+        worker.results.close();
+    }
+
+} // namespace video
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include <metrics/allocations.hpp>
+#include <models/detection/yolo.hpp>
+
+#include "support/synthetic.hpp"
+
+namespace
+{
+    // det::Yolo without an engine: the batch stages of its processor run on a synthetic output
+    class SyntheticYolo : public det::Yolo
+    {
+    public:
+        SyntheticYolo(const det::YoloConfig &config, const cv::Size &inputSize, const testing::SyntheticOutput &output, bool pad)
+            : det::Yolo("synthetic_yolo", config, inputSize, output.rows, output.cols), featureBatch{output.data}
+        {
+            preprocessing.scaleFill = !pad;
+        }
+
+        const std::vector<cv::Mat> &runPreprocess(const std::vector<cv::Mat> &frames) { return preprocessBatch(frames, {}); }
+        std::vector<std::vector<Detection>> runPostprocess() { return postprocessBatch(featureBatch); }
+
+    private:
+        const std::vector<trt::SingleOutput> featureBatch;
+    };
+
+    struct Counts
+    {
+        uint64_t preprocess = 0;
+        uint64_t resize = 0;
+        uint64_t postprocess = 0;
+    };
+} // namespace
+
+// The batch-1 detect path of det::Yolo on the CPU (its preprocessing and postprocessing stages, with the default
+// letterbox stretching the frame and with a padded one) must not allocate once warm. Allowed are the scratch buffers of cv::resize, measured alone, and the
+// detections returned: the batch and the detections of each frame.
+int main()
+{
+    if constexpr (!metrics::ALLOCATION_TRACKING)
+    {
+        std::cerr << "Error: allocation tracking is disabled, build with -Dalloc_tracking=true" << std::endl;
+        return 77; // skipped
+    }
+
+    constexpr int WARMUP = 3;
+    constexpr int ITERATIONS = 20;
+    const cv::Size inputSize(640, 640);
+
+    // Serial OpenCV loops, the thread pool allocates its jobs on the calling thread
+    cv::setNumThreads(1);
+
+    det::YoloConfig config;
+    testing::OutputGenerator generator(42, cv::Size2f(inputSize), config.confidenceThreshold);
+    const std::vector<cv::Mat> frames = {generator.frame({1920, 1080})};
+    const auto output = generator.yolo(80, 8400, 0.01);
+
+    bool failed = false;
+    for (bool pad : {false, true})
+    {
+        SyntheticYolo yolo(config, inputSize, output, pad);
+        const cv::Size resizedSize = pad ? cv::Size(640, 360) : inputSize;
+
+        cv::Mat rgb, resized;
+        cv::cvtColor(frames[0], rgb, cv::COLOR_BGR2RGB);
+
+        Counts counts;
+        std::vector<std::vector<Detection>> detections;
+        for (int i = 0; i < WARMUP + ITERATIONS; ++i)
+        {
+            const bool measured = i >= WARMUP;
+
+            auto start = metrics::getThreadAllocations();
+            const auto &tensors = yolo.runPreprocess(frames);
+            auto end = metrics::getThreadAllocations();
+            counts.preprocess += measured ? end.count - start.count : 0;
+            if (tensors.size() != 1 || tensors[0].size() != inputSize || tensors[0].type() != CV_32FC3)
+            {
+                std::cerr << "Error: unexpected input tensor" << std::endl;
+                return 1;
+            }
+
+            start = metrics::getThreadAllocations();
+            cv::resize(rgb, resized, resizedSize, 0, 0, cv::INTER_LINEAR);
+            end = metrics::getThreadAllocations();
+            counts.resize += measured ? end.count - start.count : 0;
+
+            start = metrics::getThreadAllocations();
+            detections = yolo.runPostprocess();
+            end = metrics::getThreadAllocations();
+            counts.postprocess += measured ? end.count - start.count : 0;
+        }
+
+        if (detections.size() != 1 || detections[0].empty())
+        {
+            std::cerr << "Error: no detection decoded" << std::endl;
+            return 1;
+        }
+
+        const uint64_t returned = ITERATIONS * 2;
+        std::cout << (pad ? "padded" : "stretched") << " letterbox, " << ITERATIONS << " iterations: "
+                  << counts.preprocess << " preprocessing allocations (" << counts.resize << " in cv::resize), "
+                  << counts.postprocess << " postprocessing allocations (" << returned << " returned)" << std::endl;
+        if (counts.preprocess > counts.resize || counts.postprocess > returned)
+        {
+            std::cerr << "Error: " << (pad ? "padded" : "stretched") << " letterbox allocates after warm-up" << std::endl;
+            failed = true;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Synthetic inputs and model outputs generated from a seed, shared by the tests and the benchmarks
+namespace testing
+{
+    // Raw model output with its layout
+    struct SyntheticOutput
+    {
+        std::vector<float> data{};
+        int rows = 0; // channels for YOLOv8/v11 [channels, anchors], anchors for YOLOv7 [anchors, channels]
+        int cols = 0;
+        std::vector<float> protos{}; // segmentation prototypes [masks, size, size]
+    };
+
+    // Anchors above the confidence threshold are jittered copies of a few objects, so that NMS has overlaps to
+    // suppress. The density is the fraction of anchors above the threshold.
+    class OutputGenerator
+    {
+    public:
+        OutputGenerator(uint32_t seed, const cv::Size2f &inputSize, float threshold)
+            : m_rng(seed), m_inputSize(inputSize), m_threshold(threshold) {};
+
+        // YOLOv8/v11 detection or segmentation output: [4 + classes + masks, anchors]
+        SyntheticOutput yolo(int numClasses, int numAnchors, double density, int numMasks = 0, int maskSize = 0)
+        {
+            const int numChannels = 4 + numClasses + numMasks;
+            SyntheticOutput output;
+            output.rows = numChannels;
+            output.cols = numAnchors;
+            output.data.resize(static_cast<size_t>(numChannels) * numAnchors);
+
+            generate(numClasses, numAnchors, density, [&](int anchor, int channel) -> float &
+                     { return output.data[static_cast<size_t>(channel) * numAnchors + anchor]; });
+
+            std::normal_distribution<float> weight(0.f, 0.5f);
+            for (int mask = 0; mask < numMasks; ++mask)
+                for (int anchor = 0; anchor < numAnchors; ++anchor)
+                    output.data[static_cast<size_t>(4 + numClasses + mask) * numAnchors + anchor] = weight(m_rng);
+
+            output.protos.resize(static_cast<size_t>(numMasks) * maskSize * maskSize);
+            for (auto &value : output.protos)
+                value = weight(m_rng);
+            return output;
+        }
+
+        // YOLOv7 output: [anchors, 5 + classes], the class score is multiplied by the objectness
+        SyntheticOutput yolov7(int numClasses, int numAnchors, double density)
+        {
+            const int numChannels = 5 + numClasses;
+            SyntheticOutput output;
+            output.rows = numAnchors;
+            output.cols = numChannels;
+            output.data.resize(static_cast<size_t>(numChannels) * numAnchors);
+
+            // Class scores are shifted by one channel, the objectness is set to 1 for objects
+            generate(numClasses, numAnchors, density, [&](int anchor, int channel) -> float &
+                     { return output.data[static_cast<size_t>(anchor) * numChannels + (channel < 4 ? channel : channel + 1)]; });
+            std::uniform_real_distribution<float> low(0.f, 0.5f);
+            for (int anchor = 0; anchor < numAnchors; ++anchor)
+            {
+                float *row = output.data.data() + static_cast<size_t>(anchor) * numChannels;
+                row[4] = *std::max_element(row + 5, row + numChannels) >= m_threshold ? 1.f : low(m_rng);
+            }
+            return output;
+        }
+
+        // Boxes and distinct scores, for NMS alone
+        void boxes(int count, std::vector<cv::Rect2d> &boxes, std::vector<float> &scores)
+        {
+            SyntheticOutput output = yolo(1, count, 1.0);
+            boxes.clear();
+            scores.clear();
+            for (int i = 0; i < count; ++i)
+            {
+                const float x = output.data[i], y = output.data[count + i];
+                const float w = output.data[2 * count + i], h = output.data[3 * count + i];
+                boxes.emplace_back((x - 0.5f * w) / m_inputSize.width, (y - 0.5f * h) / m_inputSize.height,
+                                   w / m_inputSize.width, h / m_inputSize.height);
+                scores.push_back(output.data[4 * count + i]);
+            }
+        }
+
+        // Noise image of a camera frame
+        cv::Mat frame(const cv::Size &size)
+        {
+            cv::Mat image(size, CV_8UC3);
+            cv::RNG rng(m_rng());
+            rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+            return image;
+        }
+
+        // Planar float image, as preprocessed for an engine
+        cv::Mat tensor(const cv::Size &size)
+        {
+            cv::Mat image(size, CV_32FC3);
+            cv::RNG rng(m_rng());
+            rng.fill(image, cv::RNG::UNIFORM, 0.f, 1.f);
+            return image;
+        }
+
+        // Classifier scores, a few classes above the threshold
+        std::vector<float> scores(int numClasses, int numAbove)
+        {
+            std::uniform_real_distribution<float> low(0.f, m_threshold * 0.9f);
+            std::uniform_real_distribution<float> high(m_threshold, 1.f);
+            std::vector<float> scores(numClasses);
+            for (auto &score : scores)
+                score = low(m_rng);
+            for (int i = 0; i < numAbove; ++i)
+                scores[m_rng() % numClasses] = high(m_rng);
+            return scores;
+        }
+
+    private:
+        template <typename Accessor>
+        void generate(int numClasses, int numAnchors, double density, Accessor at)
+        {
+            std::uniform_real_distribution<float> unit(0.f, 1.f);
+            std::uniform_real_distribution<float> low(0.f, m_threshold * 0.9f);
+            std::uniform_real_distribution<float> high(m_threshold, 1.f);
+            std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+
+            const int numPositives = static_cast<int>(density * numAnchors);
+            const int numObjects = std::max(1, numPositives / 8);
+
+            // Objects as center, size in input pixels
+            std::vector<cv::Vec4f> objects(numObjects);
+            std::vector<int> classes(numObjects);
+            for (int i = 0; i < numObjects; ++i)
+            {
+                const float w = (0.02f + 0.3f * unit(m_rng)) * m_inputSize.width;
+                const float h = (0.02f + 0.3f * unit(m_rng)) * m_inputSize.height;
+                objects[i] = {unit(m_rng) * m_inputSize.width, unit(m_rng) * m_inputSize.height, w, h};
+                classes[i] = static_cast<int>(m_rng() % numClasses);
+            }
+
+            std::vector<int> anchors(numAnchors);
+            for (int i = 0; i < numAnchors; ++i)
+                anchors[i] = i;
+            std::shuffle(anchors.begin(), anchors.end(), m_rng);
+
+            for (int rank = 0; rank < numAnchors; ++rank)
+            {
+                const int anchor = anchors[rank];
+                for (int c = 0; c < numClasses; ++c)
+                    at(anchor, 4 + c) = low(m_rng);
+
+                const bool positive = rank < numPositives;
+                const auto &object = objects[rank % numObjects];
+                for (int k = 0; k < 4; ++k)
+                {
+                    const float scale = k < 2 ? object[2 + k] : object[k];
+                    at(anchor, k) = positive ? object[k] + jitter(m_rng) * scale : unit(m_rng) * (k % 2 ? m_inputSize.height : m_inputSize.width);
+                }
+                if (positive)
+                    at(anchor, 4 + classes[rank % numObjects]) = high(m_rng);
+            }
+        }
+
+        std::mt19937 m_rng;
+        const cv::Size2f m_inputSize;
+        const float m_threshold;
+    };
+
+} // namespace testing